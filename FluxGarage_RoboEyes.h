@@ -1,837 +1,1021 @@
-/* * FluxGarage RoboEyes for OLED Displays V 1.0.1
- * Draws smoothly animated robot eyes on OLED displays, based on the Adafruit GFX
- * library's graphics primitives, such as rounded rectangles and triangles.
- * * Copyright (C) 2024 Dennis Hoelscher
- * www.fluxgarage.com
- * www.youtube.com/@FluxGarage
- *
- * This program is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY;
- * without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program.
- * If not, see <https://www.gnu.org/licenses/>.
- */
-
-
-#ifndef _FLUXGARAGE_ROBOEYES_H
-#define _FLUXGARAGE_ROBOEYES_H
-
-
-// Usage of monochrome display colors
-#define BGCOLOR 0 // background and overlays
-#define MAINCOLOR 1 // drawings
-
-// For mood type switch
-#define DEFAULT 0
-#define TIRED 1
-#define ANGRY 2
-#define HAPPY 3
-#define SLEEPY 4 // Added SLEEPY mood
-#define DIZZY 5 // Added DIZZY mood
-
-// For turning things on or off
-#define ON 1 // north, top center
-#define OFF 0 // north-east, top right
-
-// For switch "predefined positions"
-#define N 1 // east, middle right
-#define NE 2 // south-east, bottom right
-#define E 3 // south, bottom center
-#define SE 4 // south-west, bottom left
-#define S 5 // west, middle left
-#define SW 6 // north-west,
-#define W 7 // top left
-#define NW 8
-// for middle center set "DEFAULT"
-
-class roboEyes
-{
-private:
-
-// Yes, everything is currently still accessible. Be responsibly and don't mess things up :)
-
-public:
-
-// For general setup - screen size and max. frame rate
-int screenWidth = 128; // OLED display width, in pixels
-int screenHeight = 64; // OLED display height, in pixels
-int frameInterval = 20; // default value for 50 frames per second (1000/50 = 20 milliseconds)
-unsigned long fpsTimer = 0; // for timing the frames per second
-
-// For controlling mood types and expressions
-bool tired = 0;
-bool angry = 0; bool happy = 0;
-bool sleepy = 0; // Added sleepy state
-bool curious = 0; // if true, draw the outer eye larger when looking left or right
-bool cyclops = 0; // if true, draw only one eye
-bool eyeL_open = 0; // left eye opened or closed?
-bool eyeR_open = 0; // right eye opened or closed?
-
-
-// Dizzy mood variables
-bool dizzy = 0;
-unsigned long dizzyAnimationTimer = 0;
-int dizzyAnimationDuration = 2000; // Default dizzy duration in ms
-float dizzyAngle = 0.0;
-float dizzyRadius = 10.0; // Radius of the circular path
-int dizzyEyeCompactionWidth = 10; // How much eyes compact horizontally
-int dizzyEyeCompactionHeight = 10; // How much eyes compact vertically
-
-
-//*********************************************************************************************
-//     Eyes Geometry
-//*********************************************************************************************
-
-// EYE LEFT - size and border radius
-int eyeLwidthDefault = 36; int eyeLheightDefault = 36;
-int eyeLwidthCurrent = eyeLwidthDefault;
-int eyeLheightCurrent = 1; // start with closed eye, otherwise set to eyeLheightDefault
-int eyeLwidthNext = eyeLwidthDefault;
-int eyeLheightNext = eyeLheightDefault;
-int eyeLheightOffset = 0; // Border Radius
-byte eyeLborderRadiusDefault = 8;
-byte eyeLborderRadiusCurrent = eyeLborderRadiusDefault;
-byte eyeLborderRadiusNext = eyeLborderRadiusDefault; // EYE RIGHT - size and border radius
-int eyeRwidthDefault = eyeLwidthDefault;
-int eyeRheightDefault = eyeLheightDefault;
-int eyeRwidthCurrent = eyeRwidthDefault; int eyeRheightCurrent = 1; // start with closed eye, otherwise set to eyeRheightDefault
-int eyeRwidthNext = eyeRwidthDefault;
-int eyeRheightNext = eyeRheightDefault; int eyeRheightOffset = 0;
-// Border Radius
-byte eyeRborderRadiusDefault = 8;
-byte eyeRborderRadiusCurrent = eyeRborderRadiusDefault;
-byte eyeRborderRadiusNext = eyeRborderRadiusDefault; // EYE LEFT - Coordinates
-int eyeLxDefault = ((screenWidth)-(eyeLwidthDefault+spaceBetweenDefault+eyeRwidthDefault))/2;
-int eyeLyDefault = ((screenHeight-eyeLheightDefault)/2);
-int eyeLx = eyeLxDefault;
-int eyeLy = eyeLyDefault; int eyeLxNext = eyeLxDefault; // Initialize with default
-int eyeLyNext = eyeLyDefault; // Initialize with default
-
-// EYE RIGHT - Coordinates
-int eyeRxDefault = eyeLx+eyeLwidthCurrent+spaceBetweenDefault;
-int eyeRyDefault = eyeLy;
-int eyeRx = eyeRxDefault; int eyeRy = eyeRyDefault;
-int eyeRxNext = eyeRxDefault; // Initialize with default
-int eyeRyNext = eyeRyDefault; // Initialize with default
-
-// BOTH EYES
-// Eyelid top size
-byte eyelidsHeightMax = eyeLheightDefault/2; // top eyelids max height
-byte eyelidsTiredHeight = 0;
-byte eyelidsTiredHeightNext = eyelidsTiredHeight;
-byte eyelidsAngryHeight = 0;
-byte eyelidsAngryHeightNext = eyelidsAngryHeight; // Bottom happy eyelids offset
-byte eyelidsHappyBottomOffsetMax = (eyeLheightDefault/2)+3;
-byte eyelidsHappyBottomOffset = 0;
-byte eyelidsHappyBottomOffsetNext = 0; // Space between eyes
-int spaceBetweenDefault = 10;
-int spaceBetweenCurrent = spaceBetweenDefault;
-int spaceBetweenNext = 10; // Sleepy mode variables
-unsigned long sleepyAnimationTimer = 0;
-int sleepyInterval = 2; // Base interval for normal eye appearance in seconds
-int sleepyIntervalVariation = 3; // Variation range in seconds
-bool sleepyNormalEyes = false; // Flag to indicate if eyes should be briefly normal
-
-
-//*********************************************************************************************
-//     Macro Animations
-//*********************************************************************************************
-
-// Animation - horizontal flicker/shiver
-bool hFlicker = 0; bool hFlickerAlternate = 0;
-byte hFlickerAmplitude = 2;
-
-// Animation - vertical flicker/shiver
-bool vFlicker = 0;
-bool vFlickerAlternate = 0; byte vFlickerAmplitude = 10;
-
-// Animation - auto blinking
-bool autoblinker = 0; // activate auto blink animation
-int blinkInterval = 1; // basic interval between each blink in full seconds
-int blinkIntervalVariation = 4; // interval variaton range in full seconds, random number inside of given range will be add to the basic blinkInterval, set to 0 for no variation
-unsigned long blinktimer = 0; // for organising eyeblink timing
-
-// Animation - idle mode: eyes looking in random directions
-bool idle = 0; int idleInterval = 1; // basic interval between each eye repositioning in full seconds
-int idleIntervalVariation = 3; // interval variaton range in full seconds, random number inside of given range will be add to the basic idleInterval, set to 0 for no variation
-unsigned long idleAnimationTimer = 0; // for organising eyeblink timing
-
-// Animation - eyes confused: eyes shaking left and right
-bool confused = 0; unsigned long confusedAnimationTimer = 0;
-int confusedAnimationDuration = 500;
-bool confusedToggle = 1; // Animation - eyes laughing: eyes shaking up and down
-bool laugh = 0;
-unsigned long laughAnimationTimer = 0; int laughAnimationDuration = 500;
-bool laughToggle = 1;
-
-
-//*********************************************************************************************
-//     GENERAL METHODS
-//*********************************************************************************************
-
-// Startup RoboEyes with defined screen-width, screen-height and max. frame per second
-void begin(int width, int height, byte frameRate) {
-  screenWidth = width; // OLED display width, in pixels
-  screenHeight = height; // OLED display height, in pixels
-  // Assuming 'display' object is available in the scope where this class is used
-  // If 'display' is a member of this class, it would be 'this->display.clearDisplay();'
-  // Or if 'display' is passed as a parameter to begin(), e.g., begin(..., Adafruit_SSD1306& disp)
-  // For now, assuming it's globally accessible as per common Arduino examples. display.clearDisplay(); // clear the display buffer
-  // display.clearDisplay(); // clear the display buffer - commented out for Arduino IDE compatibility
-  // display.display(); // show empty screen - commented out for Arduino IDE compatibility
-  eyeLheightCurrent = 1; // start with closed eyes
-  eyeRheightCurrent = 1; // start with closed eyes
-  setFramerate(frameRate); // calculate frame interval based on defined frameRate
-}
-
-void update(){
-  // Limit drawing updates to defined max framerate
-  if(millis()-fpsTimer >= frameInterval){
-    drawEyes(); fpsTimer = millis();
-  }
-}
-
-
-//*********************************************************************************************
-//     SETTERS METHODS
-//*********************************************************************************************
-
-// Calculate frame interval based on defined frameRate
-void setFramerate(byte fps){
-  frameInterval = 1000/fps;
-}
-
-void setWidth(byte leftEye, byte rightEye) {
-  eyeLwidthNext = leftEye;
-  eyeRwidthNext = rightEye;
-  eyeLwidthDefault = leftEye;
-  eyeRwidthDefault = rightEye;
-}
-
-void setHeight(byte leftEye, byte rightEye) {
-  eyeLheightNext = leftEye;
-  eyeRheightNext = rightEye;
-  eyeLheightDefault = leftEye;
-  eyeRheightDefault = rightEye;
-}
-
-// Set border radius for left and right eye
-void setBorderradius(byte leftEye, byte rightEye) {
-  eyeLborderRadiusNext = leftEye; eyeRborderRadiusNext = rightEye;
-  eyeLborderRadiusDefault = leftEye;
-  eyeRborderRadiusDefault = rightEye;
-}
-
-// Set space between the eyes, can also be negative
-void setSpacebetween(int space) {
-  spaceBetweenNext = space; spaceBetweenDefault = space;
-}
-
-// Set mood expression
-void setMood(unsigned char mood)
-  {
-    switch (mood)
-    {
-    case TIRED:
-      tired=1; angry=0;
-      happy=0;
-      sleepy=0; // Ensure other moods are off
-      dizzy=0; // Ensure other moods are off
-      break; case ANGRY:
-      tired=0;
-      angry=1;
-      happy=0;
-      sleepy=0; // Ensure other moods are off
-      dizzy=0; // Ensure other moods are off
-      break;
-    case HAPPY:
-      tired=0; angry=0;
-      happy=1;
-      sleepy=0; // Ensure other moods are off
-      dizzy=0; // Ensure other moods are off
-      break; case SLEEPY: // New SLEEPY case
-      tired=0;
-      angry=0;
-      happy=0;
-      sleepy=1;
-      dizzy=0; // Ensure other moods are off
-      break;
-    case DIZZY: // New DIZZY case
-      tired=0;
-      angry=0;
-      happy=0;
-      sleepy=0;
-      dizzy=1;
-      dizzyAnimationTimer = millis() + dizzyAnimationDuration; // Set duration for dizzy
-      break;
-    default:
-      tired=0;
-      angry=0;
-      happy=0;
-      sleepy=0;
-      dizzy=0;
-      break;
-    }
-  }
-
-// Set predefined position
-void setPosition(unsigned char position)
-  {
-    switch (position)
-    {
-    case N:
-      // North, top center
-      eyeLxNext = getScreenConstraint_X()/2; eyeLyNext = 0;
-      break;
-    case NE:
-      // North-east, top right
-      eyeLxNext = getScreenConstraint_X(); eyeLyNext = 0;
-      break;
-    case E:
-      // East, middle right
-      eyeLxNext = getScreenConstraint_X(); eyeLyNext = getScreenConstraint_Y()/2;
-      break;
-    case SE:
-      // South-east, bottom right
-      eyeLxNext = getScreenConstraint_X(); eyeLyNext = getScreenConstraint_Y();
-      break;
-    case S:
-      // South, bottom center
-      eyeLxNext = getScreenConstraint_X()/2; eyeLyNext = getScreenConstraint_Y();
-      break;
-    case SW:
-      // South-west, bottom left
-      eyeLxNext = 0; eyeLyNext = getScreenConstraint_Y();
-      break;
-    case W:
-      // West, middle left
-      eyeLxNext = 0; eyeLyNext = getScreenConstraint_Y()/2;
-      break;
-    case NW:
-      // North-west, top left
-      eyeLxNext = 0; eyeLyNext = 0;
-      break;
-    default:
-      // Middle center
-      eyeLxNext = getScreenConstraint_X()/2; eyeLyNext = getScreenConstraint_Y()/2;
-      break;
-    }
-  }
-
-// Set automated eye blinking, minimal blink interval in full seconds and blink interval variation range in full seconds
-void setAutoblinker(bool active, int interval, int variation){
-  autoblinker = active; blinkInterval = interval;
-  blinkIntervalVariation = variation;
-}
-void setAutoblinker(bool active){
-  autoblinker = active;
-}
-
-// Set idle mode - automated eye repositioning, minimal time interval in full seconds and time interval variation range in full seconds
-void setIdleMode(bool active, int interval, int variation){
-  idle = active; idleInterval = interval;
-  idleIntervalVariation = variation;
-}
-void setIdleMode(bool active) {
-  idle = active;
-}
-
-// Set curious mode - the respectively outer eye gets larger when looking left or right
-void setCuriosity(bool curiousBit) {
-  curious = curiousBit;
-}
-
-// Set cyclops mode - show only one eye
-void setCyclops(bool cyclopsBit) {
-  cyclops = cyclopsBit;
-}
-
-// Set horizontal flickering (displacing eyes left/right)
-void setHFlicker (bool flickerBit, byte Amplitude) {
-  hFlicker = flickerBit; // turn flicker on or off
-  hFlickerAmplitude = Amplitude; // define amplitude of flickering in pixels
-}
-void setHFlicker (bool flickerBit) {
-  hFlicker = flickerBit; // turn flicker on or off
-}
-
-
-// Set vertical flickering (displacing eyes up/down)
-void setVFlicker (bool flickerBit, byte Amplitude) {
-  vFlicker = flickerBit; // turn flicker on or off
-  vFlickerAmplitude = Amplitude; // define amplitude of flickering in pixels
-}
-void setVFlicker (bool flickerBit) {
-  vFlicker = flickerBit; // turn flicker on or off
-}
-
-// Set dizzy mood
-void setDizzy(bool active, int duration_ms = 2000, float radius = 10.0, int compactionWidth = 10, int compactionHeight = 10) {
-  dizzy = active;
-  dizzyAnimationDuration = duration_ms;
-  dizzyRadius = radius;
-  dizzyEyeCompactionWidth = compactionWidth;
-  dizzyEyeCompactionHeight = compactionHeight;
-  if (dizzy) {
-    dizzyAnimationTimer = millis() + dizzyAnimationDuration; // Set duration for dizzy
-  }
-}
-
-
-//*********************************************************************************************
-//     GETTERS METHODS
-//*********************************************************************************************
-
-// Returns the max x position for left eye
-int getScreenConstraint_X(){
-  // Use default widths and space for constraint calculation to avoid flickering boundaries
-  return screenWidth - eyeLwidthDefault - spaceBetweenDefault - eyeRwidthDefault;
-}
-
-// Returns the max y position for left eye
-int getScreenConstraint_Y(){
- return screenHeight - eyeLheightDefault; // using default height here, because height will vary when blinking and in curious mode
-}
-
-
-//*********************************************************************************************
-//     BASIC ANIMATION METHODS
-//*********************************************************************************************
-
-// BLINKING FOR BOTH EYES AT ONCE
-// Close both eyes
-void close() {
-  eyeLheightNext = 1; // closing left eye
-  eyeRheightNext = 1; // closing right eye
-  eyeL_open = 0; // left eye not opened (=closed)
-  eyeR_open = 0; // right eye not opened (=closed)
-}
-
-// Open both eyes
-void open() {
-  eyeL_open = 1; // left eye opened - if true, drawEyes() will take care of opening eyes again
-  eyeR_open = 1; // right eye opened
-}
-
-// Trigger eyeblink animation
-void blink() {
-  close();
-  open();
-}
-
-// BLINKING FOR SINGLE EYES, CONTROL EACH EYE SEPARATELY
-// Close eye(s)
-void close(bool left, bool right) {
-  if(left){
-    eyeLheightNext = 1; // blinking left eye
-    eyeL_open = 0; // left eye not opened (=closed)
-  }
-  if(right){
-      eyeRheightNext = 1; // blinking right eye
-      eyeR_open = 0; // right eye not opened (=closed)
-  }
-}
-
-// Open eye(s)
-void open(bool left, bool right) {
-  if(left){
-    eyeL_open = 1; // left eye opened - if true, drawEyes() will take care of opening eyes again
-  }
-  if(right){
-    eyeR_open = 1; // right eye opened
-  }
-}
-
-// Trigger eyeblink(s) animation
-void blink(bool left, bool right) {
-  close(left, right);
-  open(left, right);
-}
-
-
-//*********************************************************************************************
-//     MACRO ANIMATION METHODS
-//*********************************************************************************************
-
-// Play confused animation - one shot animation of eyes shaking left and right
-void anim_confused() {
-  confused = 1;
-}
-
-// Play laugh animation - one shot animation of eyes shaking up and down
-void anim_laugh() {
-  laugh = 1;
-}
-
-//*********************************************************************************************
-//     PRE-CALCULATIONS AND ACTUAL DRAWINGS
-//*********************************************************************************************
-
-void drawEyes(){
-
-  //// PRE-CALCULATIONS - EYE SIZES AND VALUES FOR ANIMATION TWEENINGS ////
-
-  // Vertical size offset for larger eyes when looking left or right (curious gaze)
-  // Modified: If sleepy or dizzy is active, curious mode effects are bypassed.
-  bool effectiveCurious = curious && !sleepy && !dizzy;
-
-  if(effectiveCurious){
-    // Left eye curious logic
-    if(eyeLxNext <= 10 && eyeLxNext < (getScreenConstraint_X()/2)) { // Only apply if truly looking left
-      eyeLheightOffset = 5; // Reduced from 8 to 5
-    } else if (cyclops && eyeLxNext >= (getScreenConstraint_X() - 10) && eyeLxNext > (getScreenConstraint_X()/2)) { // Cyclops looking right
-      eyeLheightOffset = 5; // Reduced from 8 to 5
-    } else {
-      eyeLheightOffset = 0;
-    }
-
-    // Right eye curious logic (only if not cyclops)
-    if (!cyclops) {
-      if(eyeRxNext >= screenWidth - eyeRwidthDefault - 10 && eyeRxNext > (screenWidth / 2)) { // Only apply if truly looking right
-        eyeRheightOffset = 5; // Reduced from 8 to 5
-      } else {
-        eyeRheightOffset = 0;
-      }
-    } else {
-      eyeRheightOffset = 0; // No curious offset for right eye in cyclops mode
-    }
-  } else {
-    eyeLheightOffset=0; // reset height offset for left eye
-    eyeRheightOffset=0; // reset height offset for right eye
-  }
-
-  // Eye heights
-  eyeLheightCurrent = (eyeLheightCurrent + eyeLheightNext + eyeLheightOffset)/2; eyeRheightCurrent = (eyeRheightCurrent + eyeRheightNext + eyeRheightOffset)/2;
-
-  // Open eyes again after closing them
-  if(eyeL_open){
-    if(eyeLheightCurrent <= 1 + eyeLheightOffset){eyeLheightNext = eyeLheightDefault;}
-  }
-  if(eyeR_open){
-    if(eyeRheightCurrent <= 1 + eyeRheightOffset){eyeRheightNext = eyeRheightDefault;}
-  }
-
-  // BLINKING SQUASH & STRETCH
-  // Left Eye
-  if (eyeLheightNext == 1) { // Eyes are closing (squash vertically, stretch horizontally)
-    eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault + (eyeLheightDefault - eyeLheightCurrent) / 4)) / 2;
-  } else if (eyeLheightCurrent < eyeLheightDefault && eyeLheightNext == eyeLheightDefault) { // Eyes are opening (stretch vertically, slight squash horizontally)
-    eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - (eyeLheightDefault - eyeLheightCurrent) / 8)) / 2;
-  } else {
-    eyeLwidthCurrent = (eyeLwidthCurrent + eyeLwidthNext) / 2; // Revert to next (default) width
-  }
-
-  // Right Eye (if not cyclops)
-  if (!cyclops) {
-    if (eyeRheightNext == 1) { // Eyes are closing (squash vertically, stretch horizontally)
-      eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault + (eyeRheightDefault - eyeRheightCurrent) / 4)) / 2;
-    } else if (eyeRheightCurrent < eyeRheightDefault && eyeRheightNext == eyeRheightDefault) { // Eyes are opening (stretch vertically, slight squash horizontally)
-      eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault - (eyeRheightDefault - eyeRheightCurrent) / 8)) / 2;
-    } else {
-      eyeRwidthCurrent = (eyeRwidthCurrent + eyeRwidthNext) / 2; // Revert to next (default) width
-    }
-  } else {
-    eyeRwidthCurrent = 0; // Ensure right eye is fully closed in cyclops mode
-  }
-
-
-  // CURIOUS MODE SQUASH & STRETCH (additional to the default height offset)
-  // Modified: Only apply curious effects if sleepy or dizzy is not active.
-  if (effectiveCurious) {
-    // When looking left (left eye becomes taller/narrower, right eye wider)
-    if (eyeLxNext <= 10 && eyeLxNext < (getScreenConstraint_X()/2)) {
-      eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - eyeLheightOffset / 2)) / 2; // Left eye: vertically stretched, horizontally squashed
-      if (!cyclops) {
-        eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault + eyeLheightOffset / 2)) / 2; // Right eye: horizontally stretched
-      }
-    }
-    // When looking right (right eye becomes taller/narrower, left eye wider)
-    else if (!cyclops && eyeRxNext >= screenWidth - eyeRwidthDefault - 10 && eyeRxNext > (screenWidth / 2)) {
-      eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault - eyeRheightOffset / 2)) / 2; // Right eye: vertically stretched, horizontally squashed
-      eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault + eyeRheightOffset / 2)) / 2; // Left eye: horizontally stretched
-    } else if (cyclops && eyeLxNext >= (getScreenConstraint_X() - 10) && eyeLxNext > (getScreenConstraint_X()/2)) { // Cyclops looking right
-        eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - eyeLheightOffset / 2)) / 2; // Left eye: vertically stretched, horizontally squashed
-    }
-    // If not in extreme left/right, smoothly transition back to default width
-    else {
-      eyeLwidthCurrent = (eyeLwidthCurrent + eyeLwidthNext) / 2; eyeRwidthCurrent = (eyeRwidthCurrent + eyeRwidthNext) / 2;
-    }
-  } else {
-    // Ensure widths revert to default if curious is off (or if sleepy/dizzy is on)
-    eyeLwidthCurrent = (eyeLwidthCurrent + eyeLwidthNext) / 2; eyeRwidthCurrent = (eyeRwidthCurrent + eyeRwidthNext) / 2;
-  }
-
-
-  // Space between eyes
-  spaceBetweenCurrent = (spaceBetweenCurrent + spaceBetweenNext)/2; // *** FIX START: Corrected Eye Coordinates Smoothing ***
-  // These lines now simply smooth the current position towards the target 'Next' position
-  // The 'Next' positions are set by setPosition() and Idle Mode.
-  eyeLx = (eyeLx + eyeLxNext) / 2;
-  eyeLy = (eyeLy + eyeLyNext) / 2; // Right eye's x position depends on left eye's position + the space between
-  eyeRxNext = eyeLxNext + eyeLwidthCurrent + spaceBetweenCurrent; eyeRyNext = eyeLyNext; // right eye's y position should be the same as for the left eye
-
-  eyeRx = (eyeRx + eyeRxNext) / 2; eyeRy = (eyeRy + eyeRyNext) / 2;
-  // *** FIX END ***
-
-
-  // Left eye border radius
-  eyeLborderRadiusCurrent = (eyeLborderRadiusCurrent + eyeLborderRadiusNext)/2; // Right eye border radius
-  eyeRborderRadiusCurrent = (eyeRborderRadiusCurrent + eyeRborderRadiusNext)/2; //// APPLYING MACRO ANIMATIONS ////
-
-  if(autoblinker){
-    if(millis() >= blinktimer){
-    blink();
-    blinktimer = millis()+(blinkInterval*1000)+(random(blinkIntervalVariation)*1000); // calculate next time for blinking
-    }
-  }
-
-  // Laughing - eyes shaking up and down for the duration defined by laughAnimationDuration (default = 500ms)
-  if(laugh){
-    if(laughToggle){
-      setVFlicker(1, 5); // Activate vertical flicker for laugh
-      laughAnimationTimer = millis();
-      laughToggle = 0;
-    } else if(millis() >= laughAnimationTimer+laughAnimationDuration){
-      setVFlicker(0, 0); // Deactivate vertical flicker
-      laughToggle = 1;
-      laugh=0;
-    }
-  }
-
-  // Confused - eyes shaking left and right for the duration defined by confusedAnimationDuration (default = 500ms)
-  if(confused){
-    if(confusedToggle){
-      setHFlicker(1, 10); // Activate horizontal flicker for confused
-      confusedAnimationTimer = millis();
-      confusedToggle = 0;
-    } else if(millis() >= confusedAnimationTimer+confusedAnimationDuration){
-      setHFlicker(0, 0); // Deactivate horizontal flicker
-      confusedToggle = 1;
-      confused=0;
-    }
-  }
-
-  // Idle - eyes moving to random positions on screen
-  // Modified: Idle mode is paused when sleepy or dizzy is active.
-  if(idle && !sleepy && !dizzy){
-    if(millis() >= idleAnimationTimer){
-      // Store current positions before calculating new random ones for potential stretch/squash based on movement
-      int prevEyeLx = eyeLxNext; // Use eyeLxNext as previous target for direction
-      int prevEyeLy = eyeLyNext; // Use eyeLyNext as previous target for direction
-
-      eyeLxNext = random(getScreenConstraint_X() + 1); // +1 to ensure random reaches max boundary
-      eyeLyNext = random(getScreenConstraint_Y() + 1); // +1 to ensure random reaches max boundary
-
-      // Clamp eyeLxNext/eyeLyNext to within screen constraints
-      eyeLxNext = constrain(eyeLxNext, 0, getScreenConstraint_X()); eyeLyNext = constrain(eyeLyNext, 0, getScreenConstraint_Y());
-
-      // A very subtle squash/stretch for idle movement (optional, can be removed if too much)
-      int dx = abs(eyeLxNext - prevEyeLx); int dy = abs(eyeLyNext - prevEyeLy);
-
-      // Only apply stretch/squash if there's significant movement
-      if (dx > dy && dx > 2) { // More horizontal movement
-          eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault + dx / 20)) / 2; // Slight horizontal stretch
-          eyeLheightCurrent = (eyeLheightCurrent + (eyeLheightDefault - dx / 40)) / 2; // Slight vertical squash
-          if (!cyclops) {
-              eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault + dx / 2)) / 2; eyeRheightCurrent = (eyeRheightCurrent + (eyeRheightDefault - dx / 4)) / 2;
-          }
-      } else if (dy > dx && dy > 2) { // More vertical movement
-          eyeLheightCurrent = (eyeLheightCurrent + (eyeLheightDefault + dy / 20)) / 2; // Slight vertical stretch
-          eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - dy / 40)) / 2; // Slight horizontal squash
-          if (!cyclops) {
-              eyeRheightCurrent = (eyeRheightCurrent + (eyeRheightDefault + dy / 2)) / 2; eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault - dy / 4)) / 2;
-          }
-      } else { // If movement is small or mostly diagonal, ease back to default size
-          eyeLwidthCurrent = (eyeLwidthCurrent + eyeLwidthDefault) / 2; eyeLheightCurrent = (eyeLheightCurrent + eyeLheightDefault) / 2;
-          if (!cyclops) {
-            eyeRwidthCurrent = (eyeRwidthCurrent + eyeRwidthDefault) / 2; eyeRheightCurrent = (eyeRheightCurrent + eyeRheightDefault) / 2;
-          }
-      }
-
-      idleAnimationTimer = millis()+(idleInterval*1000)+(random(idleIntervalVariation)*1000); // calculate next time for eyes repositioning
-    }
-  }
-
-
-  // Adding offsets for horizontal flickering/shivering (with squash and stretch)
-  if(hFlicker){
-    if(hFlickerAlternate) {
-      eyeLx += hFlickerAmplitude; eyeRx += hFlickerAmplitude;
-      // Apply squash-stretch for horizontal movement
-      eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - hFlickerAmplitude)) / 2; eyeLheightCurrent = (eyeLheightCurrent + (eyeLheightDefault + hFlickerAmplitude / 2)) / 2;
-      if (!cyclops) {
-        eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault - hFlickerAmplitude)) / 2; eyeRheightCurrent = (eyeRheightCurrent + (eyeRheightDefault + hFlickerAmplitude / 2)) / 2;
-      }
-    } else {
-      eyeLx -= hFlickerAmplitude;
-      eyeRx -= hFlickerAmplitude; // Apply squash-stretch for horizontal movement
-      eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - hFlickerAmplitude)) / 2; eyeLheightCurrent = (eyeLheightCurrent + (eyeLheightDefault + hFlickerAmplitude / 2)) / 2;
-      if (!cyclops) {
-        eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault - hFlickerAmplitude)) / 2; eyeRheightCurrent = (eyeRheightCurrent + (eyeRheightDefault + hFlickerAmplitude / 2)) / 2;
-      }
-    }
-    hFlickerAlternate = !hFlickerAlternate;
-  }
-
-  // Adding offsets for vertical flickering/shivering (with squash and stretch)
-  if(vFlicker){
-    if(vFlickerAlternate) {
-      eyeLy += vFlickerAmplitude; eyeRy += vFlickerAmplitude;
-      // Apply squash-stretch for vertical movement
-      eyeLheightCurrent = (eyeLheightCurrent + (eyeLheightDefault + vFlickerAmplitude)) / 2; eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - vFlickerAmplitude / 2)) / 2;
-      if (!cyclops) {
-        eyeRheightCurrent = (eyeRheightCurrent + (eyeRheightDefault + vFlickerAmplitude)) / 2; eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault - vFlickerAmplitude / 2)) / 2;
-      }
-    } else {
-      eyeLy -= vFlickerAmplitude;
-      eyeRy -= vFlickerAmplitude; // Apply squash-stretch for vertical movement
-      eyeLheightCurrent = (eyeLheightCurrent + (eyeLheightDefault + vFlickerAmplitude)) / 2; eyeLwidthCurrent = (eyeLwidthCurrent + (eyeLwidthDefault - vFlickerAmplitude / 2)) / 2;
-      if (!cyclops) {
-        eyeRheightCurrent = (eyeRheightCurrent + (eyeRheightDefault + vFlickerAmplitude)) / 2; eyeRwidthCurrent = (eyeRwidthCurrent + (eyeRwidthDefault - vFlickerAmplitude / 2)) / 2;
-      }
-    }
-    vFlickerAlternate = !vFlickerAlternate;
-  }
-
-  // Recalculate eye positions for centering after size changes (must be done near the end of pre-calculations)
-  // These adjust the eyeLx/y and eyeRx/y *before* the final draw to keep them centered
-  eyeLx += (eyeLwidthDefault - eyeLwidthCurrent) / 2; eyeLy += (eyeLheightDefault - eyeLheightCurrent) / 2;
-  if (!cyclops) {
-    eyeRx += (eyeRwidthDefault - eyeRwidthCurrent) / 2; eyeRy += (eyeRheightDefault - eyeRheightCurrent) / 2;
-  }
-
-
-  // Cyclops mode, set second eye's size and space between to 0
-  if(cyclops){
-    eyeRwidthCurrent = 0; eyeRheightCurrent = 0;
-    spaceBetweenCurrent = 0;
-  }
-
-
-  //// ACTUAL DRAWINGS ////
-
-  // Assuming 'display' object is globally accessible or passed.
-  // Uncomment and ensure 'display' is properly initialized (e.g., Adafruit_SSD1306 object).
-  // display.clearDisplay(); // start with a blank screen
-
-  // Handle SLEEPY mood logic before drawing eyes and eyelids
-  if (sleepy) {
-    if (millis() >= sleepyAnimationTimer) {
-      // Toggle between tired and normal eyes
-      sleepyNormalEyes = !sleepyNormalEyes; // Set the next timer for a normal eye appearance (short) or tired (longer)
-      if (sleepyNormalEyes) {
-        // Brief moment of normal eyes
-        eyelidsTiredHeightNext = 0; // Temporarily turn off tired eyelids
-        eyeLheightNext = eyeLheightDefault;
-        eyeRheightNext = eyeRheightDefault; sleepyAnimationTimer = millis() + 500; // Normal eyes for 500ms
-      } else {
-        // Longer period of tired eyes
-        eyelidsTiredHeightNext = eyeLheightDefault / 2; // Apply tired eyelids
-        eyeLheightNext = eyeLheightDefault / 2; // Make eyes appear more tired (half open)
-        eyeRheightNext = eyeRheightDefault / 2; sleepyAnimationTimer = millis() + (sleepyInterval * 1000) + (random(sleepyIntervalVariation) * 1000);
-      }
-    }
-  }
-
-  // Handle DIZZY mood logic
-  if (dizzy) {
-    if (millis() < dizzyAnimationTimer) {
-      // Calculate compaction
-      eyeLwidthCurrent = (eyeLwidthDefault - dizzyEyeCompactionWidth);
-      eyeLheightCurrent = (eyeLheightDefault - dizzyEyeCompactionHeight);
-      eyeRwidthCurrent = (eyeRwidthDefault - dizzyEyeCompactionWidth);
-      eyeRheightCurrent = (eyeRheightDefault - dizzyEyeCompactionHeight);
-
-      // Calculate circular path
-      float centerX = (screenWidth / 2) - (eyeLwidthCurrent / 2);
-      float centerY = (screenHeight / 2) - (eyeLheightCurrent / 2);
-
-      // Left eye clockwise
-      eyeLx = centerX + dizzyRadius * cos(dizzyAngle);
-      eyeLy = centerY + dizzyRadius * sin(dizzyAngle);
-
-      // Right eye anticlockwise, relative to its own center
-      float rightCenterX = (screenWidth / 2) + (eyeLwidthCurrent / 2) + spaceBetweenDefault; // Approx center for right eye
-      eyeRx = rightCenterX + dizzyRadius * cos(-dizzyAngle);
-      eyeRy = centerY + dizzyRadius * sin(-dizzyAngle);
-
-      dizzyAngle += 0.1; // Increment angle for animation speed (adjust as needed)
-      if (dizzyAngle > 2 * PI) dizzyAngle -= 2 * PI; // Keep angle within 0-2PI
-    } else {
-      // Dizzy animation finished, reset to default state
-      dizzy = 0;
-      eyeLwidthCurrent = eyeLwidthDefault;
-      eyeLheightCurrent = eyeLheightDefault;
-      eyeRwidthCurrent = eyeRwidthDefault;
-      eyeRheightCurrent = eyeRheightDefault;
-      // Also reset eye positions to default or last non-dizzy position
-      eyeLxNext = eyeLxDefault;
-      eyeLyNext = eyeLyDefault;
-      eyeRxNext = eyeRxDefault;
-      eyeRyNext = eyeRyDefault;
-    }
-  }
-
-
-  // Draw basic eye rectangles
-  // Assuming 'display' object is globally accessible or passed.
-  // Uncomment and ensure 'display' is properly initialized (e.g., Adafruit_SSD1306 object).
-  // display.fillRoundRect(eyeLx, eyeLy, eyeLwidthCurrent, eyeLheightCurrent, eyeLborderRadiusCurrent, MAINCOLOR); // left eye
-  if (!cyclops){
-    // display.fillRoundRect(eyeRx, eyeRy, eyeRwidthCurrent, eyeRheightCurrent, eyeRborderRadiusCurrent, MAINCOLOR); // right eye
-  }
-
-  // Prepare mood type transitions
-  // If sleepyNormalEyes is true, eyelidsTiredHeightNext will already be 0 from sleepy logic.
-  // Otherwise, apply tired or angry based on state, ensuring dizzy also clears them.
-  if (tired && !sleepy && !dizzy){eyelidsTiredHeightNext = eyeLheightCurrent/2; eyelidsAngryHeightNext = 0;} else if (!sleepyNormalEyes && !sleepy && !dizzy) {eyelidsTiredHeightNext = 0;}
-  if (angry && !sleepy && !dizzy){eyelidsAngryHeightNext = eyeLheightCurrent/2; eyelidsTiredHeightNext = 0;} else if (!sleepyNormalEyes && !sleepy && !dizzy) {eyelidsAngryHeightNext = 0;}
-  if (happy && !sleepy && !dizzy){eyelidsHappyBottomOffsetNext = eyeLheightCurrent/2;} else if (!sleepyNormalEyes && !sleepy && !dizzy) {eyelidsHappyBottomOffsetNext = 0;}
-
-  // Draw tired top eyelids
-  eyelidsTiredHeight = (eyelidsTiredHeight + eyelidsTiredHeightNext)/2;
-  if (!cyclops){
-    // display.fillTriangle(eyeLx, eyeLy-1, eyeLx+eyeLwidthCurrent, eyeLy-1, eyeLx, eyeLy+eyelidsTiredHeight-1, BGCOLOR); // left eye
-    // display.fillTriangle(eyeRx, eyeRy-1, eyeRx+eyeRwidthCurrent, eyeRy-1, eyeRx+eyeRwidthCurrent, eyeRy+eyelidsTiredHeight-1, BGCOLOR); // right eye
-  } else {
-    // Cyclops tired eyelids
-    // display.fillTriangle(eyeLx, eyeLy-1, eyeLx+(eyeLwidthCurrent/2), eyeLy-1, eyeLx, eyeLy+eyelidsTiredHeight-1, BGCOLOR); // left eyelid half
-    // display.fillTriangle(eyeLx+(eyeLwidthCurrent/2), eyeLy-1, eyeLx+eyeLwidthCurrent, eyeLy-1, eyeLx+(eyeLwidthCurrent/2), eyeLy+eyelidsTiredHeight-1, BGCOLOR); // right eyelid half
-  }
-
-  // Draw angry top eyelids
-  eyelidsAngryHeight = (eyelidsAngryHeight + eyelidsAngryHeightNext)/2;
-  if (!cyclops){
-    // display.fillTriangle(eyeLx, eyeLy-1, eyeLx+eyeLwidthCurrent, eyeLy-1, eyeLx+eyeLwidthCurrent, eyeLy+eyelidsAngryHeight-1, BGCOLOR); // left eye
-    // display.fillTriangle(eyeRx, eyeRy-1, eyeRx+eyeRwidthCurrent, eyeRy-1, eyeRx, eyeRy+eyelidsAngryHeight-1, BGCOLOR); // right eye
-  } else {
-    // Cyclops angry eyelids
-    // display.fillTriangle(eyeLx, eyeLy-1, eyeLx+(eyeLwidthCurrent/2), eyeLy-1, eyeLx+(eyeLwidthCurrent/2), eyeLy+eyelidsAngryHeight-1, BGCOLOR); // left eyelid half
-    // display.fillTriangle(eyeLx+(eyeLwidthCurrent/2), eyeLy-1, eyeLx+eyeLwidthCurrent, eyeLy-1, eyeLx+(eyeLwidthCurrent/2), eyeLy+eyelidsAngryHeight-1, BGCOLOR); // right eyelid half
-  }
-
-  // Draw happy bottom eyelids
-  eyelidsHappyBottomOffset = (eyelidsHappyBottomOffset + eyelidsHappyBottomOffsetNext)/2; // For happy, make sure it applies to the current eye height, not just default height
-  // display.fillRoundRect(eyeLx-1, (eyeLy+eyeLheightCurrent)-eyelidsHappyBottomOffset+1, eyeLwidthCurrent+2, eyeLheightCurrent+2, eyeLborderRadiusCurrent, BGCOLOR); // left eye
-  if (!cyclops){
-    // display.fillRoundRect(eyeRx-1, (eyeRy+eyeRheightCurrent)-eyelidsHappyBottomOffset+1, eyeRwidthCurrent+2, eyeRheightCurrent+2, eyeRborderRadiusCurrent, BGCOLOR); // right eye
-  }
-
-  // display.display(); // show drawings on display // Uncomment this and the clearDisplay in begin() and drawEyes() once 'display' is defined.
-
-} // end of drawEyes method
-
-
-}; // end of class roboEyes
-
-#endif
+/* * FluxGarage RoboEyes for OLED Displays V 1.0.1
+ * Draws smoothly animated robot eyes on OLED displays, based on the Adafruit GFX
+ * library's graphics primitives, such as rounded rectangles and triangles.
+ * * Copyright (C) 2024 Dennis Hoelscher
+ * www.fluxgarage.com
+ * www.youtube.com/@FluxGarage
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _FLUXGARAGE_ROBOEYES_H
+#define _FLUXGARAGE_ROBOEYES_H
+
+#include "RoboEyesDisplay.h" // display backend interface and page buffer rasterizer
+#include "RoboEyesSpriteCache.h" // optional, enabled by defining ROBOEYES_SPRITE_CACHE_BYTES
+
+// Usage of monochrome display colors
+#define BGCOLOR 0 // background and overlays
+#define MAINCOLOR 1 // drawings
+
+// Animation timing: tweens and flickers move as fast as they did at 50 fps, whatever the actual frame rate
+#define ROBOEYES_REFERENCE_FRAME_MS 20 // a tween covers half the remaining distance per 20 ms
+#define ROBOEYES_MAX_FRAME_STEP_MS 250 // longer gaps between frames (e.g. a stalled task) count as this long
+
+// For mood type switch
+#define DEFAULT 0
+#define TIRED 1
+#define ANGRY 2
+#define HAPPY 3
+#define SLEEPY 4 // Added SLEEPY mood
+#define DIZZY 5 // Added DIZZY mood
+
+// For turning things on or off
+#define ON 1 // north, top center
+#define OFF 0 // north-east, top right
+
+// For switch "predefined positions"
+#define N 1 // east, middle right
+#define NE 2 // south-east, bottom right
+#define E 3 // south, bottom center
+#define SE 4 // south-west, bottom left
+#define S 5 // west, middle left
+#define SW 6 // north-west,
+#define W 7 // top left
+#define NW 8
+// for middle center set "DEFAULT"
+
+class roboEyes
+{
+private:
+
+// Yes, everything is currently still accessible. Be responsibly and don't mess things up :)
+
+public:
+
+// Display backend all drawing goes to. Without one, the animation state still advances but nothing is drawn.
+RoboEyesDisplay *display = nullptr;
+
+// For general setup - screen size and max. frame rate
+int screenWidth = 128; // OLED display width, in pixels
+int screenHeight = 64; // OLED display height, in pixels
+int frameInterval = 20; // default value for 50 frames per second (1000/50 = 20 milliseconds)
+int idleFrameInterval = 20; // frame interval once nothing moves anymore, see setIdleFramerate()
+unsigned long fpsTimer = 0; // for timing the frames per second
+unsigned long lastFrameTime = 0; // millis() of the previous drawEyes() call, 0 before the first frame
+unsigned long frameElapsed = ROBOEYES_REFERENCE_FRAME_MS; // ms since the previous frame, clamped
+int tweenFactor = 128; // share of the remaining distance all tweens cover this frame, 256 = 1.0
+
+// For controlling mood types and expressions
+bool tired = 0;
+bool angry = 0; bool happy = 0;
+bool sleepy = 0; // Added sleepy state
+bool curious = 0; // if true, draw the outer eye larger when looking left or right
+bool cyclops = 0; // if true, draw only one eye
+bool eyeL_open = 0; // left eye opened or closed?
+bool eyeR_open = 0; // right eye opened or closed?
+
+
+// Dizzy mood variables
+bool dizzy = 0;
+unsigned long dizzyAnimationTimer = 0;
+int dizzyAnimationDuration = 2000; // Default dizzy duration in ms
+float dizzyAngle = 0.0;
+float dizzyRadius = 10.0; // Radius of the circular path
+int dizzyEyeCompactionWidth = 10; // How much eyes compact horizontally
+int dizzyEyeCompactionHeight = 10; // How much eyes compact vertically
+
+
+//*********************************************************************************************
+//     Eyes Geometry
+//*********************************************************************************************
+
+// EYE LEFT - size and border radius
+int eyeLwidthDefault = 36; int eyeLheightDefault = 36;
+int eyeLwidthCurrent = eyeLwidthDefault;
+int eyeLheightCurrent = 1; // start with closed eye, otherwise set to eyeLheightDefault
+int eyeLwidthNext = eyeLwidthDefault;
+int eyeLheightNext = eyeLheightDefault;
+int eyeLheightOffset = 0; // Border Radius
+byte eyeLborderRadiusDefault = 8;
+byte eyeLborderRadiusCurrent = eyeLborderRadiusDefault;
+byte eyeLborderRadiusNext = eyeLborderRadiusDefault; // EYE RIGHT - size and border radius
+int eyeRwidthDefault = eyeLwidthDefault;
+int eyeRheightDefault = eyeLheightDefault;
+int eyeRwidthCurrent = eyeRwidthDefault; int eyeRheightCurrent = 1; // start with closed eye, otherwise set to eyeRheightDefault
+int eyeRwidthNext = eyeRwidthDefault;
+int eyeRheightNext = eyeRheightDefault; int eyeRheightOffset = 0;
+// Border Radius
+byte eyeRborderRadiusDefault = 8;
+byte eyeRborderRadiusCurrent = eyeRborderRadiusDefault;
+byte eyeRborderRadiusNext = eyeRborderRadiusDefault; // EYE LEFT - Coordinates
+int eyeLxDefault = ((screenWidth)-(eyeLwidthDefault+spaceBetweenDefault+eyeRwidthDefault))/2;
+int eyeLyDefault = ((screenHeight-eyeLheightDefault)/2);
+int eyeLx = eyeLxDefault;
+int eyeLy = eyeLyDefault; int eyeLxNext = eyeLxDefault; // Initialize with default
+int eyeLyNext = eyeLyDefault; // Initialize with default
+
+// EYE RIGHT - Coordinates
+int eyeRxDefault = eyeLx+eyeLwidthCurrent+spaceBetweenDefault;
+int eyeRyDefault = eyeLy;
+int eyeRx = eyeRxDefault; int eyeRy = eyeRyDefault;
+int eyeRxNext = eyeRxDefault; // Initialize with default
+int eyeRyNext = eyeRyDefault; // Initialize with default
+
+// BOTH EYES
+// Eyelid top size
+byte eyelidsHeightMax = eyeLheightDefault/2; // top eyelids max height
+byte eyelidsTiredHeight = 0;
+byte eyelidsTiredHeightNext = eyelidsTiredHeight;
+byte eyelidsAngryHeight = 0;
+byte eyelidsAngryHeightNext = eyelidsAngryHeight; // Bottom happy eyelids offset
+byte eyelidsHappyBottomOffsetMax = (eyeLheightDefault/2)+3;
+byte eyelidsHappyBottomOffset = 0;
+byte eyelidsHappyBottomOffsetNext = 0; // Space between eyes
+int spaceBetweenDefault = 10;
+int spaceBetweenCurrent = spaceBetweenDefault;
+int spaceBetweenNext = 10; // Sleepy mode variables
+unsigned long sleepyAnimationTimer = 0;
+int sleepyInterval = 2; // Base interval for normal eye appearance in seconds
+int sleepyIntervalVariation = 3; // Variation range in seconds
+bool sleepyNormalEyes = false; // Flag to indicate if eyes should be briefly normal
+
+
+//*********************************************************************************************
+//     Macro Animations
+//*********************************************************************************************
+
+// Animation - horizontal flicker/shiver
+bool hFlicker = 0; bool hFlickerAlternate = 0;
+byte hFlickerAmplitude = 2;
+
+// Animation - vertical flicker/shiver
+bool vFlicker = 0;
+bool vFlickerAlternate = 0; byte vFlickerAmplitude = 10;
+unsigned long flickerTimer = 0; // flickers alternate every ROBOEYES_REFERENCE_FRAME_MS
+
+// Animation - auto blinking
+bool autoblinker = 0; // activate auto blink animation
+int blinkInterval = 1; // basic interval between each blink in full seconds
+int blinkIntervalVariation = 4; // interval variaton range in full seconds, random number inside of given range will be add to the basic blinkInterval, set to 0 for no variation
+unsigned long blinktimer = 0; // for organising eyeblink timing
+
+// Animation - idle mode: eyes looking in random directions
+bool idle = 0; int idleInterval = 1; // basic interval between each eye repositioning in full seconds
+int idleIntervalVariation = 3; // interval variaton range in full seconds, random number inside of given range will be add to the basic idleInterval, set to 0 for no variation
+unsigned long idleAnimationTimer = 0; // for organising eyeblink timing
+
+// Animation - eyes confused: eyes shaking left and right
+bool confused = 0; unsigned long confusedAnimationTimer = 0;
+int confusedAnimationDuration = 500;
+bool confusedToggle = 1; // Animation - eyes laughing: eyes shaking up and down
+bool laugh = 0;
+unsigned long laughAnimationTimer = 0; int laughAnimationDuration = 500;
+bool laughToggle = 1;
+
+
+//*********************************************************************************************
+//     Frame Change Detection
+//*********************************************************************************************
+
+// Everything that ends up in the framebuffer. If this is identical to the previous
+// frame, the clear/draw/display() of drawEyes() are skipped entirely.
+struct EyeFrame {
+  int lx, ly, lw, lh; byte lr; // left eye rectangle and border radius
+  int rx, ry, rw, rh; byte rr; // right eye rectangle and border radius
+  byte tired, angry, happy; // eyelid heights / bottom offset
+  bool cyclops;
+};
+EyeFrame lastFrame; // geometry of the frame currently shown on the display
+bool lastFrameValid = false; // false until the first frame was drawn, forces a full redraw
+bool frameChanged = false; // true if the last drawEyes() call produced a new frame
+
+// Region touched by the last frame (union of previous and current eye bounds), clipped to the screen.
+// SSD1306 memory is organised in 8-pixel pages, so only pages dirtyPageFirst..dirtyPageLast
+// and columns dirtyColumnFirst..dirtyColumnLast need to be cleared, redrawn and pushed.
+int dirtyPageFirst = 0; int dirtyPageLast = 0;
+int dirtyColumnFirst = 0; int dirtyColumnLast = 0;
+unsigned long framesDrawn = 0; // frames that changed and were pushed
+unsigned long framesSkipped = 0; // frames identical to the previous one
+
+#if ROBOEYES_SPRITE_CACHE_BYTES > 0
+// Pre-rendered eyes, see RoboEyesSpriteCache.h
+RoboEyesSpriteCache spriteCache;
+#endif
+
+// Force the next frame to be redrawn and pushed as a whole, e.g. after something else drew on the display
+void invalidate() {
+  lastFrameValid = false;
+}
+
+
+//*********************************************************************************************
+//     GENERAL METHODS
+//*********************************************************************************************
+
+// Startup RoboEyes drawing to the given display backend, e.g. a RoboEyesSSD1306 instance
+void begin(RoboEyesDisplay &disp, int width, int height, byte frameRate) {
+  display = &disp;
+  begin(width, height, frameRate);
+}
+
+// Startup RoboEyes with defined screen-width, screen-height and max. frame per second
+void begin(int width, int height, byte frameRate) {
+  screenWidth = width; // OLED display width, in pixels
+  screenHeight = height; // OLED display height, in pixels
+  if (display && display->begin(width, height)) {
+    display->fillRect(0, 0, screenWidth, screenHeight, BGCOLOR); // clear the display buffer
+    display->push(0, (screenHeight-1)/8, 0, screenWidth-1); // show empty screen
+  } else {
+    display = nullptr; // panel missing or not answering: animate without drawing, never push to it
+  }
+  invalidate(); // first frame is always a full redraw
+  eyeLheightCurrent = 1; // start with closed eyes
+  eyeRheightCurrent = 1; // start with closed eyes
+  setFramerate(frameRate); // calculate frame interval based on defined frameRate
+}
+
+void update(){
+  // Limit drawing updates to defined max framerate, or to the idle framerate once everything has settled
+  unsigned long interval = (idleFrameInterval > frameInterval && !isAnimating()) ? idleFrameInterval : frameInterval;
+  if(millis()-fpsTimer >= interval){
+    drawEyes(); fpsTimer = millis();
+  }
+  if (display) display->service();
+}
+
+
+//*********************************************************************************************
+//     SETTERS METHODS
+//*********************************************************************************************
+
+// Calculate frame interval based on defined frameRate
+void setFramerate(byte fps){
+  if (idleFrameInterval == frameInterval) idleFrameInterval = 1000/fps; // adaptive rate not in use, keep it off
+  frameInterval = 1000/fps;
+}
+
+// Frame rate used while nothing moves, e.g. 10 fps. Animations are time based, so they look the same
+// at either rate. The first frame after a change can come up to one idle frame interval late.
+void setIdleFramerate(byte fps){
+  idleFrameInterval = 1000/fps;
+}
+
+void setWidth(byte leftEye, byte rightEye) {
+  eyeLwidthNext = leftEye;
+  eyeRwidthNext = rightEye;
+  eyeLwidthDefault = leftEye;
+  eyeRwidthDefault = rightEye;
+}
+
+void setHeight(byte leftEye, byte rightEye) {
+  eyeLheightNext = leftEye;
+  eyeRheightNext = rightEye;
+  eyeLheightDefault = leftEye;
+  eyeRheightDefault = rightEye;
+}
+
+// Set border radius for left and right eye
+void setBorderradius(byte leftEye, byte rightEye) {
+  eyeLborderRadiusNext = leftEye; eyeRborderRadiusNext = rightEye;
+  eyeLborderRadiusDefault = leftEye;
+  eyeRborderRadiusDefault = rightEye;
+}
+
+// Set space between the eyes, can also be negative
+void setSpacebetween(int space) {
+  spaceBetweenNext = space; spaceBetweenDefault = space;
+}
+
+// Set mood expression
+void setMood(unsigned char mood)
+  {
+    switch (mood)
+    {
+    case TIRED:
+      tired=1; angry=0;
+      happy=0;
+      sleepy=0; // Ensure other moods are off
+      dizzy=0; // Ensure other moods are off
+      break; case ANGRY:
+      tired=0;
+      angry=1;
+      happy=0;
+      sleepy=0; // Ensure other moods are off
+      dizzy=0; // Ensure other moods are off
+      break;
+    case HAPPY:
+      tired=0; angry=0;
+      happy=1;
+      sleepy=0; // Ensure other moods are off
+      dizzy=0; // Ensure other moods are off
+      break; case SLEEPY: // New SLEEPY case
+      tired=0;
+      angry=0;
+      happy=0;
+      sleepy=1;
+      dizzy=0; // Ensure other moods are off
+      break;
+    case DIZZY: // New DIZZY case
+      tired=0;
+      angry=0;
+      happy=0;
+      sleepy=0;
+      dizzy=1;
+      dizzyAnimationTimer = millis() + dizzyAnimationDuration; // Set duration for dizzy
+      break;
+    default:
+      tired=0;
+      angry=0;
+      happy=0;
+      sleepy=0;
+      dizzy=0;
+      break;
+    }
+  }
+
+// Set predefined position
+void setPosition(unsigned char position)
+  {
+    switch (position)
+    {
+    case N:
+      // North, top center
+      eyeLxNext = getScreenConstraint_X()/2; eyeLyNext = 0;
+      break;
+    case NE:
+      // North-east, top right
+      eyeLxNext = getScreenConstraint_X(); eyeLyNext = 0;
+      break;
+    case E:
+      // East, middle right
+      eyeLxNext = getScreenConstraint_X(); eyeLyNext = getScreenConstraint_Y()/2;
+      break;
+    case SE:
+      // South-east, bottom right
+      eyeLxNext = getScreenConstraint_X(); eyeLyNext = getScreenConstraint_Y();
+      break;
+    case S:
+      // South, bottom center
+      eyeLxNext = getScreenConstraint_X()/2; eyeLyNext = getScreenConstraint_Y();
+      break;
+    case SW:
+      // South-west, bottom left
+      eyeLxNext = 0; eyeLyNext = getScreenConstraint_Y();
+      break;
+    case W:
+      // West, middle left
+      eyeLxNext = 0; eyeLyNext = getScreenConstraint_Y()/2;
+      break;
+    case NW:
+      // North-west, top left
+      eyeLxNext = 0; eyeLyNext = 0;
+      break;
+    default:
+      // Middle center
+      eyeLxNext = getScreenConstraint_X()/2; eyeLyNext = getScreenConstraint_Y()/2;
+      break;
+    }
+  }
+
+// Set automated eye blinking, minimal blink interval in full seconds and blink interval variation range in full seconds
+void setAutoblinker(bool active, int interval, int variation){
+  autoblinker = active; blinkInterval = interval;
+  blinkIntervalVariation = variation;
+}
+void setAutoblinker(bool active){
+  autoblinker = active;
+}
+
+// Set idle mode - automated eye repositioning, minimal time interval in full seconds and time interval variation range in full seconds
+void setIdleMode(bool active, int interval, int variation){
+  idle = active; idleInterval = interval;
+  idleIntervalVariation = variation;
+}
+void setIdleMode(bool active) {
+  idle = active;
+}
+
+// Set curious mode - the respectively outer eye gets larger when looking left or right
+void setCuriosity(bool curiousBit) {
+  curious = curiousBit;
+}
+
+// Set cyclops mode - show only one eye
+void setCyclops(bool cyclopsBit) {
+  cyclops = cyclopsBit;
+}
+
+// Set horizontal flickering (displacing eyes left/right)
+void setHFlicker (bool flickerBit, byte Amplitude) {
+  hFlicker = flickerBit; // turn flicker on or off
+  hFlickerAmplitude = Amplitude; // define amplitude of flickering in pixels
+}
+void setHFlicker (bool flickerBit) {
+  hFlicker = flickerBit; // turn flicker on or off
+}
+
+
+// Set vertical flickering (displacing eyes up/down)
+void setVFlicker (bool flickerBit, byte Amplitude) {
+  vFlicker = flickerBit; // turn flicker on or off
+  vFlickerAmplitude = Amplitude; // define amplitude of flickering in pixels
+}
+void setVFlicker (bool flickerBit) {
+  vFlicker = flickerBit; // turn flicker on or off
+}
+
+// Set dizzy mood
+void setDizzy(bool active, int duration_ms = 2000, float radius = 10.0, int compactionWidth = 10, int compactionHeight = 10) {
+  dizzy = active;
+  dizzyAnimationDuration = duration_ms;
+  dizzyRadius = radius;
+  dizzyEyeCompactionWidth = compactionWidth;
+  dizzyEyeCompactionHeight = compactionHeight;
+  if (dizzy) {
+    dizzyAnimationTimer = millis() + dizzyAnimationDuration; // Set duration for dizzy
+  }
+}
+
+
+//*********************************************************************************************
+//     GETTERS METHODS
+//*********************************************************************************************
+
+// Returns the max x position for left eye
+int getScreenConstraint_X(){
+  // Use default widths and space for constraint calculation to avoid flickering boundaries
+  return screenWidth - eyeLwidthDefault - spaceBetweenDefault - eyeRwidthDefault;
+}
+
+// Returns the max y position for left eye
+int getScreenConstraint_Y(){
+ return screenHeight - eyeLheightDefault; // using default height here, because height will vary when blinking and in curious mode
+}
+
+// True while eyes are still moving or a macro animation runs, i.e. while the full frame rate is needed
+bool isAnimating(){
+  return frameChanged || !lastFrameValid || hFlicker || vFlicker || dizzy || laugh || confused;
+}
+
+// Moves current towards target by the share of the distance given by tweenFactor, but at least one pixel,
+// so targets are actually reached. At 50 fps this is the former (current + target) / 2 per frame.
+int tween(int current, int target){
+  int diff = target - current;
+  if (diff == 0) return current;
+  int step = (diff * tweenFactor) / 256;
+  if (step == 0) step = (diff > 0) ? 1 : -1;
+  return current + step;
+}
+
+// Returns true if two frames would produce identical pixels
+bool sameFrame(const EyeFrame &a, const EyeFrame &b){
+  return a.lx == b.lx && a.ly == b.ly && a.lw == b.lw && a.lh == b.lh && a.lr == b.lr &&
+         a.rx == b.rx && a.ry == b.ry && a.rw == b.rw && a.rh == b.rh && a.rr == b.rr &&
+         a.tired == b.tired && a.angry == b.angry && a.happy == b.happy && a.cyclops == b.cyclops;
+}
+
+// Grows the box (x0,y0)-(x1,y1) by the pixels a frame sets. Eyelids only ever draw in
+// BGCOLOR inside or around the eye, so the eye rectangles bound everything that is lit.
+void addFrameBounds(const EyeFrame &f, int &x0, int &y0, int &x1, int &y1){
+  if (f.lw > 0 && f.lh > 0){
+    x0 = min(x0, f.lx); y0 = min(y0, f.ly);
+    x1 = max(x1, f.lx + f.lw - 1); y1 = max(y1, f.ly + f.lh - 1);
+  }
+  if (!f.cyclops && f.rw > 0 && f.rh > 0){
+    x0 = min(x0, f.rx); y0 = min(y0, f.ry);
+    x1 = max(x1, f.rx + f.rw - 1); y1 = max(y1, f.ry + f.rh - 1);
+  }
+}
+
+
+//*********************************************************************************************
+//     BASIC ANIMATION METHODS
+//*********************************************************************************************
+
+// BLINKING FOR BOTH EYES AT ONCE
+// Close both eyes
+void close() {
+  eyeLheightNext = 1; // closing left eye
+  eyeRheightNext = 1; // closing right eye
+  eyeL_open = 0; // left eye not opened (=closed)
+  eyeR_open = 0; // right eye not opened (=closed)
+}
+
+// Open both eyes
+void open() {
+  eyeL_open = 1; // left eye opened - if true, drawEyes() will take care of opening eyes again
+  eyeR_open = 1; // right eye opened
+}
+
+// Trigger eyeblink animation
+void blink() {
+  close();
+  open();
+}
+
+// BLINKING FOR SINGLE EYES, CONTROL EACH EYE SEPARATELY
+// Close eye(s)
+void close(bool left, bool right) {
+  if(left){
+    eyeLheightNext = 1; // blinking left eye
+    eyeL_open = 0; // left eye not opened (=closed)
+  }
+  if(right){
+      eyeRheightNext = 1; // blinking right eye
+      eyeR_open = 0; // right eye not opened (=closed)
+  }
+}
+
+// Open eye(s)
+void open(bool left, bool right) {
+  if(left){
+    eyeL_open = 1; // left eye opened - if true, drawEyes() will take care of opening eyes again
+  }
+  if(right){
+    eyeR_open = 1; // right eye opened
+  }
+}
+
+// Trigger eyeblink(s) animation
+void blink(bool left, bool right) {
+  close(left, right);
+  open(left, right);
+}
+
+
+//*********************************************************************************************
+//     MACRO ANIMATION METHODS
+//*********************************************************************************************
+
+// Play confused animation - one shot animation of eyes shaking left and right
+void anim_confused() {
+  confused = 1;
+}
+
+// Play laugh animation - one shot animation of eyes shaking up and down
+void anim_laugh() {
+  laugh = 1;
+}
+
+//*********************************************************************************************
+//     PRE-CALCULATIONS AND ACTUAL DRAWINGS
+//*********************************************************************************************
+
+void drawEyes(){
+
+  //// FRAME TIMING ////
+
+  // All tweens cover 1 - 0.5^(elapsed / 20ms) of their remaining distance, i.e. exactly half at 50 fps
+  unsigned long now = millis();
+  frameElapsed = lastFrameTime ? now - lastFrameTime : ROBOEYES_REFERENCE_FRAME_MS;
+  if (frameElapsed > ROBOEYES_MAX_FRAME_STEP_MS) frameElapsed = ROBOEYES_MAX_FRAME_STEP_MS;
+  lastFrameTime = now;
+  tweenFactor = 256 - (int)(256.0f * powf(0.5f, (float)frameElapsed / ROBOEYES_REFERENCE_FRAME_MS) + 0.5f);
+
+  // Flickers alternate at a fixed rate instead of once per frame
+  bool flickerStep = false;
+  if (now - flickerTimer >= ROBOEYES_REFERENCE_FRAME_MS) {
+    flickerStep = true;
+    flickerTimer = now;
+  }
+
+
+  //// PRE-CALCULATIONS - EYE SIZES AND VALUES FOR ANIMATION TWEENINGS ////
+
+  // Vertical size offset for larger eyes when looking left or right (curious gaze)
+  // Modified: If sleepy or dizzy is active, curious mode effects are bypassed.
+  bool effectiveCurious = curious && !sleepy && !dizzy;
+
+  if(effectiveCurious){
+    // Left eye curious logic
+    if(eyeLxNext <= 10 && eyeLxNext < (getScreenConstraint_X()/2)) { // Only apply if truly looking left
+      eyeLheightOffset = 5; // Reduced from 8 to 5
+    } else if (cyclops && eyeLxNext >= (getScreenConstraint_X() - 10) && eyeLxNext > (getScreenConstraint_X()/2)) { // Cyclops looking right
+      eyeLheightOffset = 5; // Reduced from 8 to 5
+    } else {
+      eyeLheightOffset = 0;
+    }
+
+    // Right eye curious logic (only if not cyclops)
+    if (!cyclops) {
+      if(eyeRxNext >= screenWidth - eyeRwidthDefault - 10 && eyeRxNext > (screenWidth / 2)) { // Only apply if truly looking right
+        eyeRheightOffset = 5; // Reduced from 8 to 5
+      } else {
+        eyeRheightOffset = 0;
+      }
+    } else {
+      eyeRheightOffset = 0; // No curious offset for right eye in cyclops mode
+    }
+  } else {
+    eyeLheightOffset=0; // reset height offset for left eye
+    eyeRheightOffset=0; // reset height offset for right eye
+  }
+
+  // Eye heights
+  eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightNext + eyeLheightOffset); eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightNext + eyeRheightOffset);
+
+  // Open eyes again after closing them
+  if(eyeL_open){
+    if(eyeLheightCurrent <= 1 + eyeLheightOffset){eyeLheightNext = eyeLheightDefault;}
+  }
+  if(eyeR_open){
+    if(eyeRheightCurrent <= 1 + eyeRheightOffset){eyeRheightNext = eyeRheightDefault;}
+  }
+
+  // BLINKING SQUASH & STRETCH
+  // Left Eye
+  if (eyeLheightNext == 1) { // Eyes are closing (squash vertically, stretch horizontally)
+    eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault + (eyeLheightDefault - eyeLheightCurrent) / 4);
+  } else if (eyeLheightCurrent < eyeLheightDefault && eyeLheightNext == eyeLheightDefault) { // Eyes are opening (stretch vertically, slight squash horizontally)
+    eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - (eyeLheightDefault - eyeLheightCurrent) / 8);
+  } else {
+    eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthNext); // Revert to next (default) width
+  }
+
+  // Right Eye (if not cyclops)
+  if (!cyclops) {
+    if (eyeRheightNext == 1) { // Eyes are closing (squash vertically, stretch horizontally)
+      eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault + (eyeRheightDefault - eyeRheightCurrent) / 4);
+    } else if (eyeRheightCurrent < eyeRheightDefault && eyeRheightNext == eyeRheightDefault) { // Eyes are opening (stretch vertically, slight squash horizontally)
+      eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault - (eyeRheightDefault - eyeRheightCurrent) / 8);
+    } else {
+      eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthNext); // Revert to next (default) width
+    }
+  } else {
+    eyeRwidthCurrent = 0; // Ensure right eye is fully closed in cyclops mode
+  }
+
+
+  // CURIOUS MODE SQUASH & STRETCH (additional to the default height offset)
+  // Modified: Only apply curious effects if sleepy or dizzy is not active.
+  if (effectiveCurious) {
+    // When looking left (left eye becomes taller/narrower, right eye wider)
+    if (eyeLxNext <= 10 && eyeLxNext < (getScreenConstraint_X()/2)) {
+      eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - eyeLheightOffset / 2); // Left eye: vertically stretched, horizontally squashed
+      if (!cyclops) {
+        eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault + eyeLheightOffset / 2); // Right eye: horizontally stretched
+      }
+    }
+    // When looking right (right eye becomes taller/narrower, left eye wider)
+    else if (!cyclops && eyeRxNext >= screenWidth - eyeRwidthDefault - 10 && eyeRxNext > (screenWidth / 2)) {
+      eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault - eyeRheightOffset / 2); // Right eye: vertically stretched, horizontally squashed
+      eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault + eyeRheightOffset / 2); // Left eye: horizontally stretched
+    } else if (cyclops && eyeLxNext >= (getScreenConstraint_X() - 10) && eyeLxNext > (getScreenConstraint_X()/2)) { // Cyclops looking right
+        eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - eyeLheightOffset / 2); // Left eye: vertically stretched, horizontally squashed
+    }
+    // If not in extreme left/right, smoothly transition back to default width
+    else {
+      eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthNext); eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthNext);
+    }
+  } else {
+    // Ensure widths revert to default if curious is off (or if sleepy/dizzy is on)
+    eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthNext); eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthNext);
+  }
+
+
+  // Space between eyes
+  spaceBetweenCurrent = tween(spaceBetweenCurrent, spaceBetweenNext); // *** FIX START: Corrected Eye Coordinates Smoothing ***
+  // These lines now simply smooth the current position towards the target 'Next' position
+  // The 'Next' positions are set by setPosition() and Idle Mode.
+  eyeLx = tween(eyeLx, eyeLxNext);
+  eyeLy = tween(eyeLy, eyeLyNext); // Right eye's x position depends on left eye's position + the space between
+  eyeRxNext = eyeLxNext + eyeLwidthCurrent + spaceBetweenCurrent; eyeRyNext = eyeLyNext; // right eye's y position should be the same as for the left eye
+
+  eyeRx = tween(eyeRx, eyeRxNext); eyeRy = tween(eyeRy, eyeRyNext);
+  // *** FIX END ***
+
+
+  // Left eye border radius
+  eyeLborderRadiusCurrent = tween(eyeLborderRadiusCurrent, eyeLborderRadiusNext); // Right eye border radius
+  eyeRborderRadiusCurrent = tween(eyeRborderRadiusCurrent, eyeRborderRadiusNext); //// APPLYING MACRO ANIMATIONS ////
+
+  if(autoblinker){
+    if(millis() >= blinktimer){
+    blink();
+    blinktimer = millis()+(blinkInterval*1000)+(random(blinkIntervalVariation)*1000); // calculate next time for blinking
+    }
+  }
+
+  // Laughing - eyes shaking up and down for the duration defined by laughAnimationDuration (default = 500ms)
+  if(laugh){
+    if(laughToggle){
+      setVFlicker(1, 5); // Activate vertical flicker for laugh
+      laughAnimationTimer = millis();
+      laughToggle = 0;
+    } else if(millis() >= laughAnimationTimer+laughAnimationDuration){
+      setVFlicker(0, 0); // Deactivate vertical flicker
+      laughToggle = 1;
+      laugh=0;
+    }
+  }
+
+  // Confused - eyes shaking left and right for the duration defined by confusedAnimationDuration (default = 500ms)
+  if(confused){
+    if(confusedToggle){
+      setHFlicker(1, 10); // Activate horizontal flicker for confused
+      confusedAnimationTimer = millis();
+      confusedToggle = 0;
+    } else if(millis() >= confusedAnimationTimer+confusedAnimationDuration){
+      setHFlicker(0, 0); // Deactivate horizontal flicker
+      confusedToggle = 1;
+      confused=0;
+    }
+  }
+
+  // Idle - eyes moving to random positions on screen
+  // Modified: Idle mode is paused when sleepy or dizzy is active.
+  if(idle && !sleepy && !dizzy){
+    if(millis() >= idleAnimationTimer){
+      // Store current positions before calculating new random ones for potential stretch/squash based on movement
+      int prevEyeLx = eyeLxNext; // Use eyeLxNext as previous target for direction
+      int prevEyeLy = eyeLyNext; // Use eyeLyNext as previous target for direction
+
+      eyeLxNext = random(getScreenConstraint_X() + 1); // +1 to ensure random reaches max boundary
+      eyeLyNext = random(getScreenConstraint_Y() + 1); // +1 to ensure random reaches max boundary
+
+      // Clamp eyeLxNext/eyeLyNext to within screen constraints
+      eyeLxNext = constrain(eyeLxNext, 0, getScreenConstraint_X()); eyeLyNext = constrain(eyeLyNext, 0, getScreenConstraint_Y());
+
+      // A very subtle squash/stretch for idle movement (optional, can be removed if too much)
+      int dx = abs(eyeLxNext - prevEyeLx); int dy = abs(eyeLyNext - prevEyeLy);
+
+      // Only apply stretch/squash if there's significant movement
+      if (dx > dy && dx > 2) { // More horizontal movement
+          eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault + dx / 20); // Slight horizontal stretch
+          eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightDefault - dx / 40); // Slight vertical squash
+          if (!cyclops) {
+              eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault + dx / 2); eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightDefault - dx / 4);
+          }
+      } else if (dy > dx && dy > 2) { // More vertical movement
+          eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightDefault + dy / 20); // Slight vertical stretch
+          eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - dy / 40); // Slight horizontal squash
+          if (!cyclops) {
+              eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightDefault + dy / 2); eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault - dy / 4);
+          }
+      } else { // If movement is small or mostly diagonal, ease back to default size
+          eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault); eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightDefault);
+          if (!cyclops) {
+            eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault); eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightDefault);
+          }
+      }
+
+      idleAnimationTimer = millis()+(idleInterval*1000)+(random(idleIntervalVariation)*1000); // calculate next time for eyes repositioning
+    }
+  }
+
+
+  // Adding offsets for horizontal flickering/shivering (with squash and stretch)
+  if(hFlicker){
+    if(hFlickerAlternate) {
+      eyeLx += hFlickerAmplitude; eyeRx += hFlickerAmplitude;
+      // Apply squash-stretch for horizontal movement
+      eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - hFlickerAmplitude); eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightDefault + hFlickerAmplitude / 2);
+      if (!cyclops) {
+        eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault - hFlickerAmplitude); eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightDefault + hFlickerAmplitude / 2);
+      }
+    } else {
+      eyeLx -= hFlickerAmplitude;
+      eyeRx -= hFlickerAmplitude; // Apply squash-stretch for horizontal movement
+      eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - hFlickerAmplitude); eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightDefault + hFlickerAmplitude / 2);
+      if (!cyclops) {
+        eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault - hFlickerAmplitude); eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightDefault + hFlickerAmplitude / 2);
+      }
+    }
+    if (flickerStep) hFlickerAlternate = !hFlickerAlternate;
+  }
+
+  // Adding offsets for vertical flickering/shivering (with squash and stretch)
+  if(vFlicker){
+    if(vFlickerAlternate) {
+      eyeLy += vFlickerAmplitude; eyeRy += vFlickerAmplitude;
+      // Apply squash-stretch for vertical movement
+      eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightDefault + vFlickerAmplitude); eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - vFlickerAmplitude / 2);
+      if (!cyclops) {
+        eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightDefault + vFlickerAmplitude); eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault - vFlickerAmplitude / 2);
+      }
+    } else {
+      eyeLy -= vFlickerAmplitude;
+      eyeRy -= vFlickerAmplitude; // Apply squash-stretch for vertical movement
+      eyeLheightCurrent = tween(eyeLheightCurrent, eyeLheightDefault + vFlickerAmplitude); eyeLwidthCurrent = tween(eyeLwidthCurrent, eyeLwidthDefault - vFlickerAmplitude / 2);
+      if (!cyclops) {
+        eyeRheightCurrent = tween(eyeRheightCurrent, eyeRheightDefault + vFlickerAmplitude); eyeRwidthCurrent = tween(eyeRwidthCurrent, eyeRwidthDefault - vFlickerAmplitude / 2);
+      }
+    }
+    if (flickerStep) vFlickerAlternate = !vFlickerAlternate;
+  }
+
+  // Recalculate eye positions for centering after size changes (must be done near the end of pre-calculations)
+  // These adjust the eyeLx/y and eyeRx/y *before* the final draw to keep them centered
+  eyeLx += (eyeLwidthDefault - eyeLwidthCurrent) / 2; eyeLy += (eyeLheightDefault - eyeLheightCurrent) / 2;
+  if (!cyclops) {
+    eyeRx += (eyeRwidthDefault - eyeRwidthCurrent) / 2; eyeRy += (eyeRheightDefault - eyeRheightCurrent) / 2;
+  }
+
+
+  // Cyclops mode, set second eye's size and space between to 0
+  if(cyclops){
+    eyeRwidthCurrent = 0; eyeRheightCurrent = 0;
+    spaceBetweenCurrent = 0;
+  }
+
+
+  //// MOOD STATE ////
+
+  // Handle SLEEPY mood logic before drawing eyes and eyelids
+  if (sleepy) {
+    if (millis() >= sleepyAnimationTimer) {
+      // Toggle between tired and normal eyes
+      sleepyNormalEyes = !sleepyNormalEyes; // Set the next timer for a normal eye appearance (short) or tired (longer)
+      if (sleepyNormalEyes) {
+        // Brief moment of normal eyes
+        eyelidsTiredHeightNext = 0; // Temporarily turn off tired eyelids
+        eyeLheightNext = eyeLheightDefault;
+        eyeRheightNext = eyeRheightDefault; sleepyAnimationTimer = millis() + 500; // Normal eyes for 500ms
+      } else {
+        // Longer period of tired eyes
+        eyelidsTiredHeightNext = eyeLheightDefault / 2; // Apply tired eyelids
+        eyeLheightNext = eyeLheightDefault / 2; // Make eyes appear more tired (half open)
+        eyeRheightNext = eyeRheightDefault / 2; sleepyAnimationTimer = millis() + (sleepyInterval * 1000) + (random(sleepyIntervalVariation) * 1000);
+      }
+    }
+  }
+
+  // Handle DIZZY mood logic
+  if (dizzy) {
+    if (millis() < dizzyAnimationTimer) {
+      // Calculate compaction
+      eyeLwidthCurrent = (eyeLwidthDefault - dizzyEyeCompactionWidth);
+      eyeLheightCurrent = (eyeLheightDefault - dizzyEyeCompactionHeight);
+      eyeRwidthCurrent = (eyeRwidthDefault - dizzyEyeCompactionWidth);
+      eyeRheightCurrent = (eyeRheightDefault - dizzyEyeCompactionHeight);
+
+      // Calculate circular path
+      float centerX = (screenWidth / 2) - (eyeLwidthCurrent / 2);
+      float centerY = (screenHeight / 2) - (eyeLheightCurrent / 2);
+
+      // Left eye clockwise
+      eyeLx = centerX + dizzyRadius * cos(dizzyAngle);
+      eyeLy = centerY + dizzyRadius * sin(dizzyAngle);
+
+      // Right eye anticlockwise, relative to its own center
+      float rightCenterX = (screenWidth / 2) + (eyeLwidthCurrent / 2) + spaceBetweenDefault; // Approx center for right eye
+      eyeRx = rightCenterX + dizzyRadius * cos(-dizzyAngle);
+      eyeRy = centerY + dizzyRadius * sin(-dizzyAngle);
+
+      dizzyAngle += 0.1f * frameElapsed / ROBOEYES_REFERENCE_FRAME_MS; // 0.1 rad per 20 ms (adjust as needed)
+      if (dizzyAngle > 2 * PI) dizzyAngle -= 2 * PI; // Keep angle within 0-2PI
+    } else {
+      // Dizzy animation finished, reset to default state
+      dizzy = 0;
+      eyeLwidthCurrent = eyeLwidthDefault;
+      eyeLheightCurrent = eyeLheightDefault;
+      eyeRwidthCurrent = eyeRwidthDefault;
+      eyeRheightCurrent = eyeRheightDefault;
+      // Also reset eye positions to default or last non-dizzy position
+      eyeLxNext = eyeLxDefault;
+      eyeLyNext = eyeLyDefault;
+      eyeRxNext = eyeRxDefault;
+      eyeRyNext = eyeRyDefault;
+    }
+  }
+
+
+  // Prepare mood type transitions
+  // If sleepyNormalEyes is true, eyelidsTiredHeightNext will already be 0 from sleepy logic.
+  // Otherwise, apply tired or angry based on state, ensuring dizzy also clears them.
+  if (tired && !sleepy && !dizzy){eyelidsTiredHeightNext = eyeLheightCurrent/2; eyelidsAngryHeightNext = 0;} else if (!sleepyNormalEyes && !sleepy && !dizzy) {eyelidsTiredHeightNext = 0;}
+  if (angry && !sleepy && !dizzy){eyelidsAngryHeightNext = eyeLheightCurrent/2; eyelidsTiredHeightNext = 0;} else if (!sleepyNormalEyes && !sleepy && !dizzy) {eyelidsAngryHeightNext = 0;}
+  if (happy && !sleepy && !dizzy){eyelidsHappyBottomOffsetNext = eyeLheightCurrent/2;} else if (!sleepyNormalEyes && !sleepy && !dizzy) {eyelidsHappyBottomOffsetNext = 0;}
+
+  // Eyelid tweenings
+  eyelidsTiredHeight = tween(eyelidsTiredHeight, eyelidsTiredHeightNext);
+  eyelidsAngryHeight = tween(eyelidsAngryHeight, eyelidsAngryHeightNext);
+  eyelidsHappyBottomOffset = tween(eyelidsHappyBottomOffset, eyelidsHappyBottomOffsetNext);
+
+
+  //// CHANGE DETECTION ////
+
+  EyeFrame frame = {eyeLx, eyeLy, eyeLwidthCurrent, eyeLheightCurrent, eyeLborderRadiusCurrent,
+                    eyeRx, eyeRy, eyeRwidthCurrent, eyeRheightCurrent, eyeRborderRadiusCurrent,
+                    eyelidsTiredHeight, eyelidsAngryHeight, eyelidsHappyBottomOffset, cyclops};
+
+  if (lastFrameValid && sameFrame(frame, lastFrame)) {
+    // Tweening has converged and nothing moved: skip the clear, the drawing and the display push
+    frameChanged = false;
+    framesSkipped++;
+    return;
+  }
+
+  // Dirty region: everything lit in the previous frame (to erase it) plus everything lit now
+  if (lastFrameValid) {
+    int x0 = screenWidth, y0 = screenHeight, x1 = -1, y1 = -1;
+    addFrameBounds(lastFrame, x0, y0, x1, y1);
+    addFrameBounds(frame, x0, y0, x1, y1);
+    x0 = max(x0, 0); y0 = max(y0, 0);
+    x1 = min(x1, screenWidth - 1); y1 = min(y1, screenHeight - 1);
+    if (x1 < x0 || y1 < y0) { x0 = 0; y0 = 0; x1 = 0; y1 = 0; } // nothing visible, push a single byte
+    dirtyColumnFirst = x0; dirtyColumnLast = x1;
+    dirtyPageFirst = y0 / 8; dirtyPageLast = y1 / 8;
+  } else {
+    // No previous frame known: full screen
+    dirtyColumnFirst = 0; dirtyColumnLast = screenWidth - 1;
+    dirtyPageFirst = 0; dirtyPageLast = (screenHeight - 1) / 8;
+  }
+  lastFrame = frame;
+  lastFrameValid = true;
+  frameChanged = true;
+  framesDrawn++;
+
+  if (!display) return;
+
+
+  //// ACTUAL DRAWINGS ////
+
+  // Only the dirty pages need clearing, the rest of the framebuffer still holds the previous frame.
+  display->fillRect(dirtyColumnFirst, dirtyPageFirst*8, dirtyColumnLast-dirtyColumnFirst+1, (dirtyPageLast-dirtyPageFirst+1)*8, BGCOLOR);
+
+  drawEye(frame.lx, frame.ly, frame.lw, frame.lh, frame.lr, frame.tired, frame.angry, frame.happy, true, frame.cyclops); // left eye
+  if (!frame.cyclops){
+    drawEye(frame.rx, frame.ry, frame.rw, frame.rh, frame.rr, frame.tired, frame.angry, frame.happy, false, false); // right eye
+  }
+
+  // Push only the dirty pages and columns to the display
+  display->push(dirtyPageFirst, dirtyPageLast, dirtyColumnFirst, dirtyColumnLast);
+
+} // end of drawEyes method
+
+
+// Draws one eye, from the sprite cache if enabled and the backend can blit
+void drawEye(int x, int y, int w, int h, byte r, byte tiredHeight, byte angryHeight, byte happyOffset, bool leftEye, bool cyclopsEye){
+#if ROBOEYES_SPRITE_CACHE_BYTES > 0
+  bool rendered;
+  uint8_t *sprite = spriteCache.lookup(RoboEyesSpriteCache::makeKey(w, h, r, tiredHeight, angryHeight, happyOffset, leftEye, cyclopsEye), w, h, rendered);
+  if (sprite) {
+    if (!rendered) {
+      // Eyelids only clear pixels, so everything lit lies inside the w x h eye rectangle
+      RoboEyesPageBuffer target(sprite, w, h);
+      rasterEye(target, 0, 0, w, h, r, tiredHeight, angryHeight, happyOffset, leftEye, cyclopsEye);
+    }
+    if (display->blit(sprite, w, h, x, y)) return;
+  }
+#endif
+  rasterEye(*display, x, y, w, h, r, tiredHeight, angryHeight, happyOffset, leftEye, cyclopsEye);
+}
+
+// Draws one eye including its eyelids at (x, y). The shape only depends on the arguments,
+// the left eye gets the mirrored eyelids of the right one.
+void rasterEye(RoboEyesDisplay &target, int x, int y, int w, int h, byte r, byte tiredHeight, byte angryHeight, byte happyOffset, bool leftEye, bool cyclopsEye){
+  // Draw basic eye rectangle
+  target.fillRoundRect(x, y, w, h, r, MAINCOLOR);
+
+  // Draw tired top eyelids
+  if (tiredHeight > 0){
+    if (!cyclopsEye){
+      if (leftEye) target.fillTriangle(x, y-1, x+w, y-1, x, y+tiredHeight-1, BGCOLOR);
+      else target.fillTriangle(x, y-1, x+w, y-1, x+w, y+tiredHeight-1, BGCOLOR);
+    } else {
+      // Cyclops tired eyelids
+      target.fillTriangle(x, y-1, x+(w/2), y-1, x, y+tiredHeight-1, BGCOLOR); // left eyelid half
+      target.fillTriangle(x+(w/2), y-1, x+w, y-1, x+(w/2), y+tiredHeight-1, BGCOLOR); // right eyelid half
+    }
+  }
+
+  // Draw angry top eyelids
+  if (angryHeight > 0){
+    if (!cyclopsEye){
+      if (leftEye) target.fillTriangle(x, y-1, x+w, y-1, x+w, y+angryHeight-1, BGCOLOR);
+      else target.fillTriangle(x, y-1, x+w, y-1, x, y+angryHeight-1, BGCOLOR);
+    } else {
+      // Cyclops angry eyelids
+      target.fillTriangle(x, y-1, x+(w/2), y-1, x+(w/2), y+angryHeight-1, BGCOLOR); // left eyelid half
+      target.fillTriangle(x+(w/2), y-1, x+w, y-1, x+(w/2), y+angryHeight-1, BGCOLOR); // right eyelid half
+    }
+  }
+
+  // Draw happy bottom eyelids
+  // For happy, make sure it applies to the current eye height, not just default height
+  if (happyOffset > 0){
+    target.fillRoundRect(x-1, (y+h)-happyOffset+1, w+2, h+2, r, BGCOLOR);
+  }
+}
+
+
+}; // end of class roboEyes
+
+#endif
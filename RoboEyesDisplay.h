@@ -0,0 +1,424 @@
+/*
+ * RoboEyesDisplay.h - display backends for FluxGarage RoboEyes
+ * roboEyes only needs a handful of primitives: filled rounded rectangles, filled
+ * triangles, clearing a region and pushing a range of pages to the panel. This file
+ * defines that interface plus a rasterizer that writes straight into a 1-bpp
+ * SSD1306 page-layout buffer (byte = 8 vertical pixels, buffer[page * width + x]),
+ * so no per-pixel drawPixel() calls are involved.
+ */
+
+#ifndef _ROBOEYES_DISPLAY_H
+#define _ROBOEYES_DISPLAY_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+// Largest panel supported by the built-in buffers
+#ifndef ROBOEYES_MAX_WIDTH
+#define ROBOEYES_MAX_WIDTH 128
+#endif
+#ifndef ROBOEYES_MAX_HEIGHT
+#define ROBOEYES_MAX_HEIGHT 64
+#endif
+#define ROBOEYES_BUFFER_BYTES (ROBOEYES_MAX_WIDTH * ((ROBOEYES_MAX_HEIGHT + 7) / 8))
+
+// Data bytes per I2C transaction; the control byte takes one more slot in the Wire buffer
+#if defined(ESP32)
+#define ROBOEYES_I2C_CHUNK 64
+#else
+#define ROBOEYES_I2C_CHUNK 31
+#endif
+
+// Display task used by RoboEyesAsyncDisplay. It only waits on the bus, so a low priority is enough.
+#ifndef ROBOEYES_DISPLAY_TASK_PRIORITY
+#define ROBOEYES_DISPLAY_TASK_PRIORITY 1
+#endif
+#ifndef ROBOEYES_DISPLAY_TASK_CORE
+#define ROBOEYES_DISPLAY_TASK_CORE 1
+#endif
+#define ROBOEYES_DISPLAY_TASK_STACK 2048
+
+
+//*********************************************************************************************
+//     Backend interface
+//*********************************************************************************************
+
+// Colors are BGCOLOR (0) and MAINCOLOR (1). Coordinates may lie outside the screen, backends clip.
+class RoboEyesDisplay
+{
+public:
+  virtual ~RoboEyesDisplay() {}
+
+  // Prepare the panel for a width x height frame, returns false if it cannot be driven
+  virtual bool begin(int /*width*/, int /*height*/) { return true; }
+  virtual void fillRect(int x, int y, int w, int h, uint8_t color) = 0;
+  virtual void fillRoundRect(int x, int y, int w, int h, int r, uint8_t color) = 0;
+  virtual void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, uint8_t color) = 0;
+  // Send pages firstPage..lastPage, columns firstColumn..lastColumn (inclusive) to the panel
+  virtual void push(int firstPage, int lastPage, int firstColumn, int lastColumn) = 0;
+  // Called once per roboEyes::update(), for backends that have background work to do
+  virtual void service() {}
+  // OR a w x h sprite in page layout (sprite[page * w + column]) into the frame at (x, y).
+  // Returns false if the backend cannot blit, roboEyes then draws the shapes instead.
+  virtual bool blit(const uint8_t * /*sprite*/, int /*w*/, int /*h*/, int /*x*/, int /*y*/) { return false; }
+};
+
+
+//*********************************************************************************************
+//     Page buffer rasterizer
+//*********************************************************************************************
+
+// Rasterizes into an SSD1306 page-layout buffer. Because one byte covers 8 vertical pixels,
+// shapes are filled as vertical spans per column: a span touches one byte per page with a
+// single mask, instead of one bit in each of many bytes as a horizontal scanline would.
+class RoboEyesPageBuffer : public RoboEyesDisplay
+{
+public:
+  uint8_t *buffer = nullptr; // width * pages bytes
+  int width = 0; // in pixels
+  int height = 0; // in pixels
+
+  RoboEyesPageBuffer() {}
+  RoboEyesPageBuffer(uint8_t *buf, int w, int h) : buffer(buf), width(w), height(h) {}
+
+  bool begin(int w, int h) override {
+    width = w; height = h;
+    return buffer != nullptr;
+  }
+
+  // Buffer only, nothing to transfer
+  void push(int /*firstPage*/, int /*lastPage*/, int /*firstColumn*/, int /*lastColumn*/) override {}
+
+  int pages() const { return (height + 7) / 8; }
+
+  // Fill rows y0..y1 (inclusive) of column x, clipped
+  void fillColumn(int x, int y0, int y1, uint8_t color) {
+    if (x < 0 || x >= width) return;
+    if (y0 < 0) y0 = 0;
+    if (y1 >= height) y1 = height - 1;
+    if (y1 < y0) return;
+    int page = y0 >> 3;
+    int lastPage = y1 >> 3;
+    uint8_t *p = buffer + page * width + x;
+    uint8_t firstMask = 0xFF << (y0 & 7);
+    uint8_t lastMask = 0xFF >> (7 - (y1 & 7));
+    if (page == lastPage) {
+      setBits(p, firstMask & lastMask, color);
+      return;
+    }
+    setBits(p, firstMask, color);
+    for (p += width, page++; page < lastPage; p += width, page++) {
+      *p = color ? 0xFF : 0x00;
+    }
+    setBits(p, lastMask, color);
+  }
+
+  void fillRect(int x, int y, int w, int h, uint8_t color) override {
+    if (w <= 0 || h <= 0) return;
+    int x1 = x + w;
+    if (x < 0) x = 0;
+    if (x1 > width) x1 = width;
+    for (; x < x1; x++) fillColumn(x, y, y + h - 1, color);
+  }
+
+  // Same layout as Adafruit_GFX::fillRoundRect(): straight middle part plus quarter circles
+  // of radius r centered r pixels in from each corner
+  void fillRoundRect(int x, int y, int w, int h, int r, uint8_t color) override {
+    if (w <= 0 || h <= 0) return;
+    int maxRadius = ((w < h) ? w : h) / 2;
+    if (r > maxRadius) r = maxRadius;
+    if (r < 0) r = 0;
+    for (int i = 0; i < w; i++) {
+      int cx = x + i;
+      if (cx < 0 || cx >= width) continue;
+      int edge = (i < r) ? i : (w - 1 - i); // distance from the nearer side
+      int inset = 0;
+      if (edge < r) {
+        int dx = r - edge;
+        inset = r - isqrt(r * r - dx * dx);
+      }
+      fillColumn(cx, y + inset, y + h - 1 - inset, color);
+    }
+  }
+
+  // Per column, the triangle covers the span between the lowest and highest edge crossing
+  void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, uint8_t color) override {
+    int minX = min(x0, min(x1, x2));
+    int maxX = max(x0, max(x1, x2));
+    if (minX < 0) minX = 0;
+    if (maxX >= width) maxX = width - 1;
+    for (int x = minX; x <= maxX; x++) {
+      int top = 32767, bottom = -32768;
+      edgeSpan(x, x0, y0, x1, y1, top, bottom);
+      edgeSpan(x, x1, y1, x2, y2, top, bottom);
+      edgeSpan(x, x2, y2, x0, y0, top, bottom);
+      if (bottom >= top) fillColumn(x, top, bottom, color);
+    }
+  }
+
+  // A sprite page straddles two frame pages unless y is a multiple of 8, so each sprite byte
+  // is shifted into the lower part of one page and the upper part of the next
+  bool blit(const uint8_t *sprite, int w, int h, int x, int y) override {
+    int spritePages = (h + 7) / 8;
+    int shift = y & 7; // also correct for negative y in two's complement
+    int firstPage = (y - shift) / 8;
+    int framePages = pages();
+    for (int c = 0; c < w; c++) {
+      int dx = x + c;
+      if (dx < 0 || dx >= width) continue;
+      for (int p = 0; p < spritePages; p++) {
+        uint8_t bits = sprite[p * w + c];
+        if (!bits) continue;
+        int page = firstPage + p;
+        if (page >= 0 && page < framePages) buffer[page * width + dx] |= bits << shift;
+        if (shift && page + 1 >= 0 && page + 1 < framePages) buffer[(page + 1) * width + dx] |= bits >> (8 - shift);
+      }
+    }
+    return true;
+  }
+
+private:
+  static void setBits(uint8_t *p, uint8_t mask, uint8_t color) {
+    if (color) *p |= mask; else *p &= ~mask;
+  }
+
+  // Grows top/bottom by where edge (xa,ya)-(xb,yb) crosses column x
+  static void edgeSpan(int x, int xa, int ya, int xb, int yb, int &top, int &bottom) {
+    if (xa > xb) { int t = xa; xa = xb; xb = t; t = ya; ya = yb; yb = t; }
+    if (x < xa || x > xb) return;
+    if (xa == xb) { // vertical edge: both end points are on this column
+      top = min(top, min(ya, yb));
+      bottom = max(bottom, max(ya, yb));
+      return;
+    }
+    int y = ya + ((yb - ya) * (x - xa) + (xb - xa) / 2) / (xb - xa);
+    top = min(top, y);
+    bottom = max(bottom, y);
+  }
+
+  static int isqrt(int value) {
+    int root = 0;
+    while ((root + 1) * (root + 1) <= value) root++;
+    return root;
+  }
+};
+
+
+//*********************************************************************************************
+//     SSD1306 over I2C
+//*********************************************************************************************
+
+// Owns its framebuffer and talks to the panel directly. push() sets the column and page
+// address window first, so only the dirty rectangle goes over the bus.
+class RoboEyesSSD1306 : public RoboEyesPageBuffer
+{
+public:
+  RoboEyesSSD1306(TwoWire &wire = Wire, uint8_t address = 0x3C) : _wire(wire), _address(address) {
+    buffer = _frame;
+  }
+
+  bool begin(int w, int h) override {
+    if (w > ROBOEYES_MAX_WIDTH || h > ROBOEYES_MAX_HEIGHT) return false;
+    RoboEyesPageBuffer::begin(w, h);
+    memset(_frame, 0, sizeof(_frame));
+    const uint8_t init[] = {
+      0xAE,                         // display off
+      0xD5, 0x80,                   // clock divide ratio / oscillator frequency
+      0xA8, (uint8_t)(h - 1),       // multiplex ratio
+      0xD3, 0x00,                   // display offset
+      0x40,                         // start line 0
+      0x8D, 0x14,                   // charge pump on
+      0x20, 0x00,                   // horizontal addressing mode
+      0xA1,                         // segment remap, column 127 is SEG0
+      0xC8,                         // COM scan direction remapped
+      0xDA, (uint8_t)(h == 64 ? 0x12 : 0x02), // COM pins hardware configuration
+      0x81, 0xCF,                   // contrast
+      0xD9, 0xF1,                   // pre-charge period
+      0xDB, 0x40,                   // VCOMH deselect level
+      0xA4,                         // output follows RAM
+      0xA6,                         // normal, not inverted
+      0x2E,                         // scrolling off
+      0xAF                          // display on
+    };
+    if (!sendCommands(init, sizeof(init))) return false;
+    push(0, pages() - 1, 0, width - 1);
+    return true;
+  }
+
+  void push(int firstPage, int lastPage, int firstColumn, int lastColumn) override {
+    const uint8_t window[] = {
+      0x21, (uint8_t)firstColumn, (uint8_t)lastColumn, // column address range
+      0x22, (uint8_t)firstPage, (uint8_t)lastPage      // page address range
+    };
+    if (!sendCommands(window, sizeof(window))) return;
+    // The panel advances through the window row by row, so the bytes go out in the same order
+    int columns = lastColumn - firstColumn + 1;
+    for (int page = firstPage; page <= lastPage; page++) {
+      const uint8_t *row = buffer + page * width + firstColumn;
+      for (int sent = 0; sent < columns; ) {
+        int n = min(ROBOEYES_I2C_CHUNK, columns - sent);
+        _wire.beginTransmission(_address);
+        _wire.write((uint8_t)0x40); // Co = 0, D/C = 1: data stream follows
+        _wire.write(row + sent, n);
+        _wire.endTransmission();
+        sent += n;
+      }
+    }
+  }
+
+private:
+  TwoWire &_wire;
+  uint8_t _address;
+  uint8_t _frame[ROBOEYES_BUFFER_BYTES];
+
+  bool sendCommands(const uint8_t *cmds, size_t len) {
+    _wire.beginTransmission(_address);
+    _wire.write((uint8_t)0x00); // Co = 0, D/C = 0: command stream follows
+    _wire.write(cmds, len);
+    return _wire.endTransmission() == 0;
+  }
+};
+
+
+//*********************************************************************************************
+//     Adafruit_SSD1306 wrapper
+//*********************************************************************************************
+
+// Only available if Adafruit_SSD1306.h was included before this file. Rasterizes straight into
+// the library's buffer; Adafruit_SSD1306::display() always sends the whole frame, so the page
+// range is ignored.
+#ifdef _Adafruit_SSD1306_H_
+class RoboEyesAdafruitSSD1306 : public RoboEyesPageBuffer
+{
+public:
+  RoboEyesAdafruitSSD1306(Adafruit_SSD1306 &oled) : _oled(oled) {}
+
+  bool begin(int w, int h) override {
+    buffer = _oled.getBuffer();
+    return RoboEyesPageBuffer::begin(w, h);
+  }
+
+  void push(int firstPage, int lastPage, int firstColumn, int lastColumn) override {
+    _oled.display();
+  }
+
+private:
+  Adafruit_SSD1306 &_oled;
+};
+#endif
+
+
+//*********************************************************************************************
+//     Double-buffered asynchronous push
+//*********************************************************************************************
+
+// roboEyes renders into this object's back buffer. push() only copies the dirty window into the
+// target's buffer (the front buffer) and wakes a display task that streams it to the panel, so
+// the caller of roboEyes::update() never waits for the bus. While a transfer is still running,
+// further dirty windows are merged and copied once the display task is idle again, on the next
+// push() or service() call. On other platforms push() falls back to a synchronous transfer.
+//
+// RoboEyesSSD1306 sends the frame in chunks of ROBOEYES_I2C_CHUNK bytes. The ESP32 Wire driver
+// locks the bus per transaction, so other devices on the same bus (e.g. the MPU-6050) get
+// their transfers in between chunks. The async push hides the transfer from the renderer, not
+// from the bus: at the 100 kHz default a full 1 KB frame takes ~90 ms, so set the bus to
+// 400 kHz with Wire.setClock() when the panel shares it with a sensor.
+class RoboEyesAsyncDisplay : public RoboEyesPageBuffer
+{
+public:
+  unsigned long framesPushed = 0; // transfers handed to the display task
+  unsigned long framesMerged = 0; // dirty windows merged because a transfer was still running
+
+  RoboEyesAsyncDisplay(RoboEyesPageBuffer &target) : _target(target) {
+    buffer = _back;
+  }
+
+  bool begin(int w, int h) override {
+    if (w > ROBOEYES_MAX_WIDTH || h > ROBOEYES_MAX_HEIGHT) return false;
+    if (!_target.begin(w, h)) return false; // synchronous, before the task exists
+    RoboEyesPageBuffer::begin(w, h);
+    memcpy(_back, _target.buffer, (size_t)w * pages());
+    _hasPending = false;
+#if defined(ESP32)
+    if (_task == NULL) {
+      xTaskCreatePinnedToCore(displayTask, "RoboEyesPush", ROBOEYES_DISPLAY_TASK_STACK, this,
+                              ROBOEYES_DISPLAY_TASK_PRIORITY, &_task, ROBOEYES_DISPLAY_TASK_CORE);
+      if (_task == NULL) return false;
+    }
+#endif
+    return true;
+  }
+
+  void push(int firstPage, int lastPage, int firstColumn, int lastColumn) override {
+    if (_hasPending) {
+      _pendingFirstPage = min(_pendingFirstPage, firstPage); _pendingLastPage = max(_pendingLastPage, lastPage);
+      _pendingFirstColumn = min(_pendingFirstColumn, firstColumn); _pendingLastColumn = max(_pendingLastColumn, lastColumn);
+      framesMerged++;
+    } else {
+      _pendingFirstPage = firstPage; _pendingLastPage = lastPage;
+      _pendingFirstColumn = firstColumn; _pendingLastColumn = lastColumn;
+      _hasPending = true;
+    }
+    flush();
+  }
+
+  // Hands over a merged window once the previous transfer has finished
+  void service() override {
+    flush();
+  }
+
+  // True while the display task is sending a frame
+  bool busy() const { return _busy; }
+
+private:
+  RoboEyesPageBuffer &_target;
+  uint8_t _back[ROBOEYES_BUFFER_BYTES];
+  bool _hasPending = false;
+  int _pendingFirstPage = 0, _pendingLastPage = 0, _pendingFirstColumn = 0, _pendingLastColumn = 0;
+  // Window the display task is sending; only written while _busy is false
+  int _sendFirstPage = 0, _sendLastPage = 0, _sendFirstColumn = 0, _sendLastColumn = 0;
+  volatile bool _busy = false;
+#if defined(ESP32)
+  TaskHandle_t _task = NULL;
+#endif
+
+  // The front buffer is only touched while the display task is idle
+  void flush() {
+    if (!_hasPending || _busy) return;
+#if defined(ESP32)
+    if (_task == NULL) return; // begin() failed, there is no display task to hand the frame to
+#endif
+    int columns = _pendingLastColumn - _pendingFirstColumn + 1;
+    for (int page = _pendingFirstPage; page <= _pendingLastPage; page++) {
+      int offset = page * width + _pendingFirstColumn;
+      memcpy(_target.buffer + offset, _back + offset, columns);
+    }
+    _sendFirstPage = _pendingFirstPage; _sendLastPage = _pendingLastPage;
+    _sendFirstColumn = _pendingFirstColumn; _sendLastColumn = _pendingLastColumn;
+    _hasPending = false;
+    framesPushed++;
+#if defined(ESP32)
+    _busy = true;
+    xTaskNotifyGive(_task);
+#else
+    _target.push(_sendFirstPage, _sendLastPage, _sendFirstColumn, _sendLastColumn);
+#endif
+  }
+
+#if defined(ESP32)
+  static void displayTask(void *arg) {
+    RoboEyesAsyncDisplay *self = (RoboEyesAsyncDisplay *)arg;
+    for (;;) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      self->_target.push(self->_sendFirstPage, self->_sendLastPage, self->_sendFirstColumn, self->_sendLastColumn);
+      self->_busy = false;
+    }
+  }
+#endif
+};
+
+#endif
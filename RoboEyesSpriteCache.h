@@ -0,0 +1,82 @@
+/*
+ * RoboEyesSpriteCache.h - cache of pre-rendered eye sprites for FluxGarage RoboEyes
+ * An eye with its eyelids only depends on a few parameters (size, border radius, eyelid
+ * heights, which side). Once the tweens have settled, the same shapes are drawn every frame,
+ * so they are rendered once into 1-bpp page-layout bitmaps and blitted from then on.
+ * The arena has a fixed size set at build time and is split into equal slots, the least
+ * recently used slot is evicted on a miss.
+ */
+
+#ifndef _ROBOEYES_SPRITE_CACHE_H
+#define _ROBOEYES_SPRITE_CACHE_H
+
+#include <Arduino.h>
+
+// Arena size in bytes; 0 disables the cache. A default 36x36 eye takes 36 * 5 = 180 bytes.
+#ifndef ROBOEYES_SPRITE_CACHE_BYTES
+#define ROBOEYES_SPRITE_CACHE_BYTES 0
+#endif
+#ifndef ROBOEYES_SPRITE_CACHE_SLOTS
+#define ROBOEYES_SPRITE_CACHE_SLOTS 8
+#endif
+#define ROBOEYES_SPRITE_SLOT_BYTES (ROBOEYES_SPRITE_CACHE_BYTES / ROBOEYES_SPRITE_CACHE_SLOTS)
+
+#if ROBOEYES_SPRITE_CACHE_BYTES > 0
+class RoboEyesSpriteCache
+{
+public:
+  unsigned long hits = 0;
+  unsigned long misses = 0;
+  unsigned long uncacheable = 0; // sprites larger than a slot, drawn directly
+
+  // Packs the parameters into a key, returns 0 if they cannot be represented (never a valid key,
+  // since width and height are at least 1)
+  static uint64_t makeKey(int w, int h, byte r, byte tired, byte angry, byte happy, bool leftEye, bool cyclopsEye) {
+    if (w <= 0 || h <= 0 || w > 255 || h > 255) return 0;
+    return (uint64_t)w | ((uint64_t)h << 8) | ((uint64_t)r << 16) | ((uint64_t)tired << 24) |
+           ((uint64_t)angry << 32) | ((uint64_t)happy << 40) |
+           ((uint64_t)((leftEye ? 1 : 0) | (cyclopsEye ? 2 : 0)) << 48);
+  }
+
+  // Returns the slot for key, or nullptr if a w x h sprite does not fit a slot. On a miss the
+  // least recently used slot is claimed and cleared, rendered is set to false and the caller
+  // has to draw the sprite into it.
+  uint8_t *lookup(uint64_t key, int w, int h, bool &rendered) {
+    size_t bytes = (size_t)w * ((h + 7) / 8);
+    if (key == 0 || bytes > ROBOEYES_SPRITE_SLOT_BYTES) {
+      uncacheable++;
+      return nullptr;
+    }
+    _clock++;
+    int victim = 0;
+    for (int i = 0; i < ROBOEYES_SPRITE_CACHE_SLOTS; i++) {
+      if (_keys[i] == key) {
+        _lastUse[i] = _clock;
+        hits++;
+        rendered = true;
+        return _arena[i];
+      }
+      if (_lastUse[i] < _lastUse[victim]) victim = i;
+    }
+    misses++;
+    _keys[victim] = key;
+    _lastUse[victim] = _clock;
+    memset(_arena[victim], 0, bytes);
+    rendered = false;
+    return _arena[victim];
+  }
+
+  // Drops all sprites, e.g. after the rasterizer changed
+  void clear() {
+    for (int i = 0; i < ROBOEYES_SPRITE_CACHE_SLOTS; i++) { _keys[i] = 0; _lastUse[i] = 0; }
+  }
+
+private:
+  uint8_t _arena[ROBOEYES_SPRITE_CACHE_SLOTS][ROBOEYES_SPRITE_SLOT_BYTES];
+  uint64_t _keys[ROBOEYES_SPRITE_CACHE_SLOTS] = {0};
+  uint32_t _lastUse[ROBOEYES_SPRITE_CACHE_SLOTS] = {0};
+  uint32_t _clock = 0;
+};
+#endif
+
+#endif
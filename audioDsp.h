@@ -0,0 +1,340 @@
+// audioDsp.h - Block-based audio kernels for the A2DP source path
+// A2DP wants 44.1 kHz 16-bit stereo. TTS engines, and effects in the style of
+// r2d2noice.py, produce 16, 22.05 or 24 kHz mono. This module bridges the gap:
+//  - PolyphaseResampler: any rate to DSP_OUTPUT_RATE with a windowed-sinc FIR of
+//    RESAMPLER_TAPS taps. Fractional positions are quantized to RESAMPLER_PHASES phases,
+//    so the coefficient table is 1 KB for every ratio.
+//  - ChirpOscillator: R2D2 chirps from a phase accumulator and a sine table. The pitch
+//    contour is recomputed every DSP_CONTROL_SAMPLES samples, so the per-sample loop is
+//    only table lookups and adds.
+//  - audioMix() / audioMonoToStereo(): a saturating mixer for effects over speech, and
+//    the mono to stereo step for the A2DP buffer.
+// Everything works on whole blocks in fixed point with no allocation. Floating point is
+// only used when a filter or a chirp is set up, never per sample.
+
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include <Arduino.h>
+
+#define DSP_OUTPUT_RATE 44100
+#define RESAMPLER_TAPS 8
+#define RESAMPLER_PHASE_BITS 6
+#define RESAMPLER_PHASES (1 << RESAMPLER_PHASE_BITS)
+#define RESAMPLER_BLOCK 256            // input samples filtered per pass
+#define DSP_SINE_BITS 8                // 256-entry sine table
+#define DSP_CONTROL_SAMPLES 32         // pitch and envelope update interval, ~0.7 ms at 44.1 kHz
+#define CHIRP_FADE_MS 10               // fade in and out, so a chirp does not click
+
+class PolyphaseResampler {
+public:
+    // begin(): Designs the filter for inRate to outRate. The cutoff is at 90 % of the lower
+    // Nyquist frequency, so downsampling does not alias. Returns false for a zero rate.
+    bool begin(uint32_t inRate, uint32_t outRate = DSP_OUTPUT_RATE);
+    // reset(): Forgets the history, e.g. between two phrases
+    void reset();
+
+    // process(): Converts count input samples and returns the output samples written.
+    // out must hold maxOutput(count); output that does not fit is lost.
+    size_t process(const int16_t *in, size_t count, int16_t *out, size_t capacity);
+    size_t maxOutput(size_t count) { return (size_t)((uint64_t)count * _outRate / _inRate) + 2; }
+
+    uint32_t getInputRate() { return _inRate; }
+    uint32_t getOutputRate() { return _outRate; }
+
+private:
+    uint32_t _inRate = DSP_OUTPUT_RATE;
+    uint32_t _outRate = DSP_OUTPUT_RATE;
+    // Input samples per output sample, and the position of the next output's first tap in
+    // _window, both as an integer part and a 32-bit fraction so the rate does not drift
+    uint32_t _stepWhole = 1, _stepFraction = 0;
+    size_t _index = 0;
+    uint32_t _fraction = 0;
+    size_t _filled = 0;                // samples in _window
+    int16_t _coeffs[RESAMPLER_PHASES][RESAMPLER_TAPS];  // Q15, every phase sums to 1.0
+    int16_t _window[RESAMPLER_TAPS - 1 + RESAMPLER_BLOCK];
+
+    size_t filter(int16_t *out, size_t capacity);
+};
+
+// Chirp parameters, the same as R2D2Params in r2d2noice.py
+struct ChirpParams {
+    float baseFrequency;               // Hz
+    float pitchBendRange;              // Hz of slow pitch movement
+    float warbleRate;                  // Hz
+    float warbleDepth;                 // 0..1 of baseFrequency
+    float harmonicsStrength;           // of the 2nd to 4th harmonic, 0..1
+    float noiseFactor;                 // 0..1
+    float bassFactor;                  // sub tone at baseFrequency / 4, 0..1
+};
+
+enum ChirpMood {
+    CHIRP_NEUTRAL,
+    CHIRP_HAPPY,
+    CHIRP_SAD,
+    CHIRP_CRY,
+    CHIRP_TIRED,
+    CHIRP_MOOD_COUNT
+};
+
+// MOOD_PRESETS from r2d2noice.py
+static const ChirpParams CHIRP_PRESETS[CHIRP_MOOD_COUNT] = {
+    {1000.0f, 500.0f, 10.0f, 0.10f, 0.20f, 0.010f, 0.00f},   // neutral
+    {1500.0f, 800.0f, 15.0f, 0.20f, 0.30f, 0.005f, 0.00f},   // happy
+    {700.0f, 200.0f, 3.0f, 0.05f, 0.10f, 0.020f, 0.10f},     // sad
+    {600.0f, 300.0f, 2.0f, 0.10f, 0.05f, 0.030f, 0.20f},     // cry
+    {800.0f, 150.0f, 5.0f, 0.08f, 0.15f, 0.015f, 0.05f},     // tired
+};
+
+class ChirpOscillator {
+public:
+    void begin(uint32_t sampleRate = DSP_OUTPUT_RATE);
+
+    // play(): Starts a chirp; a running one is replaced
+    void play(const ChirpParams &params, uint32_t durationMs, uint8_t volume = 128);
+    void play(ChirpMood mood, uint32_t durationMs, uint8_t volume = 128) {
+        play(CHIRP_PRESETS[mood < CHIRP_MOOD_COUNT ? mood : CHIRP_NEUTRAL], durationMs, volume);
+    }
+    void stop() { _remaining = 0; }
+    bool isPlaying() { return _remaining > 0; }
+
+    // render(): Writes up to count mono samples and returns the number written, fewer
+    // when the chirp ends
+    size_t render(int16_t *out, size_t count);
+
+private:
+    uint32_t _sampleRate = DSP_OUTPUT_RATE;
+    uint32_t _remaining = 0;           // samples left
+    uint32_t _length = 0;
+    uint32_t _elapsed = 0;
+
+    // Phase accumulators, a full turn is 2^32
+    uint32_t _phase = 0;
+    uint32_t _bassPhase = 0;
+    uint32_t _bendPhase1 = 0, _bendPhase2 = 0, _warblePhase = 0;
+    uint32_t _bendStep1 = 0, _bendStep2 = 0, _warbleStep = 0;   // per control block
+    uint32_t _bassStep = 0;
+
+    // Pitch contour, as phase increments per sample
+    int32_t _baseStep = 0;
+    int32_t _bendStep = 0;             // at full bend
+    int32_t _warbleDepthStep = 0;      // at full warble
+
+    // Mix, Q15 of full scale
+    int32_t _gain = 0;                 // fundamental; harmonics and the rest are scaled to it
+    int16_t _harmonics = 0;            // Q15
+    int16_t _noise = 0;                // Q15
+    int16_t _bass = 0;                 // Q15
+    int32_t _fadeSamples = 1;
+    uint32_t _noiseState = 0x1234567;
+
+    uint32_t stepFor(float frequency) { return (uint32_t)(frequency * 4294967296.0f / _sampleRate); }
+};
+
+// audioMix(): dst += src * gain / 256, saturating
+static void audioMix(int16_t *dst, const int16_t *src, size_t count, uint16_t gain = 256);
+// audioMonoToStereo(): Expands frames mono samples in place to interleaved stereo; the
+// buffer must hold 2 * frames samples
+static void audioMonoToStereo(int16_t *samples, size_t frames);
+
+// --- Implementation ---
+
+static int16_t audioSaturate(int32_t value) {
+    return value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : (int16_t)value);
+}
+
+static void audioMix(int16_t *dst, const int16_t *src, size_t count, uint16_t gain) {
+    if (gain == 256) {
+        for (size_t i = 0; i < count; i++) dst[i] = audioSaturate((int32_t)dst[i] + src[i]);
+    } else {
+        for (size_t i = 0; i < count; i++) dst[i] = audioSaturate((int32_t)dst[i] + ((src[i] * (int32_t)gain) >> 8));
+    }
+}
+
+static void audioMonoToStereo(int16_t *samples, size_t frames) {
+    // Back to front, so no sample is overwritten before it is copied
+    for (size_t i = frames; i-- > 0;) {
+        int16_t sample = samples[i];
+        samples[2 * i] = sample;
+        samples[2 * i + 1] = sample;
+    }
+}
+
+// One period of a sine, with a guard entry for the interpolation
+static int16_t audioSineTable[(1 << DSP_SINE_BITS) + 1];
+
+static void audioInitSineTable() {
+    if (audioSineTable[1 << (DSP_SINE_BITS - 2)]) return; // the peak is set once the table is
+    for (int i = 0; i <= (1 << DSP_SINE_BITS); i++) {
+        audioSineTable[i] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)PI * i / (1 << DSP_SINE_BITS)));
+    }
+}
+
+// Sine of a 32-bit phase, linearly interpolated between table entries, Q15
+static inline int32_t audioSine(uint32_t phase) {
+    uint32_t index = phase >> (32 - DSP_SINE_BITS);
+    int32_t fraction = (phase >> (16 - DSP_SINE_BITS)) & 0xFFFF;
+    int32_t a = audioSineTable[index];
+    int32_t b = audioSineTable[index + 1];
+    return a + (((b - a) * fraction) >> 16);
+}
+
+bool PolyphaseResampler::begin(uint32_t inRate, uint32_t outRate) {
+    if (inRate == 0 || outRate == 0) return false;
+    _inRate = inRate;
+    _outRate = outRate;
+    _stepWhole = inRate / outRate;
+    _stepFraction = (uint32_t)(((uint64_t)(inRate % outRate) << 32) / outRate);
+
+    // Windowed sinc, cutoff relative to the input Nyquist frequency
+    float cutoff = 0.9f * min(1.0f, (float)outRate / inRate);
+    const float center = RESAMPLER_TAPS / 2 - 1;
+    for (int p = 0; p < RESAMPLER_PHASES; p++) {
+        float fraction = (float)p / RESAMPLER_PHASES;
+        float taps[RESAMPLER_TAPS];
+        float sum = 0;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            float t = k - center - fraction;
+            float x = (float)PI * cutoff * t;
+            float sinc = fabsf(x) < 1e-6f ? 1.0f : sinf(x) / x;
+            float window = 0.5f + 0.5f * cosf((float)PI * t / (RESAMPLER_TAPS / 2));
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        for (int k = 0; k < RESAMPLER_TAPS; k++) _coeffs[p][k] = (int16_t)lrintf(32768.0f * taps[k] / sum);
+    }
+    reset();
+    return true;
+}
+
+void PolyphaseResampler::reset() {
+    // Start on a silent history, so the first output lines up with the first input
+    _filled = RESAMPLER_TAPS / 2 - 1;
+    memset(_window, 0, _filled * sizeof(int16_t));
+    _index = 0;
+    _fraction = 0;
+}
+
+size_t PolyphaseResampler::process(const int16_t *in, size_t count, int16_t *out, size_t capacity) {
+    if (_inRate == _outRate) {
+        count = min(count, capacity);
+        memcpy(out, in, count * sizeof(int16_t));
+        return count;
+    }
+    size_t written = 0;
+    while (count) {
+        size_t take = min(count, sizeof(_window) / sizeof(_window[0]) - _filled);
+        memcpy(_window + _filled, in, take * sizeof(int16_t));
+        _filled += take;
+        in += take;
+        count -= take;
+
+        written += filter(out + written, capacity - written);
+
+        // Keep what the next output still needs; downsampling may skip past the window
+        if (_index >= _filled) {
+            _index -= _filled;
+            _filled = 0;
+        } else {
+            memmove(_window, _window + _index, (_filled - _index) * sizeof(int16_t));
+            _filled -= _index;
+            _index = 0;
+        }
+        if (take == 0) break; // out is full
+    }
+    return written;
+}
+
+// Every output sample whose taps are in the window
+size_t PolyphaseResampler::filter(int16_t *out, size_t capacity) {
+    size_t n = 0;
+    while (n < capacity && _index + RESAMPLER_TAPS <= _filled) {
+        const int16_t *x = _window + _index;
+        const int16_t *h = _coeffs[_fraction >> (32 - RESAMPLER_PHASE_BITS)];
+        int32_t acc = 1 << 14;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) acc += (int32_t)x[k] * h[k];
+        out[n++] = audioSaturate(acc >> 15);
+        uint32_t fraction = _fraction + _stepFraction;
+        _index += _stepWhole + (fraction < _fraction); // carry
+        _fraction = fraction;
+    }
+    return n;
+}
+
+void ChirpOscillator::begin(uint32_t sampleRate) {
+    _sampleRate = sampleRate;
+    _remaining = 0;
+    audioInitSineTable();
+}
+
+void ChirpOscillator::play(const ChirpParams &params, uint32_t durationMs, uint8_t volume) {
+    _length = max<uint32_t>(1, (uint64_t)durationMs * _sampleRate / 1000);
+    _elapsed = 0;
+    _phase = _bassPhase = 0;
+    _bendPhase1 = _bendPhase2 = _warblePhase = 0;
+
+    // The slow bend runs through periods of 0.7 and 0.4 times the length, like r2d2noice.py.
+    // These accumulators advance once per control block.
+    float seconds = durationMs / 1000.0f;
+    float controlRate = (float)_sampleRate / DSP_CONTROL_SAMPLES;
+    _bendStep1 = (uint32_t)(4294967296.0f / (seconds * 0.7f * controlRate));
+    _bendStep2 = (uint32_t)(4294967296.0f / (seconds * 0.4f * controlRate));
+    _warbleStep = (uint32_t)(params.warbleRate * 4294967296.0f / controlRate);
+
+    _baseStep = (int32_t)stepFor(params.baseFrequency);
+    _bendStep = (int32_t)stepFor(params.pitchBendRange);
+    _warbleDepthStep = (int32_t)stepFor(params.warbleDepth * params.baseFrequency);
+    _bassStep = stepFor(params.baseFrequency / 4.0f);
+
+    // Scale the mix so its peak stays at volume, instead of normalizing afterwards
+    float peak = 1.0f + 3.0f * params.harmonicsStrength + params.noiseFactor + params.bassFactor;
+    _gain = (int32_t)(volume / 255.0f / peak * 32767.0f);
+    _harmonics = (int16_t)(params.harmonicsStrength * 32767.0f);
+    _noise = (int16_t)(params.noiseFactor * 32767.0f);
+    _bass = (int16_t)(params.bassFactor * 32767.0f);
+    _fadeSamples = max<int32_t>(1, min<int32_t>(_length / 2, CHIRP_FADE_MS * _sampleRate / 1000));
+    _remaining = _length;
+}
+
+size_t ChirpOscillator::render(int16_t *out, size_t count) {
+    count = min<size_t>(count, _remaining);
+    size_t done = 0;
+    while (done < count) {
+        // Control block: pitch and envelope are held for DSP_CONTROL_SAMPLES samples
+        size_t block = min<size_t>(count - done, DSP_CONTROL_SAMPLES);
+        int32_t bend = audioSine(_bendPhase1) + audioSine(_bendPhase2) / 2;  // Q15, up to 1.5
+        int32_t step = _baseStep + (int32_t)(((int64_t)_bendStep * bend) >> 15) +
+                       (int32_t)(((int64_t)_warbleDepthStep * audioSine(_warblePhase)) >> 15);
+        _bendPhase1 += _bendStep1;
+        _bendPhase2 += _bendStep2;
+        _warblePhase += _warbleStep;
+
+        int32_t fromStart = _elapsed, toEnd = _length - _elapsed;
+        int32_t envelope = min<int32_t>(_fadeSamples, min(fromStart, toEnd));
+        int32_t gain = (int32_t)((int64_t)_gain * envelope / _fadeSamples);
+
+        uint32_t phase = _phase, bassPhase = _bassPhase, noise = _noiseState;
+        for (size_t i = 0; i < block; i++) {
+            int32_t wave = audioSine(phase);
+            int32_t overtones = audioSine(phase * 2) + audioSine(phase * 3) + audioSine(phase * 4);
+            wave += (overtones * _harmonics) >> 15;
+            wave += (audioSine(bassPhase) * _bass) >> 15;
+            noise ^= noise << 13;
+            noise ^= noise >> 17;
+            noise ^= noise << 5;
+            wave += ((int32_t)(int16_t)noise * _noise) >> 15;
+            out[done + i] = audioSaturate((wave * gain) >> 15);
+            phase += (uint32_t)step;
+            bassPhase += _bassStep;
+        }
+        _phase = phase;
+        _bassPhase = bassPhase;
+        _noiseState = noise;
+        _elapsed += block;
+        _remaining -= block;
+        done += block;
+    }
+    return count;
+}
+
+#endif
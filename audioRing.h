@@ -0,0 +1,63 @@
+// audioRing.h - Lock-free sample ring between an audio producer and a playback callback
+// One producer task writes 16-bit samples, one consumer reads them, typically the A2DP
+// data callback in the Bluetooth task. Both sides move whole spans with at most two
+// memcpy() calls and never block or lock, so the real-time side cannot be held up by the
+// network side. The indices only grow; the capacity must be a power of two.
+// This is the sample-stream counterpart of SpscRing in robotPipeline.h.
+
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+template <size_t N>
+class AudioRing {
+    static_assert((N & (N - 1)) == 0, "AudioRing size must be a power of two");
+
+public:
+    // Producer: copies as many samples as fit and returns that number
+    size_t write(const int16_t *samples, size_t count) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t space = N - (head - _tail.load(std::memory_order_acquire));
+        if (count > space) count = space;
+        copyIn(head & (N - 1), samples, count);
+        _head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer: copies up to count samples out and returns the number copied
+    size_t read(int16_t *samples, size_t count) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t available = _head.load(std::memory_order_acquire) - tail;
+        if (count > available) count = available;
+        copyOut(tail & (N - 1), samples, count);
+        _tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer: drops everything buffered, e.g. when playback is interrupted
+    void clear() { _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    size_t available() { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+    size_t space() { return N - available(); }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    int16_t _samples[N];
+    std::atomic<size_t> _head{0}; // written by the producer only
+    std::atomic<size_t> _tail{0}; // written by the consumer only
+
+    void copyIn(size_t at, const int16_t *from, size_t count) {
+        size_t first = min(count, N - at);
+        memcpy(_samples + at, from, first * sizeof(int16_t));
+        memcpy(_samples, from + first, (count - first) * sizeof(int16_t));
+    }
+    void copyOut(size_t at, int16_t *to, size_t count) {
+        size_t first = min(count, N - at);
+        memcpy(to, _samples + at, first * sizeof(int16_t));
+        memcpy(to + first, _samples, (count - first) * sizeof(int16_t));
+    }
+};
+
+#endif
@@ -1,10 +1,14 @@
 import os
+import json
+import math
+import socket
+import struct
 import threading
 import time
 import datetime
 import csv
 from collections import deque
-from flask import Flask, jsonify, request, abort
+from flask import Flask, Response, jsonify, request, abort, stream_with_context
 
 # --- Flask Application Setup ---
 app = Flask(__name__)
@@ -17,9 +21,22 @@ app.config['DEBUG'] = True
 # Each item will be a dictionary, e.g., {'type': 'speak', 'text': 'Hello there!'}
 pending_emo_updates = deque()
 
+# Newest status report the EMO bot POSTed to '/get_status' (task stacks, CPU load, loop jitter),
+# together with the time it arrived. None until the first report.
+last_emo_status = None
+last_emo_status_time = None
+status_lock = threading.Lock()
+
+# Decoded sensor telemetry from EMO's batches (see telemetryBatch.h), newest last,
+# and the events EMO should "remember" (e.g. it was shaken or fell).
+telemetry_samples = deque(maxlen=2000)
+telemetry_stats = {"batches": 0, "records": 0, "bytes": 0}
+remembered_events = deque(maxlen=500)
+last_imu_events = []   # events of the newest IMU sample, to spot new ones
+
 # A deque to store scheduled speech events. The scheduler thread will add to this,
 # and the main Flask app (or an internal handler) would then process these.
-# For simplicity, in this example, the scheduler directly adds to pending_emo_updates.
+# For simplicity, in this example, the scheduler hands its events straight to push_emo_update().
 scheduled_speech_queue = deque()
 
 # Path to the CSV file containing scheduled events.
@@ -72,12 +89,12 @@ def parse_command():
         parts = command_text.lower().split("speak ", 1)
         if len(parts) > 1:
             parsed_command = {"action": "speak", "text": parts[1]}
-            pending_emo_updates.append(parsed_command)
+            push_emo_update(parsed_command)
             print(f"Parsed command: {parsed_command}")
             return jsonify({"status": "command_parsed", "command": parsed_command})
     elif "move forward" in command_text.lower():
         parsed_command = {"action": "move", "direction": "forward", "distance": "medium"}
-        pending_emo_updates.append(parsed_command)
+        push_emo_update(parsed_command)
     # ... add more NLU logic ...
 
     print(f"Parsed command: {parsed_command}")
@@ -96,6 +113,7 @@ def set_emo_emotion():
     emotion_data = request.json
     # Store emotion_data in a persistent store or global state.
     # self.current_emotion = emotion_data # Placeholder
+    push_emo_update({"type": "emotion", "emotion": emotion_data.get('emotion')}) # the eyes follow right away
     print(f"EMO emotion set to: {emotion_data}")
     return jsonify({"status": "emotion_updated", "current_emotion": emotion_data})
 
@@ -116,8 +134,8 @@ def perform_complex_action():
     if not request.is_json:
         return jsonify({"error": "Request must be JSON"}), 400
     action_data = request.json
-    # Add action to the pending_emo_updates queue.
-    pending_emo_updates.append({"type": "action", "action_details": action_data})
+    # Send the action to EMO (over the link, or queued for /updates).
+    push_emo_update({"type": "action", "action_details": action_data})
     print(f"Added complex action to queue: {action_data}")
     return jsonify({"status": "action_queued", "action": action_data})
 
@@ -129,22 +147,11 @@ def set_emo_behavior_mode():
     mode = request.json.get('mode')
     # Update EMO's operating mode in its internal state.
     # self.current_mode = mode # Placeholder
-    pending_emo_updates.append({"type": "set_mode", "mode": mode})
+    push_emo_update({"type": "set_mode", "mode": mode})
     print(f"EMO behavior mode set to: {mode}")
     return jsonify({"status": "mode_set", "mode": mode})
 
-@app.route('/get_status', methods=['GET'])
-def get_emo_status():
-    # EMO reports its current status (battery, sensor readings, motor positions, etc.).
-    # In a real scenario, EMO would periodically POST its status to a different endpoint,
-    # and this endpoint would return the last known status from the server's memory/DB.
-    # For now, this is a placeholder.
-    return jsonify({
-        "battery_level": "75%",
-        "motors_active": True,
-        "current_task": "idle",
-        "last_seen": datetime.datetime.now().isoformat()
-    })
+# /get_status is implemented with the core endpoints below.
 """
 
 # --- 4. Memory and Learning ---
@@ -158,7 +165,7 @@ def remember_event():
         return jsonify({"error": "Request must be JSON"}), 400
     event_data = request.json
     # Store event_data in a database (e.g., SQLite, PostgreSQL)
-    print(f"EMO remembered event: {event_data}")
+    remember_emo_event(event_data)
     return jsonify({"status": "event_recorded", "event": event_data})
 
 @app.route('/recall_info', methods=['GET'])
@@ -195,7 +202,7 @@ def provide_navigation():
     nav_request = request.json
     # Implement pathfinding algorithms.
     navigation_steps = ["turn_left_90", "move_forward_10cm", "turn_right_45"]
-    pending_emo_updates.append({"type": "navigate", "steps": navigation_steps})
+    push_emo_update({"type": "navigate", "steps": navigation_steps})
     print(f"Provided navigation steps: {navigation_steps}")
     return jsonify({"status": "navigation_provided", "steps": navigation_steps})
 """
@@ -243,7 +250,7 @@ def execute_predefined_path():
     ]
     # Add path steps to the updates queue.
     for step in path_steps:
-        pending_emo_updates.append(step)
+        push_emo_update(step)
     print(f"Executing path: {path_id} with steps: {path_steps}")
     return jsonify({"status": "path_execution_started", "path_id": path_id})
 
@@ -280,6 +287,7 @@ def get_next_path_step():
     if current_step_index < len(path_steps):
         next_step = path_steps[current_step_index]
         print(f"Providing next path step for {path_id}: {next_step}")
+        push_emo_update({"type": "path_step", "path_id": path_id, "step": next_step})
         return jsonify({"status": "success", "next_step": next_step, "next_step_index": current_step_index + 1})
     else:
         print(f"Path {path_id} completed.")
@@ -305,12 +313,78 @@ def get_updates():
         # If no updates, return an empty array.
         return jsonify([])
 
+@app.route('/get_status', methods=['GET', 'POST'])
+def get_emo_status():
+    """
+    EMO POSTs its profiler report here every few seconds: stack usage, CPU share and
+    loop jitter histograms per FreeRTOS task, plus core loads and free heap.
+    A GET returns the last report with the time it was received.
+    """
+    global last_emo_status, last_emo_status_time
+    if request.method == 'POST':
+        status = request.get_json(silent=True)
+        if not isinstance(status, dict):
+            abort(400, description="Request must be a JSON object")
+        with status_lock:
+            last_emo_status = status
+            last_emo_status_time = datetime.datetime.now()
+        # Flag stacks that are close to overflowing, the rest is available through GET
+        for task in status.get('tasks', []):
+            stack, free = task.get('stack', 0), task.get('stack_free', 0)
+            if stack and free < stack // 10:
+                print(f"WARNING: task {task.get('name')} has only {free} of {stack} bytes of stack left")
+        return jsonify({"status": "received"})
+
+    with status_lock:
+        if last_emo_status is None:
+            return jsonify({"status": "no_report_yet"}), 404
+        return jsonify({
+            "report": last_emo_status,
+            "last_seen": last_emo_status_time.isoformat(),
+            "telemetry": telemetry_summary()
+        })
+
+# --- Speech Synthesis ---
+# bluetoothTTS.ino asks for raw PCM ("format": "pcm") and plays it while it downloads, so the
+# audio is generated and sent in small chunks instead of as one file.
+SPEECH_SAMPLE_RATE = 44100
+SPEECH_CHUNK_SAMPLES = 1024  # ~23 ms per chunk at 44.1 kHz
+
+
+def synthesize_speech(text, sample_rate=SPEECH_SAMPLE_RATE):
+    """
+    Yields 16-bit little-endian mono PCM for text, a chunk at a time.
+    Placeholder until a real TTS engine is wired in: every word becomes a short
+    tone whose pitch and length follow the word, with a gap between words.
+    """
+    chunk = []
+    phase = 0.0
+    for word in text.split():
+        frequency = 300.0 + (sum(map(ord, word)) % 40) * 15.0
+        tone_samples = int(sample_rate * (0.06 + 0.04 * min(len(word), 8)))
+        gap_samples = int(sample_rate * 0.08)
+        for i in range(tone_samples + gap_samples):
+            value = 0
+            if i < tone_samples:
+                # Short fade in and out so the words do not click
+                envelope = min(1.0, i / 400.0, (tone_samples - i) / 400.0)
+                phase += 2.0 * math.pi * frequency / sample_rate
+                value = int(12000 * envelope * math.sin(phase))
+            chunk.append(value)
+            if len(chunk) == SPEECH_CHUNK_SAMPLES:
+                yield struct.pack('<%dh' % len(chunk), *chunk)
+                chunk = []
+    if chunk:
+        yield struct.pack('<%dh' % len(chunk), *chunk)
+
+
 @app.route('/genspeak', methods=['POST'])
 def generate_speech_placeholder():
     """
-    Placeholder endpoint for your Text-to-Speech (TTS) service.
-    Your EMO bot (or other services) would send text here, and this server
-    would ideally forward it to your actual TTS engine or process it directly.
+    Text-to-Speech (TTS) endpoint.
+    With "format": "pcm" in the body (or "Accept: audio/L16") the speech is streamed back
+    as raw 16-bit mono PCM while it is generated. Otherwise this stays a placeholder that
+    only acknowledges the text.
     """
     if not request.is_json:
         # If the request is not JSON, respond with a 400 Bad Request error.
@@ -321,17 +395,290 @@ def generate_speech_placeholder():
         # If 'text' field is missing, respond with a 400 Bad Request error.
         abort(400, description="Missing 'text' in request body")
 
+    print(f"Received text for speech generation: '{text_to_speak}'")
+    wants_pcm = (request.json.get('format') == 'pcm' or
+                 'audio/l16' in request.headers.get('Accept', '').lower())
+    if wants_pcm:
+        sample_rate = int(request.json.get('sample_rate', SPEECH_SAMPLE_RATE))
+        return Response(stream_with_context(synthesize_speech(text_to_speak, sample_rate)),
+                        mimetype=f'audio/L16; rate={sample_rate}; channels=1')
+
     # --- Your actual TTS integration logic would go here ---
     # This could involve:
     # 1. Calling an external TTS API (e.g., Google Cloud Text-to-Speech, AWS Polly).
     # 2. Executing a local TTS command-line tool.
     # 3. Putting the text into a queue for your separate TTS service to consume.
     # For this example, we just simulate the TTS process.
-
-    print(f"Received text for speech generation: '{text_to_speak}'")
     # Simulate a response indicating speech generation is handled.
     return jsonify({"status": "speech_generated_simulated", "text": text_to_speak})
 
+# --- Persistent Link to EMO ---
+# EMO keeps one TCP connection open to LINK_PORT. Both directions use the frames from
+# linkProtocol.h: [length: u16, little endian][type: u8][payload]. Updates are pushed the
+# moment they happen; while EMO is not connected they wait in pending_emo_updates and go out
+# as soon as it connects (or when it polls '/updates').
+
+LINK_PORT = 5001
+LINK_HEADER = struct.Struct('<HB')
+LINK_MAX_PAYLOAD = 2048
+LINK_SEND_TIMEOUT_S = 5         # a send that takes longer drops the link instead of blocking the caller
+LINK_KEEPALIVE_IDLE_S = 30      # TCP keep-alive probes find an EMO that vanished without closing
+
+LINK_FRAME_HELLO = 0x01
+LINK_FRAME_PING = 0x02
+LINK_FRAME_PONG = 0x03
+LINK_FRAME_STATUS = 0x10
+LINK_FRAME_TELEMETRY = 0x11
+LINK_FRAME_SPEAK = 0x20
+LINK_FRAME_EMOTION = 0x21
+LINK_FRAME_PATH_STEP = 0x22
+LINK_FRAME_UPDATE = 0x23
+
+emo_link = None                 # socket of the connected EMO, None while disconnected
+emo_link_lock = threading.Lock() # serializes writers (Flask threads, scheduler) on emo_link
+
+
+def encode_emo_update(update):
+    """Picks the frame type for an update; the payload is text where EMO expects text."""
+    kind = update.get('type')
+    if kind == 'speak':
+        return LINK_FRAME_SPEAK, update.get('text', '').encode('utf-8')
+    if kind == 'emotion':
+        return LINK_FRAME_EMOTION, str(update.get('emotion', '')).encode('utf-8')
+    if kind == 'path_step':
+        return LINK_FRAME_PATH_STEP, json.dumps(update).encode('utf-8')
+    return LINK_FRAME_UPDATE, json.dumps(update).encode('utf-8')
+
+
+def send_link_frame(frame_type, payload=b''):
+    """Sends one frame to EMO. Returns False if EMO is not connected or the send failed."""
+    global emo_link
+    if len(payload) > LINK_MAX_PAYLOAD:
+        return False
+    with emo_link_lock:
+        if emo_link is None:
+            return False
+        try:
+            # The socket timeout bounds this: a robot that stops reading costs one timeout, not the thread
+            emo_link.sendall(LINK_HEADER.pack(len(payload), frame_type) + payload)
+            return True
+        except OSError:
+            close_link(emo_link)
+            emo_link = None
+            return False
+
+
+def push_emo_update(update):
+    """Delivers an update to EMO now if the link is up, otherwise queues it for later."""
+    frame_type, payload = encode_emo_update(update)
+    if not send_link_frame(frame_type, payload):
+        pending_emo_updates.append(update)
+
+
+def close_link(conn):
+    """Closes a link socket; shutdown() first, so a reader blocked in recv() on it wakes up."""
+    try:
+        conn.shutdown(socket.SHUT_RDWR)
+    except OSError:
+        pass
+    conn.close()
+
+
+def recv_exact(conn, size):
+    data = b''
+    while len(data) < size:
+        try:
+            chunk = conn.recv(size - len(data))
+        except socket.timeout:
+            # The timeout is there for sends; an idle EMO is fine as long as this is still its link
+            if emo_link is not conn:
+                raise ConnectionError("link replaced")
+            continue
+        if not chunk:
+            raise ConnectionError("link closed")
+        data += chunk
+    return data
+
+
+def handle_link_frame(frame_type, payload):
+    global last_emo_status, last_emo_status_time
+    if frame_type == LINK_FRAME_HELLO:
+        print(f"Link: EMO '{payload.decode('utf-8', 'replace')}' connected.")
+    elif frame_type == LINK_FRAME_PING:
+        send_link_frame(LINK_FRAME_PONG)
+    elif frame_type == LINK_FRAME_STATUS:
+        try:
+            status = json.loads(payload)
+        except ValueError:
+            print("Link: Malformed status report.")
+            return
+        with status_lock:
+            last_emo_status = status
+            last_emo_status_time = datetime.datetime.now()
+    elif frame_type == LINK_FRAME_TELEMETRY:
+        try:
+            records = decode_telemetry_batch(payload)
+        except ValueError as e:
+            print(f"Link: Malformed telemetry batch: {e}")
+            return
+        store_telemetry(records, len(payload))
+
+
+def link_reader_task(conn, address):
+    """Hands over the queued updates to a new connection, then reads its frames until it closes."""
+    global emo_link
+    print(f"Link: Connection from {address[0]}.")
+    while pending_emo_updates:
+        update = pending_emo_updates.popleft()
+        frame_type, payload = encode_emo_update(update)
+        if not send_link_frame(frame_type, payload):
+            pending_emo_updates.appendleft(update)
+            break
+    try:
+        while True:
+            length, frame_type = LINK_HEADER.unpack(recv_exact(conn, LINK_HEADER.size))
+            handle_link_frame(frame_type, recv_exact(conn, length))
+    except (ConnectionError, OSError):
+        print(f"Link: EMO at {address[0]} disconnected.")
+    with emo_link_lock:
+        if emo_link is conn:
+            emo_link = None
+    close_link(conn)
+
+
+def link_server_task():
+    """
+    Accepts EMO's link connections, each read by its own link_reader_task. A new connection
+    replaces and closes the old one, e.g. after EMO rebooted without closing its socket; the
+    listener never waits on a connection, so the replacement is accepted right away.
+    """
+    global emo_link
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('0.0.0.0', LINK_PORT))
+    server.listen(1)
+    print(f"Link server listening on port {LINK_PORT}.")
+    while True:
+        conn, address = server.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        conn.setsockopt(socket.SOL_SOCKET, socket.SO_KEEPALIVE, 1)
+        if hasattr(socket, 'TCP_KEEPIDLE'): # the probe timing options are not on every platform
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPIDLE, LINK_KEEPALIVE_IDLE_S)
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPINTVL, 10)
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPCNT, 3)
+        conn.settimeout(LINK_SEND_TIMEOUT_S)
+        with emo_link_lock:
+            if emo_link is not None:
+                close_link(emo_link)
+            emo_link = conn
+        threading.Thread(target=link_reader_task, args=(conn, address), daemon=True).start()
+
+# --- Sensor Telemetry ---
+# EMO batches its IMU samples and sensor frames into delta encoded blocks (telemetryBatch.h)
+# and sends them as LINK_FRAME_TELEMETRY frames, about one per second.
+
+TELEMETRY_VERSION = 1
+TELEMETRY_RECORD_IMU = 0
+TELEMETRY_RECORD_RANGE = 1
+IMU_EVENT_NAMES = {0x01: 'shake', 0x02: 'freefall', 0x04: 'tilt', 0x08: 'spin', 0x10: 'jerk'}
+
+
+def read_varint(data, offset):
+    """LEB128 varint at offset; returns (value, new offset)."""
+    value = 0
+    shift = 0
+    while True:
+        if offset >= len(data):
+            raise ValueError("truncated varint")
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, offset
+        shift += 7
+        if shift > 35:
+            raise ValueError("varint too long")
+
+
+def read_zigzag(data, offset):
+    value, offset = read_varint(data, offset)
+    return (value >> 1) ^ -(value & 1), offset
+
+
+def decode_telemetry_batch(data):
+    """
+    Decodes one telemetry block into a list of records, each a dict with 'kind' ('imu' or
+    'range') and 'timestamp_us' (device micros(), wraps every ~71 minutes).
+    """
+    if len(data) < 7 or data[0] != TELEMETRY_VERSION:
+        raise ValueError("unknown block header")
+    count, timestamp = struct.unpack_from('<HI', data, 1)
+    offset = 7
+    imu = [0] * 6
+    distance = light = 0
+    records = []
+    for _ in range(count):
+        if offset >= len(data):
+            raise ValueError("truncated record")
+        tag = data[offset]
+        offset += 1
+        delta, offset = read_zigzag(data, offset)
+        timestamp = (timestamp + delta) & 0xFFFFFFFF
+        if tag & 1 == TELEMETRY_RECORD_IMU:
+            for i in range(6):
+                change, offset = read_zigzag(data, offset)
+                imu[i] += change
+            events = tag >> 1
+            records.append({
+                'kind': 'imu', 'timestamp_us': timestamp,
+                'accel': imu[0:3], 'gyro': imu[3:6],
+                'events': [name for bit, name in IMU_EVENT_NAMES.items() if events & bit]
+            })
+        else:
+            change, offset = read_zigzag(data, offset)
+            distance += change
+            change, offset = read_zigzag(data, offset)
+            light += change
+            records.append({
+                'kind': 'range', 'timestamp_us': timestamp,
+                'distance_mm': None if distance == 0xFFFF else distance, 'light': light
+            })
+    return records
+
+
+def store_telemetry(records, size):
+    with status_lock:
+        telemetry_samples.extend(records)
+        telemetry_stats["batches"] += 1
+        telemetry_stats["records"] += len(records)
+        telemetry_stats["bytes"] += size
+    # Motion events are worth remembering, e.g. "EMO was picked up and shaken". A shake spans
+    # many samples, so only the samples where a new event starts are kept.
+    global last_imu_events
+    for record in records:
+        if record['kind'] != 'imu':
+            continue
+        started = [name for name in record['events'] if name not in last_imu_events]
+        if started:
+            remember_emo_event({'event_type': 'motion', 'details': started,
+                                'timestamp_us': record['timestamp_us']})
+        last_imu_events = record['events']
+
+
+def telemetry_summary():
+    """Newest IMU and range sample plus counters; caller holds status_lock."""
+    last = {}
+    for record in reversed(telemetry_samples):
+        last.setdefault(record['kind'], record)
+        if len(last) == 2:
+            break
+    return {"last_imu": last.get('imu'), "last_range": last.get('range'), **telemetry_stats}
+
+
+def remember_emo_event(event):
+    remembered_events.append({**event, "received": datetime.datetime.now().isoformat()})
+    print(f"EMO remembered event: {event}")
+
 # --- Scheduler Thread Logic ---
 
 def load_schedule_from_csv(file_path):
@@ -410,8 +757,8 @@ def scheduler_task():
 
                 if event_id not in triggered_events_this_minute:
                     print(f"Scheduler: Time match! Queueing speech: '{event_text}'")
-                    # Add a 'speak' command to the pending EMO updates queue
-                    pending_emo_updates.append({'type': 'speak', 'text': event_text})
+                    # Send a 'speak' command to EMO, over the link if it is connected
+                    push_emo_update({'type': 'speak', 'text': event_text})
                     triggered_events_this_minute.add(event_id) # Mark as triggered
 
         time.sleep(1) # Check every second
@@ -423,6 +770,10 @@ if __name__ == '__main__':
     scheduler_thread = threading.Thread(target=scheduler_task, daemon=True)
     scheduler_thread.start()
 
+    # Accept EMO's persistent link in its own thread
+    link_thread = threading.Thread(target=link_server_task, daemon=True)
+    link_thread.start()
+
     # Create a dummy CSV file if it doesn't exist to ensure the scheduler has data
     if not os.path.exists(SCHEDULE_CSV_FILE):
         print(f"Creating a dummy '{SCHEDULE_CSV_FILE}' for initial setup.")
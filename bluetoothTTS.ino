@@ -11,6 +11,10 @@
 #include "freertos/FreeRTOS.h" // FreeRTOS for tasks/queues
 #include "freertos/task.h"    // FreeRTOS task management
 #include "freertos/queue.h"   // FreeRTOS queue management
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include "audioRing.h"        // Lock-free sample ring for streaming playback
+#include "audioDsp.h"         // Resampler, chirp oscillator and mixer
 
 // Define a TAG for logging messages from this module
 static const char *TAG = "A2DP_SOURCE";
@@ -28,77 +32,238 @@ static const char* bluetooth_speaker_name = "CY786";
 static bool is_connected = false;     // True if connected to a Bluetooth speaker
 static bool start_playing = false;    // Flag to start/stop audio streaming
 
-// --- Audio Data Placeholder ---
-// This section defines the properties and buffer for the audio data to be played.
-// For the phrase "hello human how are you doing fuck you guys", you would need to:
-// 1. Use a Text-to-Speech (TTS) service (e.g., Google Cloud TTS) to generate
-//    the audio as a WAV (PCM, 44.1kHz, 16-bit, mono) file.
-// 2. Convert that WAV file into a C/C++ byte array (many online tools can do this).
-// 3. Replace the `audio_buffer` content with your generated data.
-//
-// NOTE: The phrase "fuck you guys" is included as per your request for TTS.
-// Please be mindful of the content you choose to generate and play.
+// --- TTS Server Configuration ---
+// Speech is fetched from /genspeak on bgserver.py as raw PCM and played while it downloads.
+const char* ssid = "YOUR_WIFI_SSID";
+const char* password = "YOUR_WIFI_PASSWORD";
+const char* tts_server_url = "http://YOUR_SERVER_IP:5000/genspeak";
+
+// --- Streaming Playback ---
+// The server sends 16-bit mono PCM at TTS_SAMPLE_RATE. A producer task resamples it to
+// AUDIO_SAMPLE_RATE and pushes it into playback_ring as it arrives; the A2DP data callback only copies out of the ring, so speech
+// of any length plays from a few KB of RAM and starts with the first chunk. When the ring
+// runs dry the callback sends silence instead of waiting for the network.
 const int AUDIO_SAMPLE_RATE = 44100; // Hz (Standard for A2DP)
-const int AUDIO_DURATION_SECONDS = 3; // Length of current placeholder audio (in seconds)
+const int TTS_SAMPLE_RATE = 22050;   // Hz requested from the server; TTS engines rarely go higher
 const int SAMPLE_BITS = 16;         // 16-bit audio
-const int NUM_CHANNELS = 1;         // Mono audio
+const int NUM_CHANNELS = 1;         // Mono from the server; A2DP wants stereo, each sample goes to both channels
+
+#define PLAYBACK_RING_SAMPLES 8192       // ~186 ms, 16 KB
+#define PLAYBACK_PREBUFFER_SAMPLES 2048  // ~46 ms buffered before a phrase starts playing
+#define PRODUCER_WAIT_MS 500             // how long the producer waits for room before dropping audio
+#define SPEECH_QUEUE_LENGTH 4
+#define SPEECH_TEXT_BYTES 128
+#define SINK_CHUNK_SAMPLES 64            // resampled at a time, for sources of 16 kHz and up
+#define CHIRP_DURATION_MS 400
+#define CHIRP_GAIN 192                   // of 256, chirps sit a little under the speech
+
+static AudioRing<PLAYBACK_RING_SAMPLES> playback_ring;
+static QueueHandle_t speech_queue = NULL;          // phrases waiting for the producer
+static volatile bool speech_streaming = false;     // the producer is receiving a phrase
+static volatile bool playback_primed = false;      // the prebuffer was reached, the callback plays
+static volatile unsigned long underruns = 0;       // callbacks short of audio while a phrase was streaming
+static volatile unsigned long overrun_samples = 0; // samples dropped because the ring stayed full
+
+static PolyphaseResampler speech_resampler;        // producer side, TTS_SAMPLE_RATE to AUDIO_SAMPLE_RATE
+static ChirpOscillator chirp;                      // A2DP callback side, mixed over the speech
+static volatile int pending_chirp = -1;            // ChirpMood for the callback to start, or -1
+
+/**
+ * @brief Stream sink for HTTPClient::writeToStream().
+ * Turns the response body into samples, resamples them and pushes them into playback_ring.
+ * A sample split across two writes is carried over. While the ring is full it waits for the A2DP callback
+ * to make room; after PRODUCER_WAIT_MS the rest of the write is dropped and counted.
+ */
+class PlaybackSink : public Stream {
+public:
+    void reset() {
+        has_carry = false;
+        speech_resampler.reset();
+    }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+
+    size_t write(const uint8_t *buffer, size_t size) override {
+        size_t used = 0;
+        if (has_carry && size) {
+            int16_t sample = (int16_t)(carry | (buffer[0] << 8));
+            resample(&sample, 1);
+            has_carry = false;
+            used = 1;
+        }
+        int16_t samples[SINK_CHUNK_SAMPLES];
+        while (size - used >= 2) {
+            size_t count = min((size - used) / 2, sizeof(samples) / sizeof(samples[0]));
+            memcpy(samples, buffer + used, count * sizeof(int16_t)); // little endian, like the ESP32
+            resample(samples, count);
+            used += count * sizeof(int16_t);
+        }
+        if (used < size) {
+            carry = buffer[used];
+            has_carry = true;
+        }
+        return size;
+    }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+
+private:
+    uint8_t carry = 0;
+    bool has_carry = false;
+
+    void resample(const int16_t *samples, size_t count) {
+        int16_t resampled[SINK_CHUNK_SAMPLES * 3 + 2];
+        push(resampled, speech_resampler.process(samples, count, resampled, sizeof(resampled) / sizeof(resampled[0])));
+    }
+
+    void push(const int16_t *samples, size_t count) {
+        unsigned long waited = 0;
+        while (count) {
+            size_t written = playback_ring.write(samples, count);
+            samples += written;
+            count -= written;
+            if (!count) break;
+            if (waited >= PRODUCER_WAIT_MS) {
+                overrun_samples += count;
+                return;
+            }
+            vTaskDelay(pdMS_TO_TICKS(5));
+            waited += 5;
+        }
+    }
+};
+
+static PlaybackSink playback_sink;
+
+/**
+ * @brief Escapes text for a JSON string value.
+ * @return false if the escaped text does not fit into out.
+ */
+bool json_escape(const char *text, char *out, size_t size) {
+    size_t n = 0;
+    for (; *text; text++) {
+        char c = *text;
+        const char *escape = c == '"' ? "\\\"" : c == '\\' ? "\\\\" : nullptr;
+        if ((unsigned char)c < 0x20) c = ' '; // control characters are no use to the TTS
+        size_t length = escape ? 2 : 1;
+        if (n + length >= size) return false;
+        if (escape) memcpy(out + n, escape, 2);
+        else out[n] = c;
+        n += length;
+    }
+    out[n] = '\0';
+    return true;
+}
 
-// Calculate the maximum size of the audio buffer in bytes
-#define MAX_AUDIO_BUFFER_SIZE (AUDIO_SAMPLE_RATE * AUDIO_DURATION_SECONDS * NUM_CHANNELS * (SAMPLE_BITS / 8))
-// Global buffer to hold the audio data (array of 16-bit signed integers)
-int16_t audio_buffer[MAX_AUDIO_BUFFER_SIZE / (SAMPLE_BITS / 8)];
-static size_t current_audio_position = 0; // Tracks the current position within the audio_buffer
+/**
+ * @brief Fetches one phrase from /genspeak and streams it into playback_ring.
+ * Blocks until the server has sent the whole phrase; playback starts long before that.
+ * @param text The text to speak.
+ * @return true if the server answered with audio.
+ */
+bool fetch_speech(const char *text) {
+    char escaped[SPEECH_TEXT_BYTES * 2];
+    char body[SPEECH_TEXT_BYTES * 2 + 64];
+    if (!json_escape(text, escaped, sizeof(escaped))) return false;
+    int length = snprintf(body, sizeof(body), "{\"text\":\"%s\",\"format\":\"pcm\",\"sample_rate\":%d}",
+                          escaped, TTS_SAMPLE_RATE);
+    if (length <= 0 || (size_t)length >= sizeof(body)) return false;
+
+    HTTPClient http;
+    http.begin(tts_server_url);
+    http.addHeader("Content-Type", "application/json");
+    http.addHeader("Accept", "audio/L16");
+    int code = http.POST((uint8_t *)body, length);
+    bool ok = code == HTTP_CODE_OK;
+    if (ok) {
+        playback_sink.reset();
+        speech_streaming = true;
+        int bytes = http.writeToStream(&playback_sink);
+        speech_streaming = false;
+        ok = bytes > 0;
+        ESP_LOGI(TAG, "Speech received: %d bytes", bytes);
+    } else {
+        ESP_LOGE(TAG, "Speech request failed: %d", code);
+    }
+    http.end();
+    return ok;
+}
 
 /**
- * @brief Generates a simple sine wave for demonstration purposes.
- * In a real TTS scenario, you would load pre-generated audio bytes here.
- * @param buffer Pointer to the 16-bit audio buffer.
- * @param num_samples Number of samples to generate.
- * @return Number of samples generated.
+ * @brief Producer task: speaks the queued phrases one after the other.
  */
-size_t generate_placeholder_audio(int16_t *buffer, size_t num_samples) {
-    static float phase = 0.0;
-    float frequency = 440.0; // A4 note (440 Hz) for the sine wave placeholder
-    float volume_scale = 0.5; // Reduce volume slightly to prevent clipping
-
-    for (size_t i = 0; i < num_samples; ++i) {
-        // Generate a sine wave sample
-        float sample_value = sin(2.0 * PI * frequency * (i / (float)AUDIO_SAMPLE_RATE) + phase) * volume_scale;
-        // Convert float sample to 16-bit integer format expected by A2DP
-        buffer[i] = (int16_t)(sample_value * 32767.0);
+void speech_producer_task(void *arg) {
+    char text[SPEECH_TEXT_BYTES];
+    for (;;) {
+        if (xQueueReceive(speech_queue, text, portMAX_DELAY) != pdTRUE) continue;
+        if (WiFi.status() != WL_CONNECTED) {
+            ESP_LOGE(TAG, "No WiFi, dropping phrase '%s'", text);
+            continue;
+        }
+        fetch_speech(text);
     }
-    // Update phase for continuous waveform if called repeatedly
-    phase += 2.0 * PI * frequency * (num_samples / (float)AUDIO_SAMPLE_RATE);
-    return num_samples;
+}
+
+/**
+ * @brief Queues a phrase for the producer task.
+ * @return false if the queue is full.
+ */
+bool speak(const char *text) {
+    char item[SPEECH_TEXT_BYTES];
+    strncpy(item, text, sizeof(item) - 1);
+    item[sizeof(item) - 1] = '\0';
+    return xQueueSend(speech_queue, item, 0) == pdTRUE;
 }
 
 /**
  * @brief A2DP Source Data Callback function.
  * This is called by the A2DP source to request audio data to be sent to the sink.
- * @param data Pointer to the buffer where audio data should be placed.
+ * It runs in the Bluetooth task and never waits: it copies what the ring holds and fills
+ * the rest with silence.
+ * @param data Pointer to the buffer where audio data should be placed (16-bit stereo).
  * @param len The number of bytes requested by the A2DP stack.
  * @return The number of bytes actually written to the buffer.
  */
 int32_t a2d_data_cb(uint8_t *data, int32_t len) {
-    if (!start_playing) {
+    if (!start_playing || len <= 0) {
         return 0; // Return 0 bytes if not in playing state
     }
 
-    size_t samples_requested = len / (SAMPLE_BITS / 8); // Convert bytes to samples
+    int16_t *out = (int16_t *)data;
+    size_t frames = len / (2 * sizeof(int16_t));
 
-    // Check if we have enough data remaining in our buffer
-    if (current_audio_position < (MAX_AUDIO_BUFFER_SIZE / (SAMPLE_BITS / 8))) {
-        size_t samples_to_copy = std::min(samples_requested, (MAX_AUDIO_BUFFER_SIZE / (SAMPLE_BITS / 8)) - current_audio_position);
-        // Copy audio data from our buffer to the A2DP buffer
-        memcpy(data, &audio_buffer[current_audio_position], samples_to_copy * sizeof(int16_t));
-        current_audio_position += samples_to_copy; // Advance our position
-        return samples_to_copy * (SAMPLE_BITS / 8); // Return the number of bytes written
-    } else {
-        // If we reached the end of our audio buffer, loop back to the beginning
-        current_audio_position = 0;
-        ESP_LOGI(TAG, "Finished playing phrase. Looping...");
-        return 0; // Return 0 bytes to indicate no more data for this call
+    // A phrase starts once the prebuffer is full, or once it has arrived completely if shorter
+    if (!playback_primed) {
+        size_t buffered = playback_ring.available();
+        playback_primed = buffered >= PLAYBACK_PREBUFFER_SAMPLES || (buffered && !speech_streaming);
+    }
+    size_t got = playback_primed ? playback_ring.read(out, frames) : 0;
+    if (got < frames) {
+        memset(out + got, 0, (frames - got) * sizeof(int16_t));
+        if (playback_primed) {
+            if (speech_streaming) underruns++; // the network fell behind
+            playback_primed = false;           // refill the prebuffer before going on
+        }
     }
+
+    // Effects over the speech, or over the silence
+    int mood = pending_chirp;
+    if (mood >= 0) {
+        pending_chirp = -1;
+        chirp.play((ChirpMood)mood, CHIRP_DURATION_MS);
+    }
+    for (size_t done = 0; done < frames && chirp.isPlaying();) {
+        int16_t effect[256];
+        size_t count = chirp.render(effect, min(frames - done, sizeof(effect) / sizeof(effect[0])));
+        audioMix(out + done, effect, count, CHIRP_GAIN);
+        done += count;
+    }
+
+    audioMonoToStereo(out, frames);
+    return frames * 2 * sizeof(int16_t);
 }
 
 /**
@@ -207,10 +372,20 @@ void setup() {
   delay(1000); // Small delay to allow serial to initialize
   Serial.println("Starting ESP32 Bluetooth A2DP TTS Client (using direct IDF APIs)...");
 
-  // Initialize the audio buffer with our placeholder audio (simple tone)
-  generate_placeholder_audio(audio_buffer, MAX_AUDIO_BUFFER_SIZE / (SAMPLE_BITS / 8));
-  Serial.printf("Placeholder audio generated: %d samples, %d bytes.\n",
-                MAX_AUDIO_BUFFER_SIZE / (SAMPLE_BITS / 8), MAX_AUDIO_BUFFER_SIZE);
+  // --- Connect to WiFi for the TTS server ---
+  WiFi.begin(ssid, password);
+  Serial.print("Connecting to WiFi");
+  for (int i = 0; i < 40 && WiFi.status() != WL_CONNECTED; i++) {
+    delay(250);
+    Serial.print(".");
+  }
+  Serial.println(WiFi.status() == WL_CONNECTED ? " connected." : " failed, speech needs WiFi.");
+
+  // --- Start the speech producer ---
+  speech_resampler.begin(TTS_SAMPLE_RATE, AUDIO_SAMPLE_RATE);
+  chirp.begin(AUDIO_SAMPLE_RATE);
+  speech_queue = xQueueCreate(SPEECH_QUEUE_LENGTH, SPEECH_TEXT_BYTES);
+  xTaskCreatePinnedToCore(speech_producer_task, "SpeechProducer", 6144, NULL, 3, NULL, 1);
 
   // --- Initialize Bluetooth Controller ---
   // The BT controller handles the low-level radio operations.
@@ -276,11 +451,43 @@ void setup() {
 void loop() {
   // In this direct IDF approach, most of the Bluetooth and audio streaming logic
   // runs in the background via FreeRTOS tasks and callbacks managed by the ESP-IDF.
-  // The loop can be used for other application tasks or simple connection monitoring.
-  if (is_connected && start_playing) {
-      Serial.println("Connected and playing audio...");
-  } else {
+  // The loop takes phrases from the serial monitor and reports the playback state.
+  // A line like "!happy" plays a chirp instead of speaking.
+  static bool greeted = false;
+  static char line[SPEECH_TEXT_BYTES];
+  static size_t line_length = 0;
+  static unsigned long last_report = 0;
+
+  if (is_connected && !greeted) {
+    greeted = speak("hello human, how are you doing");
+  }
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      line[line_length] = '\0';
+      if (line_length && line[0] == '!') {
+        static const char *moods[CHIRP_MOOD_COUNT] = {"neutral", "happy", "sad", "cry", "tired"};
+        for (int i = 0; i < CHIRP_MOOD_COUNT; i++) {
+          if (strcmp(line + 1, moods[i]) == 0) pending_chirp = i;
+        }
+      } else if (line_length && !speak(line)) {
+        Serial.println("Speech queue full, phrase dropped.");
+      }
+      line_length = 0;
+    } else if (line_length < sizeof(line) - 1) {
+      line[line_length++] = c;
+    }
+  }
+
+  if (millis() - last_report >= 2000) {
+    last_report = millis();
+    if (is_connected && start_playing) {
+      Serial.printf("Connected, %s. Buffered %u samples, underruns %lu, overrun samples %lu\n",
+                    speech_streaming ? "streaming speech" : "idle",
+                    (unsigned)playback_ring.available(), underruns, overrun_samples);
+    } else {
       Serial.println("Waiting for connection or discovery in progress...");
+    }
   }
-  delay(2000); // Small delay to prevent busy-looping in the main loop
+  delay(10);
 }
@@ -0,0 +1,283 @@
+// chatContext.h - Bounded conversation memory for the OpenRouter chat requests
+// The conversation turns live in one fixed ring arena of CHAT_ARENA_BYTES. Each turn is a
+// record [role: u8][length: u16, little endian][text], and a record may wrap around the end
+// of the arena. A new turn evicts the oldest ones when the arena is full or when the
+// estimated prompt size goes over the token budget. The persona and the system prompt always
+// stay, so the device can chat for hours without the heap fragmenting.
+//
+// Nothing builds the request body in memory. bodyLength() measures it, and ChatBodyStream
+// generates it on demand for HTTPClient::sendRequest(). Each read regenerates the JSON and
+// keeps only the window that was asked for. That costs a few passes over a few KB instead
+// of a buffer.
+//
+// Evicted turns are gone. The application may keep their gist with setSummary(), which is
+// sent as a second system message; getDroppedTurns() tells it when a summary is due.
+// Tokens are estimated as 4 bytes each, plus CHAT_TOKENS_PER_MESSAGE per message.
+
+#ifndef CHAT_CONTEXT_H
+#define CHAT_CONTEXT_H
+
+#include <Arduino.h>
+
+#define CHAT_ARENA_BYTES 4096
+#define CHAT_SUMMARY_BYTES 256
+#define CHAT_DEFAULT_TOKEN_BUDGET 1500
+#define CHAT_TOKENS_PER_MESSAGE 4
+#define CHAT_RECORD_HEADER 3
+
+#define CHAT_ROLE_USER 0
+#define CHAT_ROLE_ASSISTANT 1
+
+class ChatContext {
+public:
+    // The strings are not copied and must stay valid, e.g. literals
+    void setModel(const char *model) { _model = model; }
+    void setPersona(const char *persona) { _persona = persona; }
+    void setSystemPrompt(const char *prompt) { _systemPrompt = prompt; }
+    void setStream(bool stream) { _stream = stream; }
+    void setTokenBudget(uint16_t tokens) { _tokenBudget = tokens; }
+
+    // setSummary(): Replaces the summary of the evicted turns (copied, truncated to fit)
+    void setSummary(const char *summary);
+
+    // addTurn(): Appends a complete turn and trims the history to the budget
+    void addTurn(uint8_t role, const char *text) { beginTurn(role); append(text, strlen(text)); endTurn(); }
+
+    // beginTurn()/append()/endTurn(): Builds a turn piece by piece, e.g. from streamed tokens.
+    // append() evicts old turns for room; if the open turn alone fills the arena, the rest
+    // of its text is cut off.
+    void beginTurn(uint8_t role);
+    void append(const char *text, size_t length);
+    void endTurn();
+
+    // discardTurn(): Drops the open turn, e.g. when the request it belonged to failed
+    void discardTurn();
+    void clear();
+
+    // writeBody(): The complete request JSON
+    void writeBody(Print &out);
+    size_t bodyLength();
+
+    uint8_t getTurnCount() { return _turns; }
+    uint16_t getEstimatedTokens() { return fixedTokens() + _historyTokens; }
+    unsigned long getDroppedTurns() { return _dropped; }
+    unsigned long getTruncatedBytes() { return _truncated; }
+    size_t getArenaUsed() { return _used; }
+
+private:
+    char _arena[CHAT_ARENA_BYTES];
+    size_t _head = 0;                 // oldest record
+    size_t _used = 0;                 // bytes in use, including the open turn
+    uint8_t _turns = 0;               // finished turns
+    bool _open = false;
+    size_t _openStart = 0;            // record of the open turn
+    uint16_t _openLength = 0;
+    uint16_t _historyTokens = 0;      // estimate for the finished turns
+    uint16_t _tokenBudget = CHAT_DEFAULT_TOKEN_BUDGET;
+    unsigned long _dropped = 0;
+    unsigned long _truncated = 0;
+
+    const char *_model = "";
+    const char *_persona = nullptr;
+    const char *_systemPrompt = nullptr;
+    char _summary[CHAT_SUMMARY_BYTES] = "";
+    bool _stream = false;
+
+    char &at(size_t offset) { return _arena[offset % CHAT_ARENA_BYTES]; }
+    uint16_t recordLength(size_t start) { return (uint8_t)at(start + 1) | ((uint8_t)at(start + 2) << 8); }
+    bool dropOldest();
+    uint16_t fixedTokens();
+    static uint16_t estimateTokens(size_t bytes) { return (bytes + 3) / 4 + CHAT_TOKENS_PER_MESSAGE; }
+    static void writeText(Print &out, const char *text) { out.write((const uint8_t *)text, strlen(text)); }
+    static void writeEscaped(Print &out, char c);
+    static void writeEscaped(Print &out, const char *text) { while (*text) writeEscaped(out, *text++); }
+};
+
+// ChatBodyStream - The request body of a ChatContext as a Stream for HTTPClient::sendRequest()
+class ChatBodyStream : public Stream {
+public:
+    explicit ChatBodyStream(ChatContext &context) : _context(context) {}
+
+    // rewind(): Measures the body and starts over; call before every send
+    size_t rewind() { _offset = 0; _length = _context.bodyLength(); return _length; }
+    size_t length() { return _length; }
+
+    int available() override { return _length - _offset; }
+    size_t readBytes(char *buffer, size_t length) override;
+    int read() override { char c; return readBytes(&c, 1) ? (uint8_t)c : -1; }
+    int peek() override;
+    size_t write(uint8_t) override { return 0; }
+
+private:
+    ChatContext &_context;
+    size_t _offset = 0;
+    size_t _length = 0;
+};
+
+// --- Implementation ---
+
+// Discards everything but bytes [skip, skip + capacity) and counts the total
+class ChatWindowPrint : public Print {
+public:
+    ChatWindowPrint(char *buffer, size_t skip, size_t capacity) : _buffer(buffer), _skip(skip), _capacity(capacity) {}
+    size_t write(uint8_t c) override {
+        if (_position >= _skip && _position - _skip < _capacity) _buffer[_position - _skip] = (char)c;
+        _position++;
+        return 1;
+    }
+    size_t position() { return _position; }
+
+private:
+    char *_buffer;
+    size_t _skip;
+    size_t _capacity;
+    size_t _position = 0;
+};
+
+void ChatContext::setSummary(const char *summary) {
+    strncpy(_summary, summary, sizeof(_summary) - 1);
+    _summary[sizeof(_summary) - 1] = '\0';
+}
+
+void ChatContext::beginTurn(uint8_t role) {
+    if (_open) endTurn();
+    while (CHAT_ARENA_BYTES - _used < CHAT_RECORD_HEADER && dropOldest()) {}
+    _openStart = _head + _used; // may be past the end, at() wraps it
+    at(_openStart) = (char)role;
+    _used += CHAT_RECORD_HEADER;
+    _openLength = 0;
+    _open = true;
+}
+
+void ChatContext::append(const char *text, size_t length) {
+    if (!_open) return;
+    for (size_t i = 0; i < length; i++) {
+        if (_used == CHAT_ARENA_BYTES && !dropOldest()) {
+            _truncated += length - i;
+            return;
+        }
+        at(_openStart + CHAT_RECORD_HEADER + _openLength) = text[i];
+        _openLength++;
+        _used++;
+    }
+}
+
+void ChatContext::endTurn() {
+    if (!_open) return;
+    at(_openStart + 1) = (char)(_openLength & 0xFF);
+    at(_openStart + 2) = (char)(_openLength >> 8);
+    _open = false;
+    _turns++;
+    _historyTokens += estimateTokens(_openLength);
+    // The newest turn always stays, even if it is over the budget on its own
+    while (_turns > 1 && fixedTokens() + _historyTokens > _tokenBudget) dropOldest();
+}
+
+void ChatContext::discardTurn() {
+    if (!_open) return;
+    _used -= CHAT_RECORD_HEADER + _openLength;
+    _open = false;
+}
+
+void ChatContext::clear() {
+    _head = _used = 0;
+    _turns = 0;
+    _open = false;
+    _historyTokens = 0;
+    _summary[0] = '\0';
+}
+
+bool ChatContext::dropOldest() {
+    if (_turns == 0) return false;
+    uint16_t length = recordLength(_head);
+    _head = (_head + CHAT_RECORD_HEADER + length) % CHAT_ARENA_BYTES;
+    _used -= CHAT_RECORD_HEADER + length;
+    _historyTokens -= estimateTokens(length);
+    _turns--;
+    _dropped++;
+    return true;
+}
+
+uint16_t ChatContext::fixedTokens() {
+    size_t system = (_persona ? strlen(_persona) + 2 : 0) + (_systemPrompt ? strlen(_systemPrompt) : 0);
+    uint16_t tokens = system ? estimateTokens(system) : 0;
+    if (_summary[0]) tokens += estimateTokens(strlen(_summary) + 30);
+    return tokens;
+}
+
+void ChatContext::writeBody(Print &out) {
+    writeText(out, "{\"model\":\"");
+    writeEscaped(out, _model);
+    writeText(out, _stream ? "\",\"stream\":true,\"messages\":[" : "\",\"messages\":[");
+    bool first = true;
+    if (_persona || _systemPrompt) {
+        writeText(out, "{\"role\":\"system\",\"content\":\"");
+        if (_persona) writeEscaped(out, _persona);
+        if (_persona && _systemPrompt) writeEscaped(out, "\n\n");
+        if (_systemPrompt) writeEscaped(out, _systemPrompt);
+        writeText(out, "\"}");
+        first = false;
+    }
+    if (_summary[0]) {
+        writeText(out, first ? "{" : ",{");
+        writeText(out, "\"role\":\"system\",\"content\":\"Earlier in the conversation: ");
+        writeEscaped(out, _summary);
+        writeText(out, "\"}");
+        first = false;
+    }
+    size_t record = _head;
+    for (uint8_t t = 0; t < _turns; t++) {
+        uint16_t length = recordLength(record);
+        writeText(out, first ? "{" : ",{");
+        writeText(out, at(record) == CHAT_ROLE_ASSISTANT ? "\"role\":\"assistant\",\"content\":\"" : "\"role\":\"user\",\"content\":\"");
+        for (uint16_t i = 0; i < length; i++) writeEscaped(out, at(record + CHAT_RECORD_HEADER + i));
+        writeText(out, "\"}");
+        record += CHAT_RECORD_HEADER + length;
+        first = false;
+    }
+    writeText(out, "]}");
+}
+
+size_t ChatContext::bodyLength() {
+    ChatWindowPrint counter(nullptr, 0, 0);
+    writeBody(counter);
+    return counter.position();
+}
+
+void ChatContext::writeEscaped(Print &out, char c) {
+    switch (c) {
+    case '"': writeText(out, "\\\""); break;
+    case '\\': writeText(out, "\\\\"); break;
+    case '\n': writeText(out, "\\n"); break;
+    case '\r': writeText(out, "\\r"); break;
+    case '\t': writeText(out, "\\t"); break;
+    default:
+        if ((uint8_t)c < 0x20) {
+            char escape[7];
+            snprintf(escape, sizeof(escape), "\\u%04x", (unsigned)(uint8_t)c);
+            writeText(out, escape);
+        } else {
+            out.write((uint8_t)c); // UTF-8 passes through unchanged
+        }
+        break;
+    }
+}
+
+size_t ChatBodyStream::readBytes(char *buffer, size_t length) {
+    if (length > _length - _offset) length = _length - _offset;
+    if (length == 0) return 0;
+    ChatWindowPrint window(buffer, _offset, length);
+    _context.writeBody(window);
+    _offset += length;
+    return length;
+}
+
+int ChatBodyStream::peek() {
+    if (_offset >= _length) return -1;
+    char c;
+    ChatWindowPrint window(&c, _offset, 1);
+    _context.writeBody(window);
+    return (uint8_t)c;
+}
+
+#endif
@@ -0,0 +1,240 @@
+// chatStream.h - Incremental parser for streamed chat completions (server-sent events)
+// With "stream": true, OpenRouter answers with SSE lines such as
+//
+//   data: {"id":"...","choices":[{"index":0,"delta":{"content":"Once upon"},...}]}
+//   : OPENROUTER PROCESSING
+//   data: [DONE]
+//
+// ChatStreamParser is a Stream sink for HTTPClient::writeToStream(), which also removes the
+// chunked transfer encoding. It scans the bytes as they arrive with a small state machine:
+// only "content" string values inside data lines are decoded (JSON escapes included) and
+// handed to a callback in pieces of at most CHAT_TOKEN_BUFFER bytes. Nothing else is kept,
+// so memory use is fixed however long the reply is.
+
+#ifndef CHAT_STREAM_H
+#define CHAT_STREAM_H
+
+#include <Arduino.h>
+
+#define CHAT_TOKEN_BUFFER 64
+
+// Called for each decoded piece of the reply. text is UTF-8 and not null terminated; a
+// multi-byte character may be split across two calls.
+typedef void (*ChatTokenHandler)(const char *text, size_t length, void *arg);
+
+class ChatStreamParser : public Stream {
+public:
+    void setHandler(ChatTokenHandler handler, void *arg) { _handler = handler; _handlerArg = arg; }
+
+    // reset(): Call before each response
+    void reset();
+
+    // Stream sink interface used by writeToStream()
+    size_t write(uint8_t c) override { feed((char)c); return 1; }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        for (size_t i = 0; i < size; i++) feed((char)buffer[i]);
+        return size;
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    // finish(): Hands out what is still buffered, e.g. if the stream ended without [DONE]
+    void finish() { flushToken(); }
+
+    bool isDone() { return _done; }                    // saw "data: [DONE]"
+    bool sawError() { return _error; }                 // a data line carried an "error" object
+    unsigned long getEventCount() { return _events; }
+    unsigned long getContentBytes() { return _contentBytes; }
+
+private:
+    enum State { LINE_START, SKIP_LINE, IN_DATA, AFTER_KEY, IN_STRING, ESCAPE, UNICODE };
+
+    ChatTokenHandler _handler = nullptr;
+    void *_handlerArg = nullptr;
+    State _state = LINE_START;
+    uint8_t _prefixLength = 0;         // characters of "data:" matched at the line start
+    uint8_t _keyMatch = 0;             // characters of "content": matched
+    uint8_t _doneMatch = 0;            // characters of [DONE] matched
+    uint8_t _errorMatch = 0;           // characters of "error": matched
+    uint32_t _unicode = 0;
+    uint8_t _unicodeDigits = 0;
+    uint16_t _highSurrogate = 0;
+    char _token[CHAT_TOKEN_BUFFER];
+    size_t _tokenLength = 0;
+    bool _done = false;
+    bool _error = false;
+    unsigned long _events = 0;
+    unsigned long _contentBytes = 0;
+
+    void feed(char c);
+    void scanData(char c);
+    void decodeEscape(char c);
+    void putCodepoint(uint32_t codepoint);
+    void put(char c);
+    void flushToken();
+    static bool match(char c, const char *pattern, uint8_t &matched);
+};
+
+// --- Implementation ---
+
+static const char CHAT_DATA_PREFIX[] = "data:";
+static const char CHAT_CONTENT_KEY[] = "\"content\":";
+static const char CHAT_DONE_MARK[] = "[DONE]";
+static const char CHAT_ERROR_KEY[] = "\"error\":";
+
+void ChatStreamParser::reset() {
+    _state = LINE_START;
+    _prefixLength = 0;
+    _keyMatch = _doneMatch = _errorMatch = 0;
+    _unicodeDigits = 0;
+    _highSurrogate = 0;
+    _tokenLength = 0;
+    _done = false;
+    _error = false;
+    _events = 0;
+    _contentBytes = 0;
+}
+
+// Advances a running match of pattern; true once all of it has been seen
+bool ChatStreamParser::match(char c, const char *pattern, uint8_t &matched) {
+    if (c == pattern[matched]) {
+        matched++;
+        if (pattern[matched] == '\0') {
+            matched = 0;
+            return true;
+        }
+        return false;
+    }
+    // None of the patterns repeat their first character, so a restart is enough
+    matched = (c == pattern[0]) ? 1 : 0;
+    return false;
+}
+
+void ChatStreamParser::feed(char c) {
+    if (c == '\r') return;
+    if (c == '\n' && _state != IN_STRING && _state != ESCAPE && _state != UNICODE) {
+        // End of an SSE line; a content string never spans lines
+        if (_state == IN_DATA || _state == AFTER_KEY) flushToken();
+        _state = LINE_START;
+        _prefixLength = 0;
+        return;
+    }
+
+    switch (_state) {
+    case LINE_START:
+        if (c == CHAT_DATA_PREFIX[_prefixLength]) {
+            if (CHAT_DATA_PREFIX[++_prefixLength] == '\0') {
+                _state = IN_DATA;
+                _keyMatch = _doneMatch = _errorMatch = 0;
+                _events++;
+            }
+        } else {
+            _state = SKIP_LINE; // comment (":"), "event:", "id:" or a blank line
+        }
+        break;
+    case SKIP_LINE:
+        break;
+    case IN_DATA:
+        scanData(c);
+        break;
+    case AFTER_KEY:
+        if (c == '"') {
+            _state = IN_STRING;
+        } else if (c != ' ') {
+            _state = IN_DATA; // "content":null
+            scanData(c);
+        }
+        break;
+    case IN_STRING:
+        if (c == '\\') {
+            _state = ESCAPE;
+        } else if (c == '"') {
+            _state = IN_DATA;
+        } else {
+            put(c);
+        }
+        break;
+    case ESCAPE:
+        decodeEscape(c);
+        break;
+    case UNICODE: {
+        uint8_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else { _state = IN_STRING; break; } // malformed escape, drop it
+        _unicode = (_unicode << 4) | digit;
+        if (++_unicodeDigits == 4) {
+            _state = IN_STRING;
+            putCodepoint(_unicode);
+        }
+        break;
+    }
+    }
+}
+
+void ChatStreamParser::scanData(char c) {
+    if (match(c, CHAT_CONTENT_KEY, _keyMatch)) _state = AFTER_KEY;
+    if (match(c, CHAT_DONE_MARK, _doneMatch)) _done = true;
+    if (match(c, CHAT_ERROR_KEY, _errorMatch)) _error = true;
+}
+
+void ChatStreamParser::decodeEscape(char c) {
+    _state = IN_STRING;
+    switch (c) {
+    case 'n': put('\n'); break;
+    case 't': put('\t'); break;
+    case 'r': put('\r'); break;
+    case 'b': put('\b'); break;
+    case 'f': put('\f'); break;
+    case 'u':
+        _state = UNICODE;
+        _unicode = 0;
+        _unicodeDigits = 0;
+        break;
+    default: put(c); break; // \" \\ \/
+    }
+}
+
+// UTF-16 code unit from a \u escape to UTF-8; surrogate pairs arrive as two escapes
+void ChatStreamParser::putCodepoint(uint32_t unit) {
+    if (unit >= 0xD800 && unit <= 0xDBFF) {
+        _highSurrogate = unit;
+        return;
+    }
+    uint32_t codepoint = unit;
+    if (unit >= 0xDC00 && unit <= 0xDFFF) {
+        if (!_highSurrogate) return;
+        codepoint = 0x10000 + (((uint32_t)_highSurrogate - 0xD800) << 10) + (unit - 0xDC00);
+    }
+    _highSurrogate = 0;
+    if (codepoint < 0x80) {
+        put((char)codepoint);
+    } else if (codepoint < 0x800) {
+        put((char)(0xC0 | (codepoint >> 6)));
+        put((char)(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        put((char)(0xE0 | (codepoint >> 12)));
+        put((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+        put((char)(0x80 | (codepoint & 0x3F)));
+    } else {
+        put((char)(0xF0 | (codepoint >> 18)));
+        put((char)(0x80 | ((codepoint >> 12) & 0x3F)));
+        put((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+        put((char)(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+void ChatStreamParser::put(char c) {
+    if (_tokenLength == CHAT_TOKEN_BUFFER) flushToken();
+    _token[_tokenLength++] = c;
+    _contentBytes++;
+}
+
+void ChatStreamParser::flushToken() {
+    if (_tokenLength && _handler) _handler(_token, _tokenLength, _handlerArg);
+    _tokenLength = 0;
+}
+
+#endif
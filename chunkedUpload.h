@@ -0,0 +1,146 @@
+// chunkedUpload.h - HTTP POST with a chunked request body, for streaming uploads
+// HTTPClient needs the whole body, or its length, before it sends anything. A recording
+// has neither until the user stops speaking. ChunkedUpload writes the request line and
+// headers by hand on a WiFiClient with "Transfer-Encoding: chunked". Every write() then
+// goes out as one chunk, so the server can start on the audio while recording continues.
+// finish() sends the final zero-length chunk and reads the response into a caller buffer.
+// No String is built, and nothing allocates per request.
+
+#ifndef CHUNKED_UPLOAD_H
+#define CHUNKED_UPLOAD_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define UPLOAD_CONNECT_TIMEOUT_MS 3000
+#define UPLOAD_RESPONSE_TIMEOUT_MS 15000 // the server may still be transcribing
+#define UPLOAD_LINE_BYTES 128
+
+// Negative results of finish(), next to the HTTP status codes
+#define UPLOAD_ERROR_NOT_STARTED (-1)
+#define UPLOAD_ERROR_SEND (-2)
+#define UPLOAD_ERROR_NO_RESPONSE (-3)
+
+class ChunkedUpload {
+public:
+    // begin(): Connects and sends the headers. extraHeaders are complete lines, each ending
+    // in "\r\n", or nullptr.
+    bool begin(const char *host, uint16_t port, const char *path, const char *contentType,
+               const char *extraHeaders = nullptr);
+
+    // write(): Sends data as one chunk. False once the connection failed.
+    bool write(const uint8_t *data, size_t length);
+
+    // finish(): Ends the body and reads the response. The body is stored null terminated,
+    // cut to bodySize - 1 bytes. Returns the HTTP status or an UPLOAD_ERROR_* code.
+    int finish(char *body, size_t bodySize);
+
+    // abort(): Drops the connection, the server sees an incomplete body
+    void abort();
+
+    bool isOpen() { return _open; }
+    unsigned long getBytesSent() { return _bytesSent; }   // body bytes of this request
+
+private:
+    WiFiClient _client;
+    bool _open = false;
+    unsigned long _bytesSent = 0;
+
+    bool writeText(const char *text) { return _client.write((const uint8_t *)text, strlen(text)) == strlen(text); }
+    size_t readLine(char *line, size_t size);
+};
+
+// --- Implementation ---
+
+bool ChunkedUpload::begin(const char *host, uint16_t port, const char *path, const char *contentType,
+                          const char *extraHeaders) {
+    abort();
+    _bytesSent = 0;
+    if (!_client.connect(host, port, UPLOAD_CONNECT_TIMEOUT_MS)) return false;
+
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+                          "POST %s HTTP/1.1\r\n"
+                          "Host: %s:%u\r\n"
+                          "Content-Type: %s\r\n"
+                          "Transfer-Encoding: chunked\r\n"
+                          "Connection: close\r\n",
+                          path, host, (unsigned)port, contentType);
+    if (length <= 0 || (size_t)length >= sizeof(header)) {
+        _client.stop();
+        return false;
+    }
+    _open = writeText(header) && (!extraHeaders || writeText(extraHeaders)) && writeText("\r\n");
+    if (!_open) _client.stop();
+    return _open;
+}
+
+bool ChunkedUpload::write(const uint8_t *data, size_t length) {
+    if (!_open) return false;
+    if (length == 0) return true; // a zero-length chunk would end the body
+    char size[12];
+    snprintf(size, sizeof(size), "%X\r\n", (unsigned)length);
+    if (!writeText(size) || _client.write(data, length) != length || !writeText("\r\n")) {
+        abort();
+        return false;
+    }
+    _bytesSent += length;
+    return true;
+}
+
+int ChunkedUpload::finish(char *body, size_t bodySize) {
+    if (bodySize) body[0] = '\0';
+    if (!_open) return UPLOAD_ERROR_NOT_STARTED;
+    if (!writeText("0\r\n\r\n")) {
+        abort();
+        return UPLOAD_ERROR_SEND;
+    }
+
+    // Status line, e.g. "HTTP/1.1 200 OK"
+    _client.setTimeout(UPLOAD_RESPONSE_TIMEOUT_MS);
+    char line[UPLOAD_LINE_BYTES];
+    if (!readLine(line, sizeof(line)) || strncmp(line, "HTTP/", 5) != 0) {
+        abort();
+        return UPLOAD_ERROR_NO_RESPONSE;
+    }
+    const char *space = strchr(line, ' ');
+    int status = space ? atoi(space + 1) : 0;
+
+    // Headers up to the blank line; only the body length matters
+    long contentLength = -1;
+    while (readLine(line, sizeof(line))) {
+        if (strncasecmp(line, "Content-Length:", 15) == 0) contentLength = atol(line + 15);
+    }
+
+    // Body: Content-Length bytes, or up to the close ("Connection: close" was requested)
+    size_t stored = 0;
+    long remaining = contentLength;
+    uint8_t scratch[64];
+    while (remaining != 0) {
+        size_t want = contentLength < 0 ? sizeof(scratch) : min((size_t)remaining, sizeof(scratch));
+        size_t n = _client.readBytes(scratch, want);
+        if (n == 0) break; // closed or timed out
+        size_t keep = bodySize > stored + 1 ? min(n, bodySize - 1 - stored) : 0;
+        memcpy(body + stored, scratch, keep);
+        stored += keep;
+        if (contentLength >= 0) remaining -= n;
+    }
+    if (bodySize) body[stored] = '\0';
+    abort();
+    return status;
+}
+
+void ChunkedUpload::abort() {
+    if (_open || _client.connected()) _client.stop();
+    _open = false;
+}
+
+// One header line without its CRLF; 0 at the blank line that ends the headers or on timeout
+size_t ChunkedUpload::readLine(char *line, size_t size) {
+    size_t length = _client.readBytesUntil('\n', line, size - 1);
+    if (length && line[length - 1] == '\r') length--;
+    line[length] = '\0';
+    return length;
+}
+
+#endif
@@ -1,7 +1,8 @@
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h> // For JSON handling
+#include "openRouterClient.h" // Keep-alive HTTPS connection to OpenRouter
+#include "chatContext.h" // Conversation history in a fixed arena
+#include "responseCache.h" // Instant replies for repeated small talk
 
 // Replace with your network credentials
 const char* ssid = "YOUR_WIFI_SSID";
@@ -11,8 +12,8 @@ const char* password = "YOUR_WIFI_PASSWORD";
 const char* OPENROUTER_API_KEY = "sk-YOUR_OPENROUTER_API_KEY"; 
 
 // OpenRouter.ai API endpoint for chat completions
-const char* openrouterHost = "openrouter.ai";
-const char* openrouterEndpoint = "/api/v1/chat/completions";
+const char* openrouterHost = OPENROUTER_DEFAULT_HOST;
+const char* openrouterEndpoint = OPENROUTER_DEFAULT_ENDPOINT;
 
 // The root CA certificate for openrouter.ai (or its underlying CDN/proxy)
 // You MUST replace this with the actual root CA certificate you extracted.
@@ -26,7 +27,55 @@ MIIDrzCCApegAwIBAgIQCDvgOfc2HU2gKzFu4W4E9zANBgkqhkiG9w0BAQsFADBL
 )EOF";
 
 
-WiFiClientSecure client; // Declare WiFiClientSecure client globally or in main loop
+// One connection for all requests: only the first one (or one after the server dropped
+// the idle connection) pays for the TLS handshake
+OpenRouterClient llm;
+
+// Streaming mode: the reply arrives as server-sent events and every token is handed to
+// onToken() right away, so speech and the eyes can react to the first words. Memory use
+// does not grow with the length of the answer. Set to false for one JSON reply.
+const bool streamReply = true;
+unsigned long firstTokenMs = 0;   // time from request to the first token, 0 until it arrives
+unsigned long requestStartMs = 0;
+
+// The conversation: persona, system prompt and the recent turns, trimmed to the token budget
+ChatContext chat;
+
+// Replies to standalone small talk, kept across reboots
+ResponseCache replyCache;
+
+// Example prompts with how long their reply may be cached (0: never). The follow-ups
+// depend on the earlier turns, so a cached answer would be wrong for them.
+struct Prompt {
+  const char* text;
+  uint32_t cacheTtlS;
+};
+const Prompt prompts[] = {
+  {"How are you?", 6UL * 3600UL},
+  {"Tell me a short story about an adventurous cat.", 0},
+  {"What was the cat's name again?", 0},
+  {"Continue the story with one more adventure.", 0},
+};
+const uint8_t promptCount = sizeof(prompts) / sizeof(prompts[0]);
+uint8_t nextPrompt = 0;
+
+// Copy of the streamed reply for the cache; too long means it is not cached
+char replyText[RESPONSE_CACHE_REPLY_BYTES];
+size_t replyLength = 0;
+bool replyTooLong = false;
+
+// Called for every decoded piece of the reply; hand it to TTS / the eyes from here
+void onToken(const char *text, size_t length, void *arg) {
+  if (firstTokenMs == 0) firstTokenMs = millis() - requestStartMs;
+  Serial.write((const uint8_t *)text, length);
+  chat.append(text, length); // the reply becomes the assistant turn
+  if (replyLength + length < sizeof(replyText)) {
+    memcpy(replyText + replyLength, text, length);
+    replyLength += length;
+  } else {
+    replyTooLong = true;
+  }
+}
 
 void setup() {
   Serial.begin(115200);
@@ -43,51 +92,106 @@ void setup() {
   Serial.print("IP Address: ");
   Serial.println(WiFi.localIP());
 
-  // Set the root CA certificate for HTTPS
-  client.setCACert(openrouter_root_ca);
+  // Set the root CA certificate for HTTPS and open the connection ahead of the first request
+  if (!llm.begin(OPENROUTER_API_KEY, openrouter_root_ca, openrouterHost, openrouterEndpoint)) {
+    Serial.println("OpenRouter: no root CA set, requests will fail!");
+  }
+  llm.setAppInfo("YOUR_SITE_URL", "YOUR_APP_NAME"); // Optional: for OpenRouter rankings
+  chat.setModel("deepseek/deepseek-r1:free"); // Or "microsoft/mai-ds-r1:free"
+  chat.setStream(streamReply);
+  chat.setPersona("You are Emo, a small desk robot with expressive eyes and a playful personality.");
+  chat.setSystemPrompt("Keep answers short, they are spoken aloud.");
+
+  if (replyCache.begin()) {
+    Serial.print("Reply cache loaded, ");
+    Serial.print(replyCache.getEntryCount());
+    Serial.println(" entries");
+  }
+
+  if (llm.warmUp()) {
+    Serial.print("TLS handshake took ");
+    Serial.print(llm.getLastHandshakeMs());
+    Serial.println(" ms");
+  }
 }
 
 void loop() {
   // Only make a request when connected to Wi-Fi
   if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nMaking a request to OpenRouter.ai...");
-
-    HTTPClient http;
-    http.begin(client, openrouterHost, 443, openrouterEndpoint, true); // Use HTTPS (port 443)
-
-    // Set HTTP headers
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("Authorization", "Bearer " + String(OPENROUTER_API_KEY));
-    // Optional: for OpenRouter rankings
-    http.addHeader("HTTP-Referer", "YOUR_SITE_URL"); 
-    http.addHeader("X-Title", "YOUR_APP_NAME");
-
-    // Construct the JSON request body
-    // Use ArduinoJson Assistant (https://arduinojson.org/assistant/) to calculate buffer size
-    const size_t CAPACITY = JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(1) + JSON_OBJECT_SIZE(2);
-    StaticJsonDocument<CAPACITY> doc;
-
-    doc["model"] = "deepseek/deepseek-r1:free"; // Or "microsoft/mai-ds-r1:free"
-    
-    JsonArray messages = doc.createNestedArray("messages");
-    JsonObject message1 = messages.createNestedObject();
-    message1["role"] = "user";
-    message1["content"] = "Tell me a short story about an adventurous cat.";
+    const Prompt &prompt = prompts[nextPrompt];
+    nextPrompt = (nextPrompt + 1) % promptCount;
+
+    // Add the user turn; the request body is generated from the context while it is sent
+    chat.addTurn(CHAT_ROLE_USER, prompt.text);
+
+    // Repeated small talk is answered from the cache, without a round trip
+    const char *cached = prompt.cacheTtlS ? replyCache.get(prompt.text) : nullptr;
+    if (cached) {
+      Serial.print("Cached reply: ");
+      Serial.println(cached);
+      chat.addTurn(CHAT_ROLE_ASSISTANT, cached);
+      Serial.print("Reply cache hit rate: ");
+      Serial.print(replyCache.getHitRatePercent());
+      Serial.println("%");
+      delay(5000);
+      return;
+    }
 
-    String requestBody;
-    serializeJson(doc, requestBody);
+    Serial.println("\nMaking a request to OpenRouter.ai...");
 
     Serial.print("Sending JSON: ");
-    Serial.println(requestBody);
-
-    // Send the POST request
-    int httpResponseCode = http.POST(requestBody);
+    chat.writeBody(Serial);
+    Serial.println();
+    Serial.print("Context: ");
+    Serial.print(chat.getTurnCount());
+    Serial.print(" turns, ~");
+    Serial.print(chat.getEstimatedTokens());
+    Serial.print(" tokens, ");
+    Serial.print(chat.getDroppedTurns());
+    Serial.println(" turns dropped so far");
+
+    // Send the POST request over the kept-alive connection (HTTPS, port 443)
+    requestStartMs = millis();
+    firstTokenMs = 0;
+    replyLength = 0;
+    replyTooLong = false;
+    int httpResponseCode = llm.post(chat);
+    HTTPClient &http = llm.http();
 
     if (httpResponseCode > 0) {
       Serial.print("HTTP Response code: ");
-      Serial.println(httpResponseCode);
+      Serial.print(httpResponseCode);
+      Serial.print(", time to headers: ");
+      Serial.print(millis() - requestStartMs);
+      Serial.println(llm.lastRequestReused() ? " ms (reused connection)" : " ms (new connection)");
 
-      if (httpResponseCode == HTTP_CODE_OK || httpResponseCode == HTTP_CODE_MOVED_PERMANENTLY) {
+      if (streamReply && httpResponseCode == HTTP_CODE_OK) {
+        Serial.print("Generated Text: ");
+        chat.beginTurn(CHAT_ROLE_ASSISTANT);
+        int result = llm.readStream(onToken);
+        chat.endTurn();
+        Serial.println();
+        ChatStreamParser &stream = llm.stream();
+        if (result < 0) {
+          Serial.print("Stream interrupted: ");
+          Serial.println(http.errorToString(result));
+        } else if (stream.sawError()) {
+          Serial.println("OpenRouter reported an error in the stream");
+        }
+        Serial.print("First token after ");
+        Serial.print(firstTokenMs);
+        Serial.print(" ms, ");
+        Serial.print(stream.getContentBytes());
+        Serial.print(" bytes in ");
+        Serial.print(stream.getEventCount());
+        Serial.println(stream.isDone() ? " events" : " events (no [DONE])");
+
+        // Only a complete reply is worth keeping
+        if (prompt.cacheTtlS && result >= 0 && stream.isDone() && !stream.sawError() && !replyTooLong) {
+          replyText[replyLength] = '\0';
+          if (replyCache.put(prompt.text, replyText, replyLength, prompt.cacheTtlS)) replyCache.save();
+        }
+      } else if (httpResponseCode == HTTP_CODE_OK || httpResponseCode == HTTP_CODE_MOVED_PERMANENTLY) {
         String payload = http.getString();
         Serial.println("Response from OpenRouter.ai:");
         Serial.println(payload);
@@ -99,19 +203,24 @@ void loop() {
         if (error) {
           Serial.print(F("deserializeJson() failed: "));
           Serial.println(error.f_str());
+          llm.end();
           return;
         }
 
         String generatedText = responseDoc["choices"][0]["message"]["content"].as<String>();
         Serial.print("Generated Text: ");
         Serial.println(generatedText);
+        chat.addTurn(CHAT_ROLE_ASSISTANT, generatedText.c_str());
+        if (prompt.cacheTtlS && replyCache.put(prompt.text, generatedText.c_str(), prompt.cacheTtlS)) {
+          replyCache.save();
+        }
       }
     } else {
       Serial.print("Error sending POST request: ");
       Serial.println(http.errorToString(httpResponseCode));
     }
 
-    http.end(); // Free resources
+    llm.end(); // Done with this response, the connection stays open for the next request
   } else {
     Serial.println("WiFi not connected. Retrying in 5 seconds...");
   }
@@ -7,6 +7,14 @@
 
 #include <Arduino.h>
 #include <Wire.h> // Required for I2C communication with MPU-6050
+#if defined(ESP32)
+#include <Preferences.h> // NVS storage for calibration offsets
+#endif
+
+// Only the ESP32 core places ISRs in IRAM; elsewhere the attribute is not needed
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
 
 // MPU-6050 I2C address
 #define MPU6050_ADDR 0x68 // SDO pin low
@@ -17,6 +25,10 @@
 #define MPU6050_CONFIG 0x1A       // Configuration
 #define MPU6050_GYRO_CONFIG 0x1B  // Gyroscope Configuration
 #define MPU6050_ACCEL_CONFIG 0x1C // Accelerometer Configuration
+#define MPU6050_FIFO_EN 0x23      // FIFO Enable (which sensors are written to the FIFO)
+#define MPU6050_INT_PIN_CFG 0x37  // INT Pin / Bypass Enable Configuration
+#define MPU6050_INT_ENABLE 0x38   // Interrupt Enable
+#define MPU6050_INT_STATUS 0x3A   // Interrupt Status (cleared on read)
 #define MPU6050_ACCEL_XOUT_H 0x3B // Accel X-axis High Byte
 #define MPU6050_ACCEL_XOUT_L 0x3C // Accel X-axis Low Byte
 #define MPU6050_ACCEL_YOUT_H 0x3D // Accel Y-axis High Byte
@@ -31,15 +43,155 @@
 #define MPU6050_GYRO_YOUT_L 0x46  // Gyro Y-axis Low Byte
 #define MPU6050_GYRO_ZOUT_H 0x47  // Gyro Z-axis High Byte
 #define MPU6050_GYRO_ZOUT_L 0x48  // Gyro Z-axis Low Byte
+#define MPU6050_USER_CTRL 0x6A    // User Control (FIFO enable / reset)
 #define MPU6050_PWR_MGMT_1 0x6B   // Power Management 1
+#define MPU6050_FIFO_COUNTH 0x72  // FIFO Count High Byte
+#define MPU6050_FIFO_COUNTL 0x73  // FIFO Count Low Byte
+#define MPU6050_FIFO_R_W 0x74     // FIFO Read/Write
 #define MPU6050_WHO_AM_I 0x75     // Who Am I (Device ID)
 
+// Register bit masks used by the FIFO acquisition mode
+#define MPU6050_FIFO_EN_TEMP_GYRO_ACCEL 0xF8 // TEMP | XG | YG | ZG | ACCEL -> same 14-byte layout as a burst read
+#define MPU6050_INT_DATA_RDY 0x01            // INT_ENABLE / INT_STATUS: new sample ready
+#define MPU6050_INT_FIFO_OFLOW 0x10          // INT_ENABLE / INT_STATUS: FIFO overflowed
+#define MPU6050_USER_CTRL_FIFO_EN 0x40       // USER_CTRL: enable FIFO
+#define MPU6050_USER_CTRL_FIFO_RESET 0x04    // USER_CTRL: reset FIFO (self-clearing)
+#define MPU6050_FIFO_SIZE 1024               // Hardware FIFO size in bytes
+
+// Burst read of one full sample: ACCEL_XOUT_H (0x3B) through GYRO_ZOUT_L (0x48).
+// Layout: accel X/Y/Z, temperature, gyro X/Y/Z, each as big-endian int16.
+#define MPU6050_SAMPLE_BYTES 14
+
+// Upper bound for waiting on I2C data, in microseconds. Keeps a stuck bus
+// (e.g. a slave holding SDA low) from hanging the task that calls update().
+#define MPU6050_I2C_TIMEOUT_US 2000
+
+// Software ring buffer for FIFO mode, in samples. Must be a power of two, at most 128.
+// 32 samples cover 256 ms at the 125 Hz rate configured in begin().
+#ifndef AEMO_SAMPLE_RING_SIZE
+#define AEMO_SAMPLE_RING_SIZE 32
+#endif
+
+// Samples pulled from the hardware FIFO per I2C transaction. Bounded by the
+// Wire buffer: 128 bytes on ESP32 (8 x 14), 32 bytes on AVR (2 x 14).
+#ifndef AEMO_FIFO_BURST_SAMPLES
+#if defined(ESP32)
+#define AEMO_FIFO_BURST_SAMPLES 8
+#else
+#define AEMO_FIFO_BURST_SAMPLES 2
+#endif
+#endif
+
 // MPU-6050 Full Scale Ranges (Default to +/- 2g and +/- 250 deg/s)
 // These define the sensitivity of the sensor and the raw data scaling.
-// Accel FSR: +/-2g = 16384 LSB/g, +/-4g = 8192 LSB/g, +/-8g = 4096 LSB/g, +/-16g = 2048 LSB/g
-// Gyro FSR: +/-250 deg/s = 131 LSB/deg/s, +/-500 = 65.5 LSB/deg/s, etc.
-#define ACCEL_SCALE_FACTOR 16384.0 // LSB/g for +/- 2g range
-#define GYRO_SCALE_FACTOR 131.0    // LSB/deg/s for +/- 250 deg/s range
+// The enum values are the ACCEL_CONFIG / GYRO_CONFIG register values, so the
+// range written in begin() and the scale used for conversions come from the
+// same compile-time setting and cannot drift apart.
+enum AemoAccelRange : uint8_t {
+    AEMO_ACCEL_2G = 0x00,  // 16384 LSB/g
+    AEMO_ACCEL_4G = 0x08,  // 8192 LSB/g
+    AEMO_ACCEL_8G = 0x10,  // 4096 LSB/g
+    AEMO_ACCEL_16G = 0x18  // 2048 LSB/g
+};
+enum AemoGyroRange : uint8_t {
+    AEMO_GYRO_250DPS = 0x00,  // 131 LSB/deg/s
+    AEMO_GYRO_500DPS = 0x08,  // 65.5 LSB/deg/s
+    AEMO_GYRO_1000DPS = 0x10, // 32.8 LSB/deg/s
+    AEMO_GYRO_2000DPS = 0x18  // 16.4 LSB/deg/s
+};
+
+// Select the ranges at build time, e.g. -DAEMO_ACCEL_RANGE=AEMO_ACCEL_4G
+#ifndef AEMO_ACCEL_RANGE
+#define AEMO_ACCEL_RANGE AEMO_ACCEL_2G
+#endif
+#ifndef AEMO_GYRO_RANGE
+#define AEMO_GYRO_RANGE AEMO_GYRO_250DPS
+#endif
+
+// Scale constants for a given pair of full-scale ranges, all evaluated at compile time.
+template <AemoAccelRange AccelRange, AemoGyroRange GyroRange>
+struct AemoScale {
+    static constexpr uint8_t accelConfig = AccelRange;
+    static constexpr uint8_t gyroConfig = GyroRange;
+
+    // Accel sensitivity halves with every range step: 16384 >> (0..3)
+    static constexpr int32_t accelLsbPerG = 16384L >> (AccelRange >> 3);
+    static constexpr float gPerLsb = 1.0f / accelLsbPerG;
+
+    // Gyro sensitivity is not an integer above 250 deg/s, so it is kept in tenths of an LSB
+    static constexpr int32_t gyroLsbPerDpsX10 =
+        GyroRange == AEMO_GYRO_250DPS ? 1310 :
+        GyroRange == AEMO_GYRO_500DPS ? 655 :
+        GyroRange == AEMO_GYRO_1000DPS ? 328 : 164;
+    static constexpr float gyroLsbPerDps = gyroLsbPerDpsX10 / 10.0f;
+    static constexpr float dpsPerLsb = 10.0f / gyroLsbPerDpsX10;
+    static constexpr float radPerSecPerLsb = dpsPerLsb * 0.01745329252f; // For the orientation filter
+};
+typedef AemoScale<AEMO_ACCEL_RANGE, AEMO_GYRO_RANGE> AemoActiveScale;
+
+// Fixed-point pipeline: 1 keeps the hot path (update(), detectors) integer-only.
+// Samples stay in raw LSB units, thresholds are converted to LSB when they are set,
+// and conversion to g / deg/s only happens in the accessors.
+#ifndef AEMO_FIXED_POINT
+#define AEMO_FIXED_POINT 0
+#endif
+
+#define AEMO_RAD_TO_DEG 57.29577951f // Single precision; the ESP32 FPU has no double support
+
+// Calibration: number of stationary samples averaged by calibrate(). Sampled at
+// 250 Hz while calibrating, so the default takes about a second.
+#define AEMO_CALIBRATION_SAMPLES 256
+
+// Sample rate divider while calibrating: 1 kHz / (1 + 3) = 250 Hz, 3.5 kB/s of FIFO data.
+// The full 1 kHz (14 kB/s) is more than a 100 kHz I2C bus can drain, the FIFO would overflow.
+#define AEMO_CALIBRATION_DIVIDER 3
+
+// FIFO overflows tolerated during one calibrate() call; each one restarts the averaging
+#define AEMO_CALIBRATION_MAX_RESTARTS 3
+
+// Maximum gyro standard deviation (deg/s) accepted as "stationary" during calibration
+#define AEMO_CALIBRATION_MAX_GYRO_STDDEV 2.0f
+
+// NVS namespace / key used to persist calibration offsets on ESP32
+#define AEMO_CALIBRATION_NVS_NAMESPACE "aemo"
+#define AEMO_CALIBRATION_NVS_KEY "cal"
+
+// Sensor biases in raw LSB, subtracted from every sample before any processing.
+struct AemoCalibration {
+    int16_t accelBias[3]; // X, Y, Z; Z excludes the 1 g of gravity
+    int16_t gyroBias[3];  // X, Y, Z
+};
+
+// Orientation filter: 1 fuses gyro and accel into a quaternion on every sample
+// (Madgwick, IMU variant). Float-only, about 100 multiplies and two square roots
+// per sample, which is well within budget at 1 kHz on one ESP32 core.
+#ifndef AEMO_ORIENTATION_FILTER
+#define AEMO_ORIENTATION_FILTER 1
+#endif
+
+// Filter gain: higher trusts the accelerometer more (faster drift correction,
+// more sensitive to linear acceleration). 0.1 is Madgwick's suggested starting point.
+#define AEMO_ORIENTATION_BETA 0.1f
+
+// Gaps between samples longer than this (seconds) are not integrated;
+// the filter re-seeds from the accelerometer instead.
+#define AEMO_ORIENTATION_MAX_DT 0.25f
+
+// Per-sample feature frame, computed once when a sample is loaded.
+// Detectors read from here instead of recomputing magnitudes and angles.
+struct AemoFeatures {
+#if AEMO_FIXED_POINT
+    uint32_t accelMagnitudeSq; // ax^2 + ay^2 + az^2, in LSB^2
+    uint32_t accelMagnitude;   // Integer sqrt of the above, in LSB (needed for jerk deltas)
+    uint32_t gyroMagnitudeSq;  // gx^2 + gy^2 + gz^2, in LSB^2
+#else
+    float accelMagnitudeSq; // ax^2 + ay^2 + az^2, in g^2
+    float accelMagnitude;   // sqrt of the above, in g (needed for jerk deltas)
+    float gyroMagnitudeSq;  // gx^2 + gy^2 + gz^2, in (deg/s)^2
+    float roll;             // Accelerometer roll in degrees
+    float pitch;            // Accelerometer pitch in degrees
+#endif
+};
 
 class AemoMotion {
 public:
@@ -50,17 +202,106 @@ public:
     // Returns true on success, false on failure.
     bool begin();
 
+    // beginCalibrated(): begin() plus bias calibration, tuned for fast boots.
+    // Reuses offsets stored in NVS when present; otherwise calibrates (the robot
+    // must be stationary) and stores the result so later boots skip that step.
+    // Returns false only if the sensor could not be initialized.
+    bool beginCalibrated(uint16_t sampleCount = AEMO_CALIBRATION_SAMPLES);
+
+    // --- Bias Calibration ---
+
+    // calibrate(): Averages sampleCount stationary samples to compute the biases,
+    // reading them from the FIFO at 250 Hz. Gyro bias is always measured; accel bias
+    // only if includeAccel is true, which also requires the robot to sit level (Z up).
+    // Returns false, leaving the current calibration untouched, if the robot moved.
+    bool calibrate(uint16_t sampleCount = AEMO_CALIBRATION_SAMPLES, bool includeAccel = false);
+
+    // saveCalibration() / loadCalibration(): Persist the offsets in NVS (ESP32 only).
+    // Stored offsets are rejected if they were taken with different full-scale ranges.
+    bool saveCalibration();
+    bool loadCalibration();
+
+    // clearCalibration(): Zeroes the offsets and erases the stored copy.
+    void clearCalibration();
+
+    const AemoCalibration &getCalibration() { return _calibration; }
+    void setCalibration(const AemoCalibration &calibration) { _calibration = calibration; }
+
     // Updates sensor data. Call this frequently in your loop().
-    void update();
+    // Reads the whole sample in a single 14-byte I2C transaction.
+    // Returns false if the bus timed out; the previous values are kept in that case.
+    bool update();
+
+    // Number of update() calls that failed because of an I2C error or timeout.
+    unsigned long getI2CErrorCount() { return _i2cErrorCount; }
+
+    // replaySample(): Loads a recorded 14-byte sample (the burst-read layout) as the current
+    // reading, exactly like update() would. For replaying traces, see motionBench.h.
+    void replaySample(const uint8_t *buffer, unsigned long timestampUs) { loadSample(buffer, timestampUs); }
+
+    // --- FIFO + Interrupt Acquisition Mode ---
+    // Instead of polling update(), the MPU-6050 writes every sample into its FIFO
+    // and pulses the INT pin on each new sample. serviceFifo() moves complete
+    // samples into a ring buffer, and nextSample() loads them one at a time so the
+    // detectors see every sample at the full rate, each with its own timestamp.
+    // serviceFifo() and nextSample() must be called from the same task.
+
+    // beginFifo(): Enables the FIFO and the data-ready interrupt. Call after begin().
+    // interruptPin: GPIO wired to the MPU-6050 INT pin.
+    // batchSize: Number of data-ready pulses between wake-ups of the notify task.
+    // Returns false if the pin has no interrupt capability.
+    bool beginFifo(int interruptPin, uint8_t batchSize = 8);
+
+#if defined(ESP32)
+    // setNotifyTask(): Task to wake with a task notification once every batchSize samples.
+    // The task typically blocks in ulTaskNotifyTake() and then calls serviceFifo().
+    void setNotifyTask(TaskHandle_t task) { _notifyTask = task; }
+#endif
+
+    // fifoPending(): True if samples arrived since the last serviceFifo().
+    bool fifoPending() { return _dataReadyCount != _dataReadyServiced; }
+
+    // serviceFifo(): Drains complete samples from the hardware FIFO into the ring buffer.
+    // Returns the number of samples moved. Resets the FIFO if it overflowed.
+    uint8_t serviceFifo();
+
+    // nextSample(): Loads the oldest buffered sample as the current reading.
+    // Returns false when the ring buffer is empty.
+    bool nextSample();
+
+    // samplesAvailable(): Number of samples waiting in the ring buffer.
+    uint8_t samplesAvailable() { return (uint8_t)(_ringHead - _ringTail); }
+
+    // getSampleTimeUs(): Timestamp (micros()) of the current sample.
+    unsigned long getSampleTimeUs() { return _sampleTimeUs; }
+
+    // Number of times the hardware FIFO overflowed and had to be reset.
+    unsigned long getFifoOverflowCount() { return _fifoOverflowCount; }
+
+    // Called from the data-ready interrupt. Not for application use.
+    void handleDataReady();
 
     // --- Raw Sensor Data Accessors ---
-    float getAccelX() { return _accelX; }
-    float getAccelY() { return _accelY; }
-    float getAccelZ() { return _accelZ; }
-    float getGyroX() { return _gyroX; }
-    float getGyroY() { return _gyroY; }
-    float getGyroZ() { return _gyroZ; }
-    float getTemperature() { return _temperature; }
+    // Converted to g, deg/s and Celsius on demand
+    float getAccelX() { return _rawAccelX * AemoActiveScale::gPerLsb; }
+    float getAccelY() { return _rawAccelY * AemoActiveScale::gPerLsb; }
+    float getAccelZ() { return _rawAccelZ * AemoActiveScale::gPerLsb; }
+    float getGyroX() { return _rawGyroX * AemoActiveScale::dpsPerLsb; }
+    float getGyroY() { return _rawGyroY * AemoActiveScale::dpsPerLsb; }
+    float getGyroZ() { return _rawGyroZ * AemoActiveScale::dpsPerLsb; }
+    // Temperature in Celsius = (raw_temp / 340) + 36.53
+    float getTemperature() { return _rawTemp * (1.0f / 340.0f) + 36.53f; }
+
+    // Unconverted register values, in LSB
+    int16_t getRawAccelX() { return _rawAccelX; }
+    int16_t getRawAccelY() { return _rawAccelY; }
+    int16_t getRawAccelZ() { return _rawAccelZ; }
+    int16_t getRawGyroX() { return _rawGyroX; }
+    int16_t getRawGyroY() { return _rawGyroY; }
+    int16_t getRawGyroZ() { return _rawGyroZ; }
+
+    // Feature frame of the current sample
+    const AemoFeatures &getFeatures() { return _features; }
 
     // --- Motion Feature Detection Functions ---
 
@@ -85,14 +326,38 @@ public:
     // Returns true if the robot is tilted.
     bool isTilted(float thresholdDegrees = 20.0);
 
-    // getRoll(): Calculates the roll angle (rotation around X-axis) in degrees.
-    // Based on accelerometer data.
+    // getRoll(): Roll angle (rotation around X-axis) in degrees.
+    // Based on accelerometer data. Computed once per sample in the float build,
+    // on demand in the fixed-point build.
     float getRoll();
 
-    // getPitch(): Calculates the pitch angle (rotation around Y-axis) in degrees.
-    // Based on accelerometer data.
+    // getPitch(): Pitch angle (rotation around Y-axis) in degrees.
+    // Based on accelerometer data. Computed once per sample in the float build,
+    // on demand in the fixed-point build.
     float getPitch();
 
+#if AEMO_ORIENTATION_FILTER
+    // --- Fused Orientation (gyro + accel) ---
+    // Unlike getRoll()/getPitch(), these stay stable while the robot is driving or
+    // being shaken, because short-term motion is tracked by the gyro and the
+    // accelerometer only corrects long-term drift. Yaw is relative to the heading
+    // at start-up (no magnetometer) and slowly drifts.
+
+    // getFusedRoll(), getFusedPitch(), getFusedYaw(): Euler angles in degrees.
+    float getFusedRoll();
+    float getFusedPitch();
+    float getFusedYaw();
+
+    // getQuaternion(): Orientation as a unit quaternion (w, x, y, z).
+    void getQuaternion(float &w, float &x, float &y, float &z) { w = _q0; x = _q1; y = _q2; z = _q3; }
+
+    // setOrientationGain(): Sets the filter gain (beta), see AEMO_ORIENTATION_BETA.
+    void setOrientationGain(float beta) { _beta = beta; }
+
+    // resetOrientation(): Re-seeds the filter from the accelerometer on the next sample.
+    void resetOrientation() { _orientationSeeded = false; }
+#endif
+
     // isSpinning(): Detects if the robot is rotating rapidly and continuously.
     // gyroThresholdDPS: Angular velocity threshold in degrees per second (DPS).
     // durationMs: How long the gyroscope readings must exceed the threshold to be considered spinning.
@@ -128,24 +393,72 @@ public:
 
 
 private:
-    // Raw sensor readings (converted to g and deg/s)
+    // Raw sensor readings in LSB; converted lazily by the accessors
+    int16_t _rawAccelX = 0, _rawAccelY = 0, _rawAccelZ = 0;
+    int16_t _rawGyroX = 0, _rawGyroY = 0, _rawGyroZ = 0;
+    int16_t _rawTemp = 0;
+#if !AEMO_FIXED_POINT
+    // Converted readings used by the float feature computation (g and deg/s)
     float _accelX, _accelY, _accelZ;
     float _gyroX, _gyroY, _gyroZ;
-    float _temperature;
+#endif
+    AemoFeatures _features;
+    AemoCalibration _calibration = {{0, 0, 0}, {0, 0, 0}};
+
+#if AEMO_ORIENTATION_FILTER
+    // Orientation quaternion and filter gain
+    float _q0 = 1.0f, _q1 = 0.0f, _q2 = 0.0f, _q3 = 0.0f;
+    float _beta = AEMO_ORIENTATION_BETA;
+    bool _orientationSeeded = false;
+#endif
 
     // Time tracking variables for rate-based detections
     unsigned long _lastUpdateTime;
     float _dt; // Time elapsed since last update in seconds
+    unsigned long _sampleTimeUs = 0; // Timestamp of the current sample, used by the detectors
+    unsigned long _i2cErrorCount = 0; // Failed bus transactions seen by update()
+
+    // --- FIFO Mode State ---
+    struct RawSample {
+        unsigned long timestampUs;
+        uint8_t data[MPU6050_SAMPLE_BYTES];
+    };
+    RawSample _ring[AEMO_SAMPLE_RING_SIZE];
+    uint8_t _ringHead = 0; // Next slot to write (free-running, wraps at 256)
+    uint8_t _ringTail = 0; // Next slot to read
+    bool _fifoMode = false;
+    unsigned long _samplePeriodUs = 8000; // 1 / 125 Hz, matches SMPLRT_DIV in begin()
+    unsigned long _fifoOverflowCount = 0;
+    uint8_t _batchSize = 8;
+
+    // Written by the interrupt handler
+    volatile unsigned long _lastDataReadyUs = 0;
+    volatile unsigned long _dataReadyCount = 0;
+    unsigned long _dataReadyServiced = 0;
+#if defined(ESP32)
+    TaskHandle_t _notifyTask = NULL;
+    portMUX_TYPE _dataReadyMux = portMUX_INITIALIZER_UNLOCKED; // time and count change as a pair
+#endif
 
     // --- Internal State Variables for Motion Detection ---
 
     // Shake detection variables
     float _shakeThreshold = 1.5; // Default shake threshold in g
-    unsigned long _lastShakeTriggerTime = 0;
+#if AEMO_FIXED_POINT
+    uint32_t _shakeThresholdSq; // Squared, in LSB^2; set in the constructor
+#else
+    float _shakeThresholdSq = 1.5 * 1.5; // Squared, compared against accelMagnitudeSq
+#endif
+    unsigned long _lastShakeTriggerTime = 0; // Sample timestamps below are in microseconds
     unsigned long _shakeCooldownMs = 1000; // Cooldown period after a shake detection
 
     // Freefall detection variables
     float _freefallAccelThreshold = 0.2; // Default freefall acceleration threshold in g
+#if AEMO_FIXED_POINT
+    uint32_t _freefallAccelThresholdSq; // Squared, in LSB^2; set in the constructor
+#else
+    float _freefallAccelThresholdSq = 0.2 * 0.2; // Squared, compared against accelMagnitudeSq
+#endif
     unsigned long _freefallDurationThreshold = 100; // Default freefall duration in ms
     unsigned long _freefallStartTime = 0;
     bool _isCurrentlyFreefalling = false; // Internal state flag
@@ -161,7 +474,20 @@ private:
     unsigned long _jerkDurationThreshold = 50; // Default jerk duration (unused for simple jerk, but kept for consistency)
     unsigned long _lastJerkTriggerTime = 0;
     unsigned long _jerkCooldownMs = 500; // Cooldown period after a jerk detection
+#if AEMO_FIXED_POINT
+    uint32_t _prevAccelMagnitude = 0; // Previous total acceleration magnitude for jerk calculation, in LSB
+
+    // isSpinning(), isJerk() and isTilted() take their thresholds per call. The LSB
+    // conversion is cached and only redone when the caller passes a different value.
+    float _spinThresholdCacheDPS = -1.0;
+    uint32_t _spinThresholdCacheSq = 0;
+    float _jerkThresholdCacheG = -1.0;
+    uint32_t _jerkThresholdCacheLsb = 0;
+    float _tiltThresholdCacheDeg = -1.0;
+    uint32_t _tiltTanSqQ16 = 0; // tan^2(threshold) in Q16.16
+#else
     float _prevAccelMagnitude = 0.0; // Previous total acceleration magnitude for jerk calculation
+#endif
 
     // --- MPU-6050 Communication Helpers ---
 
@@ -173,14 +499,67 @@ private:
 
     // Reads 16-bit signed integer (two bytes) from MPU-6050 registers
     int16_t readMPU6050Word(uint8_t reg);
+
+    // Reads 'length' consecutive registers starting at 'reg' in one transaction.
+    // Returns false if fewer bytes arrived than requested within MPU6050_I2C_TIMEOUT_US.
+    bool readMPU6050Burst(uint8_t reg, uint8_t *buffer, uint8_t length);
+
+    // Converts one 14-byte sample (burst or FIFO layout) into engineering units
+    void loadSample(const uint8_t *buffer, unsigned long timestampUs);
+
+    // Fills _features from the current accel/gyro values
+    void computeFeatures();
+
+#if AEMO_ORIENTATION_FILTER
+    // Advances the orientation quaternion by one sample using _dt
+    void updateOrientation();
+#endif
+
+    // Clears the hardware FIFO and re-enables it
+    void resetFifo();
+
+    // Reads a big-endian word from 'buffer' and removes the calibration bias
+    static int16_t decodeAxis(const uint8_t *buffer, int16_t bias);
 };
 
 #endif // AEMO_MOTION_H
 
 // --- Implementation of AemoMotion Class ---
 
+#if AEMO_FIXED_POINT
+// Converts a threshold in engineering units to a squared LSB value, saturating
+// instead of overflowing for thresholds beyond the sensor's full-scale range.
+static uint32_t aemoSquaredLsb(float value, float lsbPerUnit) {
+    float lsb = value * lsbPerUnit;
+    float squared = lsb * lsb;
+    return squared >= 4294967295.0f ? 0xFFFFFFFFUL : (uint32_t)squared;
+}
+
+// Integer square root (bit-by-bit), exact floor(sqrt(value))
+static uint32_t aemoIsqrt(uint32_t value) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > value) bit >>= 2;
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+#endif
+
 AemoMotion::AemoMotion() {
     _lastUpdateTime = micros(); // Initialize last update time
+#if AEMO_FIXED_POINT
+    // Default thresholds in LSB^2 for the configured accel range
+    setShakeThreshold(_shakeThreshold);
+    setFreefallThreshold(_freefallAccelThreshold, _freefallDurationThreshold);
+#endif
 }
 
 // Initializes the MPU-6050 sensor
@@ -201,14 +580,12 @@ bool AemoMotion::begin() {
     delay(100); // Give sensor time to wake up
 
     // Configure Accelerometer (ACCEL_CONFIG register)
-    // Set to +/- 2g (0x00). Can be 0x08 (+/-4g), 0x10 (+/-8g), 0x18 (+/-16g)
-    // The ACCEL_SCALE_FACTOR above must be adjusted if this value changes.
-    writeMPU6050Register(MPU6050_ACCEL_CONFIG, 0x00);
+    // Range comes from AEMO_ACCEL_RANGE (default +/- 2g), the same setting the conversions use.
+    writeMPU6050Register(MPU6050_ACCEL_CONFIG, AemoActiveScale::accelConfig);
 
     // Configure Gyroscope (GYRO_CONFIG register)
-    // Set to +/- 250 deg/s (0x00). Can be 0x08 (+/-500), 0x10 (+/-1000), 0x18 (+/-2000)
-    // The GYRO_SCALE_FACTOR above must be adjusted if this value changes.
-    writeMPU6050Register(MPU6050_GYRO_CONFIG, 0x00);
+    // Range comes from AEMO_GYRO_RANGE (default +/- 250 deg/s).
+    writeMPU6050Register(MPU6050_GYRO_CONFIG, AemoActiveScale::gyroConfig);
 
     // Set Sample Rate Divider (SMPLRT_DIV register)
     // Sample Rate = Gyroscope Output Rate / (1 + SMPLRT_DIV)
@@ -222,52 +599,117 @@ bool AemoMotion::begin() {
 
     // Perform an initial read to populate values
     update();
-    _prevAccelMagnitude = sqrt(pow(_accelX, 2) + pow(_accelY, 2) + pow(_accelZ, 2));
+    _prevAccelMagnitude = _features.accelMagnitude;
 
     return true;
 }
 
 // Updates sensor data. Call this frequently in your loop().
-void AemoMotion::update() {
-    unsigned long currentTime = micros();
-    _dt = (currentTime - _lastUpdateTime) / 1000000.0; // Convert microseconds to seconds
-    _lastUpdateTime = currentTime;
+bool AemoMotion::update() {
+    // Read accel, temperature and gyro registers in a single burst
+    uint8_t buffer[MPU6050_SAMPLE_BYTES];
+    if (!readMPU6050Burst(MPU6050_ACCEL_XOUT_H, buffer, MPU6050_SAMPLE_BYTES)) {
+        _i2cErrorCount++;
+        return false; // Keep the last good sample
+    }
 
-    // Read raw 16-bit sensor data
-    int16_t rawAccelX = readMPU6050Word(MPU6050_ACCEL_XOUT_H);
-    int16_t rawAccelY = readMPU6050Word(MPU6050_ACCEL_YOUT_H);
-    int16_t rawAccelZ = readMPU6050Word(MPU6050_ACCEL_ZOUT_H);
+    loadSample(buffer, micros());
+    return true;
+}
 
-    int16_t rawGyroX = readMPU6050Word(MPU6050_GYRO_XOUT_H);
-    int16_t rawGyroY = readMPU6050Word(MPU6050_GYRO_YOUT_H);
-    int16_t rawGyroZ = readMPU6050Word(MPU6050_GYRO_ZOUT_H);
+// Converts one 14-byte sample into engineering units and advances the sample clock
+void AemoMotion::loadSample(const uint8_t *buffer, unsigned long timestampUs) {
+    _dt = (timestampUs - _lastUpdateTime) / 1000000.0; // Convert microseconds to seconds
+    _lastUpdateTime = timestampUs;
+    _sampleTimeUs = timestampUs;
 
-    int16_t rawTemp = readMPU6050Word(MPU6050_TEMP_OUT_H);
+    // Combine big-endian byte pairs into signed 16-bit values, minus calibration bias
+    _rawAccelX = decodeAxis(&buffer[0], _calibration.accelBias[0]);
+    _rawAccelY = decodeAxis(&buffer[2], _calibration.accelBias[1]);
+    _rawAccelZ = decodeAxis(&buffer[4], _calibration.accelBias[2]);
 
-    // Convert raw data to engineering units (g and deg/s)
-    _accelX = (float)rawAccelX / ACCEL_SCALE_FACTOR;
-    _accelY = (float)rawAccelY / ACCEL_SCALE_FACTOR;
-    _accelZ = (float)rawAccelZ / ACCEL_SCALE_FACTOR;
+    _rawTemp = (int16_t)((buffer[6] << 8) | buffer[7]);
 
-    _gyroX = (float)rawGyroX / GYRO_SCALE_FACTOR;
-    _gyroY = (float)rawGyroY / GYRO_SCALE_FACTOR;
-    _gyroZ = (float)rawGyroZ / GYRO_SCALE_FACTOR;
+    _rawGyroX = decodeAxis(&buffer[8], _calibration.gyroBias[0]);
+    _rawGyroY = decodeAxis(&buffer[10], _calibration.gyroBias[1]);
+    _rawGyroZ = decodeAxis(&buffer[12], _calibration.gyroBias[2]);
 
-    // Temperature in Celsius = (raw_temp / 340) + 36.53
-    _temperature = (float)rawTemp / 340.0 + 36.53;
+    computeFeatures();
+#if AEMO_ORIENTATION_FILTER
+    updateOrientation();
+#endif
+}
+
+// Removing the bias can push a reading past the int16 range; saturate instead of wrapping
+int16_t AemoMotion::decodeAxis(const uint8_t *buffer, int16_t bias) {
+    int32_t value = (int32_t)(int16_t)((buffer[0] << 8) | buffer[1]) - bias;
+    if (value > 32767) value = 32767;
+    if (value < -32768) value = -32768;
+    return (int16_t)value;
+}
+
+#if AEMO_FIXED_POINT
+// Computes everything the detectors need in one pass, integer-only.
+// Each squared term is at most 2^30, so three of them fit in 32 unsigned bits.
+void AemoMotion::computeFeatures() {
+    int32_t ax = _rawAccelX, ay = _rawAccelY, az = _rawAccelZ;
+    int32_t gx = _rawGyroX, gy = _rawGyroY, gz = _rawGyroZ;
+
+    _features.accelMagnitudeSq = (uint32_t)(ax * ax) + (uint32_t)(ay * ay) + (uint32_t)(az * az);
+    _features.accelMagnitude = aemoIsqrt(_features.accelMagnitudeSq);
+    _features.gyroMagnitudeSq = (uint32_t)(gx * gx) + (uint32_t)(gy * gy) + (uint32_t)(gz * gz);
+}
+
+// Roll and pitch are not needed by the integer detectors, so they are only computed on request.
+// The accel scale cancels out of atan2, so raw LSB values can be used directly.
+float AemoMotion::getRoll() {
+    return atan2f((float)_rawAccelY, (float)_rawAccelZ) * AEMO_RAD_TO_DEG;
+}
+
+float AemoMotion::getPitch() {
+    float ay = _rawAccelY, az = _rawAccelZ;
+    return atan2f(-(float)_rawAccelX, sqrtf(ay * ay + az * az)) * AEMO_RAD_TO_DEG;
+}
+#else
+// Computes everything the detectors need in one pass, in single precision
+void AemoMotion::computeFeatures() {
+    // Convert raw data to engineering units (g and deg/s)
+    _accelX = _rawAccelX * AemoActiveScale::gPerLsb;
+    _accelY = _rawAccelY * AemoActiveScale::gPerLsb;
+    _accelZ = _rawAccelZ * AemoActiveScale::gPerLsb;
+
+    _gyroX = _rawGyroX * AemoActiveScale::dpsPerLsb;
+    _gyroY = _rawGyroY * AemoActiveScale::dpsPerLsb;
+    _gyroZ = _rawGyroZ * AemoActiveScale::dpsPerLsb;
+
+    float ax2 = _accelX * _accelX;
+    float yz2 = _accelY * _accelY + _accelZ * _accelZ;
+
+    _features.accelMagnitudeSq = ax2 + yz2;
+    _features.accelMagnitude = sqrtf(_features.accelMagnitudeSq);
+    _features.gyroMagnitudeSq = _gyroX * _gyroX + _gyroY * _gyroY + _gyroZ * _gyroZ;
+
+    // Roll: atan2(Y_accel, Z_accel) when X is forward/back, Y is left/right, Z is up/down.
+    // Pitch: atan2(-X_accel, sqrt(Y_accel^2 + Z_accel^2)); negative X because positive X is forward.
+    // Both assume the Z-axis points down when level.
+    _features.roll = atan2f(_accelY, _accelZ) * AEMO_RAD_TO_DEG;
+    _features.pitch = atan2f(-_accelX, sqrtf(yz2)) * AEMO_RAD_TO_DEG;
 }
 
+float AemoMotion::getRoll() { return _features.roll; }
+float AemoMotion::getPitch() { return _features.pitch; }
+#endif
+
 // --- Motion Feature Detection Implementations ---
 
 // detectShake(): Detects a sudden, high-magnitude acceleration.
 bool AemoMotion::detectShake() {
-    float accelMagnitude = sqrt(pow(_accelX, 2) + pow(_accelY, 2) + pow(_accelZ, 2));
-    unsigned long currentMillis = millis();
+    unsigned long currentMicros = _sampleTimeUs; // Time of the sample, not of this call
 
     // Check if the current acceleration magnitude exceeds the threshold
     // and if enough time has passed since the last shake detection (cooldown)
-    if (accelMagnitude > _shakeThreshold && (currentMillis - _lastShakeTriggerTime > _shakeCooldownMs)) {
-        _lastShakeTriggerTime = currentMillis; // Update the last trigger time
+    if (_features.accelMagnitudeSq > _shakeThresholdSq && (currentMicros - _lastShakeTriggerTime > _shakeCooldownMs * 1000UL)) {
+        _lastShakeTriggerTime = currentMicros; // Update the last trigger time
         return true; // Shake detected!
     }
     return false;
@@ -276,19 +718,21 @@ bool AemoMotion::detectShake() {
 // getDominantAxis(): Determines the primary axis affected by gravity.
 char AemoMotion::getDominantAxis() {
     // We expect one axis to be close to +/- 1g when stationary
-    // and the other two close to 0g.
-    float absX = fabs(_accelX);
-    float absY = fabs(_accelY);
-    float absZ = fabs(_accelZ);
+    // and the other two close to 0g. Compared in raw LSB, so this works in both builds.
+    int32_t absX = abs((int32_t)_rawAccelX);
+    int32_t absY = abs((int32_t)_rawAccelY);
+    int32_t absZ = abs((int32_t)_rawAccelZ);
 
-    float tolerance = 0.2; // Tolerance for 'g' values
+    // Tolerance of 0.2 g around 1 g and 0 g, in LSB for the configured range
+    const int32_t oneG = AemoActiveScale::accelLsbPerG;
+    const int32_t tolerance = AemoActiveScale::accelLsbPerG / 5;
 
     // Check if any axis is significantly dominant (close to 1g)
-    if (absX > (1.0 - tolerance) && absX < (1.0 + tolerance) && absY < tolerance && absZ < tolerance) {
+    if (absX > (oneG - tolerance) && absX < (oneG + tolerance) && absY < tolerance && absZ < tolerance) {
         return 'X';
-    } else if (absY > (1.0 - tolerance) && absY < (1.0 + tolerance) && absX < tolerance && absZ < tolerance) {
+    } else if (absY > (oneG - tolerance) && absY < (oneG + tolerance) && absX < tolerance && absZ < tolerance) {
         return 'Y';
-    } else if (absZ > (1.0 - tolerance) && absZ < (1.0 + tolerance) && absX < tolerance && absY < tolerance) {
+    } else if (absZ > (oneG - tolerance) && absZ < (oneG + tolerance) && absX < tolerance && absY < tolerance) {
         return 'Z';
     }
     // If no single axis is clearly dominant, or if all are near zero (freefall)
@@ -298,17 +742,16 @@ char AemoMotion::getDominantAxis() {
 
 // isFreefalling(): Detects if the robot is in freefall (near 0g acceleration).
 bool AemoMotion::isFreefalling() {
-    float accelMagnitude = sqrt(pow(_accelX, 2) + pow(_accelY, 2) + pow(_accelZ, 2));
-    unsigned long currentMillis = millis();
+    unsigned long currentMicros = _sampleTimeUs;
 
-    if (accelMagnitude < _freefallAccelThreshold) {
+    if (_features.accelMagnitudeSq < _freefallAccelThresholdSq) {
         // If below threshold, check if this is the start of a new freefall event
         if (!_isCurrentlyFreefalling) {
-            _freefallStartTime = currentMillis; // Record start time
+            _freefallStartTime = currentMicros; // Record start time
             _isCurrentlyFreefalling = true;
         } else {
             // If already freefalling, check if duration threshold is met
-            if (currentMillis - _freefallStartTime > _freefallDurationThreshold) {
+            if (currentMicros - _freefallStartTime > _freefallDurationThreshold * 1000UL) {
                 return true; // Freefall detected for long enough!
             }
         }
@@ -322,45 +765,155 @@ bool AemoMotion::isFreefalling() {
 
 // isTilted(): Checks if the robot is tilted beyond a specified angular threshold.
 bool AemoMotion::isTilted(float thresholdDegrees) {
-    float roll = getRoll();
-    float pitch = getPitch();
+#if AEMO_FIXED_POINT
+    if (thresholdDegrees >= 89.0f) {
+        // Tangent test below only holds for thresholds under 90 degrees, and tan^2 in Q16
+        // no longer fits 32 bits from about 89.78 degrees on
+        return fabsf(getRoll()) > thresholdDegrees || fabsf(getPitch()) > thresholdDegrees;
+    }
+    if (thresholdDegrees != _tiltThresholdCacheDeg) {
+        float t = tanf(thresholdDegrees / AEMO_RAD_TO_DEG);
+        _tiltTanSqQ16 = (uint32_t)(t * t * 65536.0f);
+        _tiltThresholdCacheDeg = thresholdDegrees;
+    }
 
+    // Without atan2:
+    //   |roll| > T   <=>  az < 0  or  ay^2 > tan^2(T) * az^2
+    //   |pitch| > T  <=>  ax^2 > tan^2(T) * (ay^2 + az^2)
+    // With az == 0 the roll is 90 degrees unless ay is 0 too, where atan2(0, 0) gives 0
+    int32_t ax = _rawAccelX, ay = _rawAccelY, az = _rawAccelZ;
+    uint64_t ax2 = (uint64_t)(ax * ax) << 16;
+    uint64_t ay2 = (uint32_t)(ay * ay);
+    uint64_t az2 = (uint32_t)(az * az);
+    if (az < 0 || (az == 0 && ay != 0) || (ay2 << 16) > _tiltTanSqQ16 * az2) {
+        return true;
+    }
+    return ax2 > _tiltTanSqQ16 * (ay2 + az2);
+#else
     // Check if absolute roll or pitch exceeds the threshold
-    if (fabs(roll) > thresholdDegrees || fabs(pitch) > thresholdDegrees) {
+    if (fabsf(_features.roll) > thresholdDegrees || fabsf(_features.pitch) > thresholdDegrees) {
         return true;
     }
     return false;
+#endif
 }
 
-// getRoll(): Calculates the roll angle (rotation around X-axis) in degrees.
-// Uses accelerometer data. Assumes Z-axis points down when level.
-float AemoMotion::getRoll() {
-    // atan2(Y_accel, Z_accel) when X is forward/back, Y is left/right, Z is up/down
-    // This formula calculates roll around the X-axis.
-    return atan2(_accelY, _accelZ) * 180.0 / M_PI;
+#if AEMO_ORIENTATION_FILTER
+// --- Orientation Filter ---
+
+// Madgwick IMU update: integrates the gyro rate and applies one gradient-descent
+// step towards the orientation in which gravity matches the measured acceleration.
+void AemoMotion::updateOrientation() {
+    // The accel scale cancels out after normalisation, so raw LSB are used directly
+    float ax = _rawAccelX, ay = _rawAccelY, az = _rawAccelZ;
+    float accelNormSq = ax * ax + ay * ay + az * az;
+
+    if (!_orientationSeeded || _dt <= 0.0f || _dt > AEMO_ORIENTATION_MAX_DT) {
+        // Start from the accelerometer attitude (yaw 0) instead of waiting for the filter to converge
+        if (accelNormSq == 0.0f) {
+            return;
+        }
+        float halfRoll = 0.5f * atan2f(ay, az);
+        float halfPitch = 0.5f * atan2f(-ax, sqrtf(ay * ay + az * az));
+        float cr = cosf(halfRoll), sr = sinf(halfRoll);
+        float cp = cosf(halfPitch), sp = sinf(halfPitch);
+        _q0 = cr * cp;
+        _q1 = sr * cp;
+        _q2 = cr * sp;
+        _q3 = -sr * sp;
+        _orientationSeeded = true;
+        return;
+    }
+
+    float gx = _rawGyroX * AemoActiveScale::radPerSecPerLsb;
+    float gy = _rawGyroY * AemoActiveScale::radPerSecPerLsb;
+    float gz = _rawGyroZ * AemoActiveScale::radPerSecPerLsb;
+    float q0 = _q0, q1 = _q1, q2 = _q2, q3 = _q3;
+
+    // Rate of change of the quaternion from the gyroscope
+    float qDot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    // Accelerometer correction (skipped if the reading is all zero, e.g. a failed read)
+    if (accelNormSq > 0.0f) {
+        float recipNorm = 1.0f / sqrtf(accelNormSq);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+        float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+        float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+        // Gradient of the objective function (orientation error vs. gravity)
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        float gradNormSq = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (gradNormSq > 0.0f) {
+            float betaNorm = _beta / sqrtf(gradNormSq);
+            qDot0 -= betaNorm * s0;
+            qDot1 -= betaNorm * s1;
+            qDot2 -= betaNorm * s2;
+            qDot3 -= betaNorm * s3;
+        }
+    }
+
+    // Integrate and renormalise
+    q0 += qDot0 * _dt;
+    q1 += qDot1 * _dt;
+    q2 += qDot2 * _dt;
+    q3 += qDot3 * _dt;
+    float recipNorm = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    _q0 = q0 * recipNorm;
+    _q1 = q1 * recipNorm;
+    _q2 = q2 * recipNorm;
+    _q3 = q3 * recipNorm;
 }
 
-// getPitch(): Calculates the pitch angle (rotation around Y-axis) in degrees.
-// Uses accelerometer data. Assumes Z-axis points down when level.
-float AemoMotion::getPitch() {
-    // atan2(-X_accel, sqrt(Y_accel^2 + Z_accel^2)) for pitch around Y-axis
-    // The negative X is typical for IMUs where positive X is forward.
-    return atan2(-_accelX, sqrt(pow(_accelY, 2) + pow(_accelZ, 2))) * 180.0 / M_PI;
+// Euler angles are only derived from the quaternion when asked for
+float AemoMotion::getFusedRoll() {
+    return atan2f(_q0 * _q1 + _q2 * _q3, 0.5f - _q1 * _q1 - _q2 * _q2) * AEMO_RAD_TO_DEG;
+}
+
+float AemoMotion::getFusedPitch() {
+    float sinPitch = -2.0f * (_q1 * _q3 - _q0 * _q2);
+    if (sinPitch > 1.0f) sinPitch = 1.0f; // Guard against rounding just outside asin's domain
+    if (sinPitch < -1.0f) sinPitch = -1.0f;
+    return asinf(sinPitch) * AEMO_RAD_TO_DEG;
+}
+
+float AemoMotion::getFusedYaw() {
+    return atan2f(_q1 * _q2 + _q0 * _q3, 0.5f - _q2 * _q2 - _q3 * _q3) * AEMO_RAD_TO_DEG;
 }
+#endif
 
 // isSpinning(): Detects if the robot is rotating rapidly and continuously.
 bool AemoMotion::isSpinning(float gyroThresholdDPS, unsigned long durationMs) {
-    float totalGyroMagnitude = sqrt(pow(_gyroX, 2) + pow(_gyroY, 2) + pow(_gyroZ, 2));
-    unsigned long currentMillis = millis();
+    unsigned long currentMicros = _sampleTimeUs;
 
-    if (totalGyroMagnitude > gyroThresholdDPS) {
+    // Compare squared magnitudes to avoid a sqrt per call
+#if AEMO_FIXED_POINT
+    if (gyroThresholdDPS != _spinThresholdCacheDPS) {
+        _spinThresholdCacheSq = aemoSquaredLsb(gyroThresholdDPS, AemoActiveScale::gyroLsbPerDps);
+        _spinThresholdCacheDPS = gyroThresholdDPS;
+    }
+    if (_features.gyroMagnitudeSq > _spinThresholdCacheSq) {
+#else
+    if (_features.gyroMagnitudeSq > gyroThresholdDPS * gyroThresholdDPS) {
+#endif
         // If angular velocity is above threshold, check if this is the start of a new spinning event
         if (!_isCurrentlySpinning) {
-            _spinningStartTime = currentMillis; // Record start time
+            _spinningStartTime = currentMicros; // Record start time
             _isCurrentlySpinning = true;
         } else {
             // If already spinning, check if duration threshold is met
-            if (currentMillis - _spinningStartTime > durationMs) {
+            if (currentMicros - _spinningStartTime > durationMs * 1000UL) {
                 return true; // Spinning detected for long enough!
             }
         }
@@ -374,19 +927,33 @@ bool AemoMotion::isSpinning(float gyroThresholdDPS, unsigned long durationMs) {
 
 // isJerk(): Detects a sudden, sharp change in acceleration.
 bool AemoMotion::isJerk(float accelDeltaThreshold, unsigned long durationMs) {
-    float currentAccelMagnitude = sqrt(pow(_accelX, 2) + pow(_accelY, 2) + pow(_accelZ, 2));
-    unsigned long currentMillis = millis();
+    unsigned long currentMicros = _sampleTimeUs;
+
+#if AEMO_FIXED_POINT
+    if (accelDeltaThreshold != _jerkThresholdCacheG) {
+        _jerkThresholdCacheLsb = (uint32_t)(accelDeltaThreshold * AemoActiveScale::accelLsbPerG);
+        _jerkThresholdCacheG = accelDeltaThreshold;
+    }
+    uint32_t currentAccelMagnitude = _features.accelMagnitude;
+    uint32_t deltaAccel = currentAccelMagnitude > _prevAccelMagnitude
+                              ? currentAccelMagnitude - _prevAccelMagnitude
+                              : _prevAccelMagnitude - currentAccelMagnitude;
+    uint32_t threshold = _jerkThresholdCacheLsb;
+#else
+    float currentAccelMagnitude = _features.accelMagnitude;
 
     // Calculate the absolute change in acceleration magnitude
-    float deltaAccel = fabs(currentAccelMagnitude - _prevAccelMagnitude);
+    float deltaAccel = fabsf(currentAccelMagnitude - _prevAccelMagnitude);
+    float threshold = accelDeltaThreshold;
+#endif
 
     // Update previous acceleration magnitude for the next iteration
     _prevAccelMagnitude = currentAccelMagnitude;
 
     // Check if the change in acceleration exceeds the threshold
     // and if enough time has passed since the last jerk detection (cooldown)
-    if (deltaAccel > accelDeltaThreshold && (currentMillis - _lastJerkTriggerTime > _jerkCooldownMs)) {
-        _lastJerkTriggerTime = currentMillis; // Update the last trigger time
+    if (deltaAccel > threshold && (currentMicros - _lastJerkTriggerTime > _jerkCooldownMs * 1000UL)) {
+        _lastJerkTriggerTime = currentMicros; // Update the last trigger time
         return true; // Jerk detected!
     }
     return false;
@@ -396,10 +963,20 @@ bool AemoMotion::isJerk(float accelDeltaThreshold, unsigned long durationMs) {
 
 void AemoMotion::setShakeThreshold(float thresholdG) {
     _shakeThreshold = thresholdG;
+#if AEMO_FIXED_POINT
+    _shakeThresholdSq = aemoSquaredLsb(thresholdG, AemoActiveScale::accelLsbPerG);
+#else
+    _shakeThresholdSq = thresholdG * thresholdG;
+#endif
 }
 
 void AemoMotion::setFreefallThreshold(float accelThresholdG, unsigned long durationMs) {
     _freefallAccelThreshold = accelThresholdG;
+#if AEMO_FIXED_POINT
+    _freefallAccelThresholdSq = aemoSquaredLsb(accelThresholdG, AemoActiveScale::accelLsbPerG);
+#else
+    _freefallAccelThresholdSq = accelThresholdG * accelThresholdG;
+#endif
     _freefallDurationThreshold = durationMs;
 }
 
@@ -415,16 +992,345 @@ void AemoMotion::setJerkThreshold(float accelDeltaThresholdG, unsigned long dura
     // For this simple implementation, the cooldown is more impactful.
 }
 
+// --- FIFO + Interrupt Acquisition Mode ---
+
+// The data-ready ISR needs a plain function; it forwards to the instance that called beginFifo().
+static AemoMotion *_aemoFifoInstance = NULL;
+
+static void IRAM_ATTR aemoDataReadyISR() {
+    if (_aemoFifoInstance) {
+        _aemoFifoInstance->handleDataReady();
+    }
+}
+
+// Runs in interrupt context: only timestamps the sample and optionally wakes the consumer task.
+void IRAM_ATTR AemoMotion::handleDataReady() {
+#if defined(ESP32)
+    portENTER_CRITICAL_ISR(&_dataReadyMux); // serviceFifo() may read both from the other core
+    _lastDataReadyUs = micros();
+    unsigned long count = ++_dataReadyCount;
+    portEXIT_CRITICAL_ISR(&_dataReadyMux);
+    if (_notifyTask != NULL && (count % _batchSize) == 0) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(_notifyTask, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+#else
+    _lastDataReadyUs = micros();
+    _dataReadyCount++;
+#endif
+}
+
+bool AemoMotion::beginFifo(int interruptPin, uint8_t batchSize) {
+    int interruptNumber = digitalPinToInterrupt(interruptPin);
+    if (interruptNumber < 0) {
+        return false;
+    }
+    _batchSize = batchSize > 0 ? batchSize : 1;
+
+    // Sample period from the current divider: 1 kHz gyro output rate with DLPF enabled
+    _samplePeriodUs = 1000UL * (1 + readMPU6050Register(MPU6050_SMPLRT_DIV));
+
+    // INT pin: active high, push-pull, 50 us pulse, cleared automatically
+    writeMPU6050Register(MPU6050_INT_PIN_CFG, 0x00);
+    writeMPU6050Register(MPU6050_FIFO_EN, MPU6050_FIFO_EN_TEMP_GYRO_ACCEL);
+    resetFifo();
+
+    _ringHead = _ringTail = 0;
+    _dataReadyServiced = _dataReadyCount;
+    _fifoMode = true;
+
+    _aemoFifoInstance = this;
+    pinMode(interruptPin, INPUT);
+    attachInterrupt(interruptNumber, aemoDataReadyISR, RISING);
+    writeMPU6050Register(MPU6050_INT_ENABLE, MPU6050_INT_DATA_RDY | MPU6050_INT_FIFO_OFLOW);
+    return true;
+}
+
+// Drains complete samples from the hardware FIFO into the ring buffer.
+// Per-sample timestamps are reconstructed backwards from the most recent data-ready
+// interrupt, one sample period apart; the newest sample in the FIFO is the one that
+// raised that interrupt.
+uint8_t AemoMotion::serviceFifo() {
+    if (!_fifoMode) {
+        return 0;
+    }
+
+    // INT_STATUS is cleared on read; an overflow means the FIFO contents are misaligned
+    if (readMPU6050Register(MPU6050_INT_STATUS) & MPU6050_INT_FIFO_OFLOW) {
+        _fifoOverflowCount++;
+        resetFifo();
+        _dataReadyServiced = _dataReadyCount;
+        return 0;
+    }
+
+    uint8_t countBytes[2];
+    if (!readMPU6050Burst(MPU6050_FIFO_COUNTH, countBytes, 2)) {
+        _i2cErrorCount++;
+        return 0;
+    }
+    uint16_t fifoCount = ((uint16_t)countBytes[0] << 8) | countBytes[1];
+    uint16_t fifoSamples = fifoCount / MPU6050_SAMPLE_BYTES;
+
+    // Anchor right after FIFO_COUNT, time and count as one pair. Before the I2C transaction, a
+    // data-ready during it would count a sample newer than the anchor and put every timestamp
+    // of the batch one period early; now the window is a few instructions wide.
+#if defined(ESP32)
+    portENTER_CRITICAL(&_dataReadyMux);
+#else
+    noInterrupts();
+#endif
+    unsigned long anchorUs = _lastDataReadyUs;
+    unsigned long anchorCount = _dataReadyCount;
+#if defined(ESP32)
+    portEXIT_CRITICAL(&_dataReadyMux);
+#else
+    interrupts();
+#endif
+
+    // Leave whatever does not fit in the ring in the hardware FIFO for the next call
+    uint8_t ringFree = AEMO_SAMPLE_RING_SIZE - samplesAvailable();
+    uint8_t toRead = fifoSamples < ringFree ? (uint8_t)fifoSamples : ringFree;
+
+    uint8_t burst[AEMO_FIFO_BURST_SAMPLES * MPU6050_SAMPLE_BYTES];
+    uint8_t moved = 0;
+    while (moved < toRead) {
+        uint8_t chunk = toRead - moved;
+        if (chunk > AEMO_FIFO_BURST_SAMPLES) chunk = AEMO_FIFO_BURST_SAMPLES;
+        if (!readMPU6050Burst(MPU6050_FIFO_R_W, burst, chunk * MPU6050_SAMPLE_BYTES)) {
+            // A partial FIFO read leaves the stream misaligned
+            _i2cErrorCount++;
+            resetFifo();
+            break;
+        }
+        for (uint8_t i = 0; i < chunk; i++) {
+            RawSample &slot = _ring[_ringHead & (AEMO_SAMPLE_RING_SIZE - 1)];
+            // Samples still left in the FIFO after this one are all newer
+            uint16_t newerSamples = fifoSamples - 1 - (moved + i);
+            slot.timestampUs = anchorUs - newerSamples * _samplePeriodUs;
+            memcpy(slot.data, &burst[i * MPU6050_SAMPLE_BYTES], MPU6050_SAMPLE_BYTES);
+            _ringHead++;
+        }
+        moved += chunk;
+    }
+
+    _dataReadyServiced = anchorCount;
+    return moved;
+}
+
+bool AemoMotion::nextSample() {
+    if (_ringHead == _ringTail) {
+        return false;
+    }
+    const RawSample &slot = _ring[_ringTail & (AEMO_SAMPLE_RING_SIZE - 1)];
+    loadSample(slot.data, slot.timestampUs);
+    _ringTail++;
+    return true;
+}
+
+void AemoMotion::resetFifo() {
+    writeMPU6050Register(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+    writeMPU6050Register(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
+}
+
+// --- Bias Calibration ---
+
+bool AemoMotion::beginCalibrated(uint16_t sampleCount) {
+    if (!begin()) {
+        return false;
+    }
+    // Fast path: offsets from a previous boot
+    if (!loadCalibration()) {
+        if (calibrate(sampleCount)) {
+            saveCalibration();
+        } else {
+            Serial.println("AemoMotion: calibration skipped, sensor was moving");
+        }
+    }
+    // Refresh the current sample and jerk baseline with the offsets applied
+    update();
+    _prevAccelMagnitude = _features.accelMagnitude;
+#if AEMO_ORIENTATION_FILTER
+    resetOrientation();
+#endif
+    return true;
+}
+
+bool AemoMotion::calibrate(uint16_t sampleCount, bool includeAccel) {
+    if (sampleCount == 0) {
+        return false;
+    }
+    uint8_t savedDivider = readMPU6050Register(MPU6050_SMPLRT_DIV);
+    uint8_t savedInterrupts = readMPU6050Register(MPU6050_INT_ENABLE);
+
+    // Sample through the FIFO so no sample is missed, at a rate the bus can keep up with
+    const unsigned long periodMs = 1 + AEMO_CALIBRATION_DIVIDER;
+    writeMPU6050Register(MPU6050_SMPLRT_DIV, AEMO_CALIBRATION_DIVIDER);
+    writeMPU6050Register(MPU6050_FIFO_EN, MPU6050_FIFO_EN_TEMP_GYRO_ACCEL);
+    // FIFO_OFLOW only latches in INT_STATUS while it is enabled
+    writeMPU6050Register(MPU6050_INT_ENABLE, savedInterrupts | MPU6050_INT_FIFO_OFLOW);
+    resetFifo();
+    readMPU6050Register(MPU6050_INT_STATUS); // clear anything latched before the reset
+
+    int32_t sum[6] = {0, 0, 0, 0, 0, 0};  // accel X/Y/Z, gyro X/Y/Z
+    int64_t sumSq[3] = {0, 0, 0};         // gyro X/Y/Z, for the stationarity check
+    uint16_t collected = 0;
+    uint8_t restarts = 0;
+    bool ok = true;
+    uint8_t burst[AEMO_FIFO_BURST_SAMPLES * MPU6050_SAMPLE_BYTES];
+    unsigned long deadline = millis() + 2UL * periodMs * sampleCount + 100; // 2x the nominal time
+
+    while (collected < sampleCount) {
+        if ((long)(millis() - deadline) > 0) {
+            ok = false; // Sensor stopped producing samples
+            break;
+        }
+        uint8_t countBytes[2];
+        if (!readMPU6050Burst(MPU6050_FIFO_COUNTH, countBytes, 2)) {
+            ok = false;
+            break;
+        }
+        uint16_t fifoCount = ((uint16_t)countBytes[0] << 8) | countBytes[1];
+        // An overflow drops bytes mid-sample: everything after it is misaligned, and samples
+        // already summed may be byte-shifted too. Start over from an empty FIFO.
+        if ((readMPU6050Register(MPU6050_INT_STATUS) & MPU6050_INT_FIFO_OFLOW) || fifoCount >= MPU6050_FIFO_SIZE) {
+            _fifoOverflowCount++;
+            if (++restarts > AEMO_CALIBRATION_MAX_RESTARTS) {
+                ok = false;
+                break;
+            }
+            resetFifo();
+            memset(sum, 0, sizeof(sum));
+            memset(sumSq, 0, sizeof(sumSq));
+            collected = 0;
+            deadline = millis() + 2UL * periodMs * sampleCount + 100;
+            continue;
+        }
+        uint16_t available = fifoCount / MPU6050_SAMPLE_BYTES;
+        if (available == 0) {
+            continue;
+        }
+        uint8_t chunk = available > AEMO_FIFO_BURST_SAMPLES ? AEMO_FIFO_BURST_SAMPLES : (uint8_t)available;
+        if (!readMPU6050Burst(MPU6050_FIFO_R_W, burst, chunk * MPU6050_SAMPLE_BYTES)) {
+            ok = false;
+            break;
+        }
+        for (uint8_t i = 0; i < chunk && collected < sampleCount; i++) {
+            const uint8_t *sample = &burst[i * MPU6050_SAMPLE_BYTES];
+            for (uint8_t axis = 0; axis < 3; axis++) {
+                int32_t accel = (int16_t)((sample[axis * 2] << 8) | sample[axis * 2 + 1]);
+                int32_t gyro = (int16_t)((sample[8 + axis * 2] << 8) | sample[9 + axis * 2]);
+                sum[axis] += accel;
+                sum[3 + axis] += gyro;
+                sumSq[axis] += (int64_t)gyro * gyro;
+            }
+            collected++;
+        }
+    }
+
+    // Restore the normal sample rate, interrupts and FIFO configuration
+    writeMPU6050Register(MPU6050_SMPLRT_DIV, savedDivider);
+    writeMPU6050Register(MPU6050_INT_ENABLE, savedInterrupts);
+    if (_fifoMode) {
+        resetFifo();
+        _ringHead = _ringTail = 0;
+        _dataReadyServiced = _dataReadyCount;
+    } else {
+        writeMPU6050Register(MPU6050_FIFO_EN, 0x00);
+        writeMPU6050Register(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    // Reject the run if the gyro was not steady: variance = E[x^2] - E[x]^2
+    const float maxStdDevLsb = AEMO_CALIBRATION_MAX_GYRO_STDDEV * AemoActiveScale::gyroLsbPerDps;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        float mean = (float)sum[3 + axis] / sampleCount;
+        float variance = (float)sumSq[axis] / sampleCount - mean * mean;
+        if (variance > maxStdDevLsb * maxStdDevLsb) {
+            return false;
+        }
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        // Rounded means; the calibration is applied to raw readings, which already include the bias
+        _calibration.gyroBias[axis] = (int16_t)lroundf((float)sum[3 + axis] / sampleCount);
+        if (includeAccel) {
+            int32_t expected = axis == 2 ? AemoActiveScale::accelLsbPerG : 0; // Gravity on Z when level
+            _calibration.accelBias[axis] = (int16_t)(lroundf((float)sum[axis] / sampleCount) - expected);
+        }
+    }
+    return true;
+}
+
+#if defined(ESP32)
+// Tag stored next to the offsets: they are in LSB, so they only apply to the same ranges
+static uint16_t aemoCalibrationTag() {
+    return ((uint16_t)AemoActiveScale::gyroConfig << 8) | AemoActiveScale::accelConfig;
+}
+
+struct AemoStoredCalibration {
+    uint16_t tag;
+    AemoCalibration calibration;
+};
+#endif
+
+bool AemoMotion::saveCalibration() {
+#if defined(ESP32)
+    AemoStoredCalibration stored = {aemoCalibrationTag(), _calibration};
+    Preferences prefs;
+    if (!prefs.begin(AEMO_CALIBRATION_NVS_NAMESPACE, false)) {
+        return false;
+    }
+    bool ok = prefs.putBytes(AEMO_CALIBRATION_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored);
+    prefs.end();
+    return ok;
+#else
+    return false; // No persistent storage on this platform
+#endif
+}
+
+bool AemoMotion::loadCalibration() {
+#if defined(ESP32)
+    AemoStoredCalibration stored;
+    Preferences prefs;
+    if (!prefs.begin(AEMO_CALIBRATION_NVS_NAMESPACE, true)) {
+        return false; // Namespace does not exist yet (first boot)
+    }
+    bool ok = prefs.getBytes(AEMO_CALIBRATION_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored);
+    prefs.end();
+    if (!ok || stored.tag != aemoCalibrationTag()) {
+        return false;
+    }
+    _calibration = stored.calibration;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AemoMotion::clearCalibration() {
+    _calibration = AemoCalibration{{0, 0, 0}, {0, 0, 0}};
+#if defined(ESP32)
+    Preferences prefs;
+    if (prefs.begin(AEMO_CALIBRATION_NVS_NAMESPACE, false)) {
+        prefs.remove(AEMO_CALIBRATION_NVS_KEY);
+        prefs.end();
+    }
+#endif
+}
+
 // --- MPU-6050 Communication Private Methods ---
 
 // Reads a single byte from a MPU-6050 register
+// Returns 0xFF if the read timed out (never a valid WHO_AM_I answer).
 uint8_t AemoMotion::readMPU6050Register(uint8_t reg) {
-    Wire.beginTransmission(MPU6050_ADDR);
-    Wire.write(reg); // Register to read from
-    Wire.endTransmission(false); // Do not release bus
-    Wire.requestFrom(MPU6050_ADDR, 1); // Request 1 byte
-    while (!Wire.available()); // Wait for data
-    return Wire.read();
+    uint8_t value;
+    if (!readMPU6050Burst(reg, &value, 1)) {
+        return 0xFF;
+    }
+    return value;
 }
 
 // Writes a single byte to a MPU-6050 register
@@ -436,15 +1342,39 @@ void AemoMotion::writeMPU6050Register(uint8_t reg, uint8_t value) {
 }
 
 // Reads 16-bit signed integer (two bytes) from MPU-6050 registers
+// Returns 0 if the read timed out.
 int16_t AemoMotion::readMPU6050Word(uint8_t reg) {
+    uint8_t bytes[2];
+    if (!readMPU6050Burst(reg, bytes, 2)) {
+        return 0;
+    }
+    return (int16_t)((bytes[0] << 8) | bytes[1]); // Combine bytes into a signed 16-bit integer
+}
+
+// Reads 'length' consecutive registers starting at 'reg' in one transaction.
+// The MPU-6050 auto-increments the register pointer, so a single requestFrom()
+// returns the whole block. 'length' must not exceed the Wire buffer (32 bytes on AVR).
+bool AemoMotion::readMPU6050Burst(uint8_t reg, uint8_t *buffer, uint8_t length) {
     Wire.beginTransmission(MPU6050_ADDR);
-    Wire.write(reg); // Start reading from high byte register
-    Wire.endTransmission(false); // Do not release bus
-    Wire.requestFrom(MPU6050_ADDR, 2); // Request 2 bytes (high and low)
-    while (!Wire.available()); // Wait for data
+    Wire.write(reg); // Start register
+    if (Wire.endTransmission(false) != 0) { // Do not release bus
+        return false; // NACK or bus error
+    }
+    if (Wire.requestFrom((uint8_t)MPU6050_ADDR, length) != length) {
+        return false;
+    }
 
-    uint8_t highByte = Wire.read();
-    uint8_t lowByte = Wire.read();
+    // Bounded wait instead of spinning forever on a stuck bus
+    unsigned long startTime = micros();
+    while (Wire.available() < length) {
+        if (micros() - startTime > MPU6050_I2C_TIMEOUT_US) {
+            while (Wire.available()) Wire.read(); // Drop partial data
+            return false;
+        }
+    }
 
-    return (int16_t)((highByte << 8) | lowByte); // Combine bytes into a signed 16-bit integer
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = Wire.read();
+    }
+    return true;
 }
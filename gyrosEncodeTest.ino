@@ -4,8 +4,16 @@
 
 #include "gyrosEncode.h" // Include our custom AemoMotion library
 
+// Acquisition mode: 1 = MPU-6050 FIFO + INT pin (every sample at 125 Hz),
+// 0 = poll update() once per loop (one sample every 50 ms).
+#define USE_FIFO_MODE 1
+const int MPU_INT_PIN = 4; // GPIO wired to the MPU-6050 INT pin
+
 // Create an instance of the AemoMotion class
 AemoMotion aemo;
+bool fifoActive = false; // True once beginFifo() succeeded
+
+void runDetectors();
 
 void setup() {
     Serial.begin(115200); // Initialize serial communication
@@ -14,22 +22,59 @@ void setup() {
     Serial.println("\n--- Aemo Motion Library Test ---");
     Serial.println("Initializing MPU-6050...");
 
-    // Initialize the AemoMotion library (and MPU-6050 sensor)
-    if (!aemo.begin()) {
+    // Initialize the AemoMotion library (and MPU-6050 sensor).
+    // Keep the sensor still on the first boot: gyro bias is calibrated once and
+    // stored, later boots reuse the stored offsets and start immediately.
+    if (!aemo.beginCalibrated()) {
         Serial.println("ERROR: MPU-6050 initialization failed! Check wiring.");
         Serial.println("Program will halt.");
         while (true); // Halt if MPU-6050 is not found
     }
+#if USE_FIFO_MODE
+    fifoActive = aemo.beginFifo(MPU_INT_PIN);
+    if (!fifoActive) {
+        Serial.println("ERROR: INT pin has no interrupt capability, falling back to polling.");
+    }
+#if defined(ESP32)
+    // setup() and loop() run in the same task: the data-ready interrupt wakes loop()
+    aemo.setNotifyTask(xTaskGetCurrentTaskHandle());
+#endif
+#endif
     Serial.println("MPU-6050 Initialized Successfully!");
     Serial.println("Move the sensor to see detections.");
     Serial.println("--------------------------------");
 }
 
 void loop() {
-    // Always call update() to refresh the sensor data before using any detection functions.
-    // This should be called as frequently as possible for accurate readings.
-    aemo.update();
+    if (fifoActive) {
+        // Sleep until a batch of samples is in the FIFO instead of polling on a fixed delay.
+        // The timeout only matters if the INT line stops pulsing.
+#if defined(ESP32)
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+#else
+        while (!aemo.fifoPending()) {
+        }
+#endif
+        // Move everything the sensor buffered into the ring buffer, then run the
+        // detectors once per sample so nothing is dropped.
+        aemo.serviceFifo();
+        while (aemo.nextSample()) {
+            runDetectors();
+        }
+    } else {
+        // Always call update() to refresh the sensor data before using any detection functions.
+        // This should be called as frequently as possible for accurate readings.
+        aemo.update();
+        runDetectors();
+
+        // A small delay to prevent overwhelming the serial monitor and allow the ESP32
+        // to perform other tasks. Adjust as needed based on your application's requirements.
+        delay(50);
+    }
+}
 
+// Runs every motion detector against the current sample.
+void runDetectors() {
     // --- Optional: Print Raw Sensor Data for Debugging ---
     // Uncomment these lines if you want to see the raw accelerometer and gyroscope values.
     // Serial.print("Accel (g): X="); Serial.print(aemo.getAccelX(), 2); // 2 decimal places
@@ -94,8 +139,4 @@ void loop() {
     if (aemo.isJerk(0.7, 50)) { // Example: Detect a sharper jerk
         Serial.println(">>> Aemo DETECTED JERK! <<<");
     }
-
-    // A small delay to prevent overwhelming the serial monitor and allow the ESP32
-    // to perform other tasks. Adjust as needed based on your application's requirements.
-    delay(50);
 }
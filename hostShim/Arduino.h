@@ -0,0 +1,95 @@
+// Arduino.h - Minimal Arduino API for host builds of motionBench.ino
+// Only what gyrosEncode.h, FluxGarage_RoboEyes.h and the benchmark use. Time is a virtual
+// clock that the benchmark advances with hostAdvanceMicros(), so a replay runs as fast as
+// the host allows and every run of a trace sees the same timestamps. This directory is
+// only on the include path of a host build; device builds use the real core.
+
+#ifndef HOST_SHIM_ARDUINO_H
+#define HOST_SHIM_ARDUINO_H
+
+#ifdef ARDUINO
+#error "hostShim is for host builds only"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define RISING 0x01
+#define IRAM_ATTR
+#define NOT_AN_INTERRUPT (-1)
+#define DEC 10
+#define HEX 16
+
+using std::min;
+using std::max;
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+// --- Virtual clock ---
+static unsigned long hostClockUs = 0;
+static inline void hostAdvanceMicros(unsigned long us) { hostClockUs += us; }
+static inline unsigned long micros() { return hostClockUs; }
+static inline unsigned long millis() { return hostClockUs / 1000; }
+static inline void delay(unsigned long ms) { hostClockUs += ms * 1000; }
+static inline void delayMicroseconds(unsigned int us) { hostClockUs += us; }
+static inline void yield() {}
+
+// --- Pins: nothing is attached on the host ---
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline int digitalPinToInterrupt(int) { return NOT_AN_INTERRUPT; }
+static inline void attachInterrupt(int, void (*)(), int) {}
+static inline void noInterrupts() {}
+static inline void interrupts() {}
+
+// --- Deterministic random(), so replays are repeatable ---
+static uint32_t hostRandomState = 1;
+static inline void randomSeed(unsigned long seed) { hostRandomState = seed ? seed : 1; }
+static inline long random(long howBig) {
+    if (howBig <= 0) return 0;
+    hostRandomState = hostRandomState * 1664525UL + 1013904223UL;
+    return (long)((hostRandomState >> 8) % (uint32_t)howBig);
+}
+static inline long random(long howSmall, long howBig) {
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+// --- Serial on stdout ---
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    operator bool() { return true; }
+    size_t print(const char *text) { return fputs(text, stdout) >= 0 ? strlen(text) : 0; }
+    size_t print(char c) { return fputc(c, stdout) != EOF; }
+    size_t print(long value, int base = DEC) { return base == HEX ? printf("%lX", value) : printf("%ld", value); }
+    size_t print(unsigned long value, int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", value); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + print('\n'); }
+    template <typename T> size_t println(T value, int base) { size_t n = print(value, base); return n + print('\n'); }
+    size_t println() { return print('\n'); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n > 0 ? n : 0;
+    }
+};
+static HostSerial Serial;
+
+#endif
@@ -0,0 +1,24 @@
+// Wire.h - I2C stand-in for host builds: no device ever answers
+// AemoMotion::begin() fails cleanly, replayed samples do not need the bus.
+
+#ifndef HOST_SHIM_WIRE_H
+#define HOST_SHIM_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    bool begin() { return true; }
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t) {}
+    size_t write(uint8_t) { return 1; }
+    size_t write(const uint8_t *, size_t length) { return length; }
+    uint8_t endTransmission(bool = true) { return 2; } // address not acknowledged
+    uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+    uint8_t requestFrom(uint8_t, uint8_t, bool) { return 0; }
+    int available() { return 0; }
+    int read() { return -1; }
+};
+static TwoWire Wire;
+
+#endif
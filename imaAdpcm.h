@@ -0,0 +1,89 @@
+// imaAdpcm.h - IMA-ADPCM encoder for the microphone upload
+// 4 bits per 16-bit sample, so a 16 kHz mono stream drops from 256 to about 65 kbit/s
+// for a few operations per sample. Audio is encoded in blocks, and each block starts with
+// the encoder state, so the server can decode every block on its own:
+//
+//   [samples: u16][predictor: i16][step index: u8][reserved: u8]   all little endian
+//   (samples + 1) / 2 bytes of codes, first sample in the low nibble
+//
+// The state runs on from block to block, so no quality is lost at the seams.
+// ImaAdpcmDecoder in speech2txtSVR.py reads this format. Uploads state it with
+// "X-Audio-Encoding: ima-adpcm".
+
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#include <Arduino.h>
+
+#define IMA_ADPCM_HEADER_BYTES 6
+#define IMA_ADPCM_BLOCK_BYTES(samples) (IMA_ADPCM_HEADER_BYTES + ((samples) + 1) / 2)
+#define IMA_ADPCM_ENCODING "ima-adpcm"
+
+class ImaAdpcmEncoder {
+public:
+    void reset() { _predictor = 0; _index = 0; }
+
+    // encodeBlock(): Encodes samples into out, which must hold IMA_ADPCM_BLOCK_BYTES(samples).
+    // Returns the bytes written.
+    size_t encodeBlock(const int16_t *pcm, uint16_t samples, uint8_t *out);
+
+private:
+    int32_t _predictor = 0;
+    uint8_t _index = 0;
+
+    uint8_t encodeSample(int16_t sample);
+};
+
+// --- Implementation ---
+
+static const int16_t IMA_ADPCM_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int8_t IMA_ADPCM_INDEX_STEP[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+size_t ImaAdpcmEncoder::encodeBlock(const int16_t *pcm, uint16_t samples, uint8_t *out) {
+    out[0] = samples & 0xFF;
+    out[1] = samples >> 8;
+    out[2] = (uint16_t)_predictor & 0xFF;
+    out[3] = (uint16_t)_predictor >> 8;
+    out[4] = _index;
+    out[5] = 0;
+    uint8_t *codes = out + IMA_ADPCM_HEADER_BYTES;
+    for (uint16_t i = 0; i < samples; i += 2) {
+        uint8_t low = encodeSample(pcm[i]);
+        uint8_t high = i + 1 < samples ? encodeSample(pcm[i + 1]) : 0;
+        *codes++ = low | (high << 4);
+    }
+    return codes - out;
+}
+
+// One 4-bit code; the predictor is updated exactly like the decoder will, so errors do not build up
+uint8_t ImaAdpcmEncoder::encodeSample(int16_t sample) {
+    int32_t step = IMA_ADPCM_STEPS[_index];
+    int32_t diff = sample - _predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    int32_t delta = step >> 3;
+    if (diff >= step) { code |= 4; diff -= step; delta += step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; delta += step; }
+    step >>= 1;
+    if (diff >= step) { code |= 1; delta += step; }
+
+    _predictor += (code & 8) ? -delta : delta;
+    if (_predictor > INT16_MAX) _predictor = INT16_MAX;
+    else if (_predictor < INT16_MIN) _predictor = INT16_MIN;
+
+    int16_t index = _index + IMA_ADPCM_INDEX_STEP[code & 7];
+    _index = index < 0 ? 0 : (index > 88 ? 88 : index);
+    return code;
+}
+
+#endif
@@ -0,0 +1,135 @@
+// keepAliveHttp.h - One persistent HTTPS connection, shared by the REST clients
+// A fresh connection per request costs a full TLS handshake, 1-3 s and ~40 KB of heap on the
+// ESP32. KeepAliveHttp owns one WiFiClientSecure and one HTTPClient for the whole uptime and
+// asks for HTTP keep-alive, so after the first request the TLS session simply stays open.
+// A connection the server dropped while idle is only noticed on the next request; request()
+// then retries it once on a fresh connection. Used by openRouterClient.h and
+// notificationService.h, which only build their requests and read the replies.
+//
+// The server certificate is always checked against a root CA, unless the owner explicitly
+// called beginInsecure().
+
+#ifndef KEEP_ALIVE_HTTP_H
+#define KEEP_ALIVE_HTTP_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+
+// Sets up and sends one request on http, e.g. addHeader() and POST(). Returns the HTTP code.
+// It may run twice for one request() call, so it must be able to repeat the body.
+typedef int (*KeepAliveSend)(HTTPClient &http, void *arg);
+
+class KeepAliveHttp {
+public:
+    // begin(): Server and the root CA its certificate must chain to. Returns false, and every
+    // request() fails, if rootCa is nullptr.
+    bool begin(const char *host, uint16_t port, const char *rootCa, uint16_t timeoutMs);
+
+    // beginInsecure(): Like begin(), but the certificate is not checked. Anyone on the path
+    // can then read what is sent, credentials included; for bench setups only.
+    void beginInsecure(const char *host, uint16_t port, uint16_t timeoutMs);
+
+    // warmUp(): Opens the TLS connection now, if it is not open already
+    bool warmUp();
+
+    // request(): Sends a request through send on path, retrying once on a fresh connection
+    // if the kept-alive one turned out to be closed. Returns the HTTP code (negative for
+    // HTTPClient errors). Read the response through http(), then call end().
+    int request(const char *path, KeepAliveSend send, void *arg);
+
+    // end(): Finishes the request. The connection stays open for the next one unless the
+    // server asked to close it.
+    void end() { _http.end(); }
+
+    HTTPClient &http() { return _http; }
+    bool connected() { return _client.connected(); }
+
+    unsigned long getRequestCount() { return _requests; }
+    unsigned long getReusedCount() { return _reused; }          // requests that needed no handshake
+    unsigned long getReconnectCount() { return _reconnects; }   // stale connections replaced
+    uint32_t getLastHandshakeMs() { return _lastHandshakeMs; }
+    bool lastRequestReused() { return _lastReused; }
+
+private:
+    WiFiClientSecure _client;
+    HTTPClient _http;
+    const char *_host = "";
+    uint16_t _port = 443;
+    bool _ready = false;                // a root CA was set, or insecure mode was chosen
+
+    unsigned long _requests = 0;
+    unsigned long _reused = 0;
+    unsigned long _reconnects = 0;
+    uint32_t _lastHandshakeMs = 0;
+    bool _lastReused = false;
+
+    void setup(const char *host, uint16_t port, uint16_t timeoutMs);
+    int attempt(const char *path, KeepAliveSend send, void *arg);
+    static bool isConnectionError(int code);
+};
+
+// --- Implementation ---
+
+void KeepAliveHttp::setup(const char *host, uint16_t port, uint16_t timeoutMs) {
+    _host = host;
+    _port = port;
+    _http.setReuse(true); // HTTP/1.1 keep-alive, end() leaves the socket open
+    _http.setTimeout(timeoutMs);
+}
+
+bool KeepAliveHttp::begin(const char *host, uint16_t port, const char *rootCa, uint16_t timeoutMs) {
+    setup(host, port, timeoutMs);
+    _ready = rootCa != nullptr;
+    if (_ready) _client.setCACert(rootCa);
+    return _ready;
+}
+
+void KeepAliveHttp::beginInsecure(const char *host, uint16_t port, uint16_t timeoutMs) {
+    setup(host, port, timeoutMs);
+    _client.setInsecure();
+    _ready = true;
+}
+
+bool KeepAliveHttp::warmUp() {
+    if (!_ready) return false;
+    if (_client.connected()) return true;
+    unsigned long start = millis();
+    if (!_client.connect(_host, _port)) return false;
+    _lastHandshakeMs = millis() - start;
+    return true;
+}
+
+int KeepAliveHttp::request(const char *path, KeepAliveSend send, void *arg) {
+    _requests++;
+    bool reusing = _client.connected();
+    if (!reusing && !warmUp()) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+    int code = attempt(path, send, arg);
+    if (reusing && isConnectionError(code)) {
+        // The server closed the idle connection; this is the only request that finds out
+        _http.end();
+        _client.stop();
+        _reconnects++;
+        reusing = false;
+        if (!warmUp()) return HTTPC_ERROR_CONNECTION_REFUSED;
+        code = attempt(path, send, arg);
+    }
+    if (reusing) _reused++;
+    _lastReused = reusing;
+    return code;
+}
+
+int KeepAliveHttp::attempt(const char *path, KeepAliveSend send, void *arg) {
+    // begin() only sets up the request; HTTPClient reuses our socket if it is still connected
+    _http.begin(_client, _host, _port, path, true);
+    return send(_http, arg);
+}
+
+bool KeepAliveHttp::isConnectionError(int code) {
+    return code == HTTPC_ERROR_CONNECTION_REFUSED || code == HTTPC_ERROR_SEND_HEADER_FAILED ||
+           code == HTTPC_ERROR_SEND_PAYLOAD_FAILED || code == HTTPC_ERROR_NOT_CONNECTED ||
+           code == HTTPC_ERROR_CONNECTION_LOST;
+}
+
+#endif
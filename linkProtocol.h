@@ -0,0 +1,216 @@
+// linkProtocol.h - Persistent binary link between the robot and bgserver.py
+// One TCP connection stays open in both directions. Every message is a frame:
+//
+//   [length: u16, little endian][type: u8][payload: length bytes]
+//
+// length counts the payload only. The device side uses plain lwIP sockets with fixed receive
+// and transmit buffers, so no frame allocates heap memory. poll() sleeps in select() until
+// bytes arrive or the timeout expires, which makes commands event driven instead of polled.
+// Nagle is off, so a frame is sent at once. The frame types must match LINK_FRAME_* in
+// bgserver.py.
+
+#ifndef LINK_PROTOCOL_H
+#define LINK_PROTOCOL_H
+
+#include <Arduino.h>
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+#include <errno.h>
+
+#define LINK_DEFAULT_PORT 5001
+#define LINK_HEADER_BYTES 3
+#define LINK_MAX_PAYLOAD 2048         // larger frames are skipped on receive and refused on send
+#define LINK_CONNECT_TIMEOUT_MS 3000
+#define LINK_SEND_TIMEOUT_MS 1000
+
+// Device -> server
+#define LINK_FRAME_HELLO     0x01     // payload: device name
+#define LINK_FRAME_PING      0x02     // either direction, answered with PONG
+#define LINK_FRAME_PONG      0x03
+#define LINK_FRAME_STATUS    0x10     // payload: profiler report JSON, see taskProfiler.h
+#define LINK_FRAME_TELEMETRY 0x11     // payload: encoded sensor batch
+
+// Server -> device
+#define LINK_FRAME_SPEAK     0x20     // payload: text to say
+#define LINK_FRAME_EMOTION   0x21     // payload: emotion name, e.g. "happy"
+#define LINK_FRAME_PATH_STEP 0x22     // payload: path step JSON
+#define LINK_FRAME_UPDATE    0x23     // payload: any other update JSON from the /updates queue
+
+// Called from poll() for every complete frame. payload is only valid during the call.
+typedef void (*LinkFrameHandler)(uint8_t type, const uint8_t *payload, uint16_t length, void *arg);
+
+class LinkClient {
+public:
+    void setHandler(LinkFrameHandler handler, void *arg) { _handler = handler; _handlerArg = arg; }
+
+    // connect(): Opens the connection, waiting at most LINK_CONNECT_TIMEOUT_MS
+    bool connect(const char *host, uint16_t port = LINK_DEFAULT_PORT);
+    bool connected() { return _socket >= 0; }
+    void stop();
+
+    // send(): Writes one frame. Returns false and closes the link if it could not be sent.
+    bool send(uint8_t type, const uint8_t *payload, uint16_t length);
+    bool send(uint8_t type, const char *text) { return send(type, (const uint8_t *)text, strlen(text)); }
+
+    // poll(): Waits up to timeoutMs for data and dispatches every complete frame.
+    // Returns false if the connection is closed (or was never opened).
+    bool poll(uint32_t timeoutMs);
+
+    unsigned long getFramesSent() { return _framesSent; }
+    unsigned long getFramesReceived() { return _framesReceived; }
+    unsigned long getFramesSkipped() { return _framesSkipped; }
+
+private:
+    int _socket = -1;
+    LinkFrameHandler _handler = nullptr;
+    void *_handlerArg = nullptr;
+    uint8_t _rx[LINK_HEADER_BYTES + LINK_MAX_PAYLOAD];
+    size_t _rxLength = 0;
+    size_t _skipBytes = 0;             // rest of an oversized frame still to throw away
+    uint8_t _tx[LINK_HEADER_BYTES + LINK_MAX_PAYLOAD];
+    unsigned long _framesSent = 0;
+    unsigned long _framesReceived = 0;
+    unsigned long _framesSkipped = 0;
+
+    void dispatch();
+};
+
+// --- Implementation ---
+
+bool LinkClient::connect(const char *host, uint16_t port) {
+    stop();
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *result = nullptr;
+    char portText[6];
+    snprintf(portText, sizeof(portText), "%u", port);
+    if (getaddrinfo(host, portText, &hints, &result) != 0 || result == nullptr) return false;
+
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        freeaddrinfo(result);
+        return false;
+    }
+
+    // Non-blocking connect, so an unreachable server costs LINK_CONNECT_TIMEOUT_MS and not minutes
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int rc = lwip_connect(fd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (rc < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return false;
+    }
+    if (rc < 0) {
+        fd_set writable;
+        FD_ZERO(&writable);
+        FD_SET(fd, &writable);
+        struct timeval timeout = {LINK_CONNECT_TIMEOUT_MS / 1000, (LINK_CONNECT_TIMEOUT_MS % 1000) * 1000};
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+        if (select(fd + 1, nullptr, &writable, nullptr, &timeout) <= 0 ||
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLength) != 0 || error != 0) {
+            close(fd);
+            return false;
+        }
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    struct timeval sendTimeout = {LINK_SEND_TIMEOUT_MS / 1000, (LINK_SEND_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+    _socket = fd;
+    _rxLength = 0;
+    _skipBytes = 0;
+    return true;
+}
+
+void LinkClient::stop() {
+    if (_socket >= 0) close(_socket);
+    _socket = -1;
+}
+
+bool LinkClient::send(uint8_t type, const uint8_t *payload, uint16_t length) {
+    if (_socket < 0 || length > LINK_MAX_PAYLOAD) return false;
+    // Header and payload in one buffer, so the frame leaves in a single segment
+    _tx[0] = length & 0xFF;
+    _tx[1] = length >> 8;
+    _tx[2] = type;
+    if (length) memcpy(_tx + LINK_HEADER_BYTES, payload, length);
+    size_t total = LINK_HEADER_BYTES + length;
+    size_t sent = 0;
+    while (sent < total) {
+        int n = ::send(_socket, _tx + sent, total - sent, 0);
+        if (n <= 0) {
+            stop();
+            return false;
+        }
+        sent += n;
+    }
+    _framesSent++;
+    return true;
+}
+
+bool LinkClient::poll(uint32_t timeoutMs) {
+    if (_socket < 0) return false;
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(_socket, &readable);
+    struct timeval timeout = {(long)(timeoutMs / 1000), (long)((timeoutMs % 1000) * 1000)};
+    int ready = select(_socket + 1, &readable, nullptr, nullptr, &timeout);
+    if (ready < 0) {
+        stop();
+        return false;
+    }
+    if (ready == 0) return true; // nothing arrived
+
+    int n = recv(_socket, _rx + _rxLength, sizeof(_rx) - _rxLength, 0);
+    if (n <= 0) { // closed by the server, or an error
+        stop();
+        return false;
+    }
+    _rxLength += n;
+    dispatch();
+    return true;
+}
+
+// Hands out every complete frame in _rx and moves a partial one to the front
+void LinkClient::dispatch() {
+    size_t offset = 0;
+    for (;;) {
+        if (_skipBytes) {
+            size_t skip = min(_skipBytes, _rxLength - offset);
+            offset += skip;
+            _skipBytes -= skip;
+            if (_skipBytes) break;
+        }
+        if (_rxLength - offset < LINK_HEADER_BYTES) break;
+        const uint8_t *frame = _rx + offset;
+        uint16_t length = frame[0] | (frame[1] << 8);
+        if (length > LINK_MAX_PAYLOAD) {
+            // Cannot be buffered; drop it and stay in sync with the stream
+            _framesSkipped++;
+            offset += LINK_HEADER_BYTES;
+            _skipBytes = length;
+            continue;
+        }
+        if (_rxLength - offset < (size_t)LINK_HEADER_BYTES + length) break;
+        _framesReceived++;
+        uint8_t type = frame[2];
+        if (type == LINK_FRAME_PING) {
+            send(LINK_FRAME_PONG, nullptr, 0);
+        } else if (_handler) {
+            _handler(type, frame + LINK_HEADER_BYTES, length, _handlerArg);
+        }
+        offset += LINK_HEADER_BYTES + length;
+    }
+    if (offset > 0) {
+        memmove(_rx, _rx + offset, _rxLength - offset);
+        _rxLength -= offset;
+    }
+}
+
+#endif
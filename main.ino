@@ -9,6 +9,18 @@
 #include <freertos/task.h> // FreeRTOS library for task management (multitasking)
 #include <freertos/queue.h>// FreeRTOS library for inter-task communication (Queues)
 #include <freertos/semphr.h>// FreeRTOS library for task synchronization (Semaphores)
+#include "robotPipeline.h" // Typed frames, SPSC ring and latest-value mailboxes between the tasks
+#include "gyrosEncode.h"   // AemoMotion: MPU-6050 sampling and motion detection
+#include "ultrasonicRanger.h" // Interrupt-driven HC-SR04 ranging
+#include "reflexGuard.h"   // Highest-priority motor cut-off for obstacles, falls and tilts
+#include "motorDriver.h"   // LEDC PWM with acceleration ramps for the L298N
+#include "taskProfiler.h"  // Stack, CPU and loop jitter telemetry
+#include "taskSchedule.h"  // Declarative core / deadline-monotonic priority table
+#include "linkProtocol.h"  // Persistent framed TCP link to bgserver.py
+#include "telemetryBatch.h" // Delta encoded sensor batches sent over the link
+#include "notificationService.h" // Rate-limited WhatsApp alerts for motion and presence
+// Last: RoboEyes defines short macros (N, E, S, W, DEFAULT, ...) that would clash with the headers above
+#include "FluxGarage_RoboEyes.h" // Animated eyes on the SSD1306 OLED
 
 // -----------------------------------------------------------------------------
 // 2. Global Constants and Definitions
@@ -18,9 +30,24 @@
 const char* ssid = "YOUR_WIFI_SSID";     // Replace with your Wi-Fi network name
 const char* password = "YOUR_WIFI_PASSWORD"; // Replace with your Wi-Fi password
 
+// CallMeBot WhatsApp alerts (see notificationService.h)
+const char* alertPhone = "YOUR_PHONE_NUMBER";  // with country code, e.g. +491234567890
+const char* alertApiKey = "YOUR_CALLMEBOT_API_KEY";
+// Root CA of api.callmebot.com. The alert URL carries the API key, so the server must be
+// verified. You MUST replace this with the actual root CA certificate of the server.
+const char* alertRootCa = R"EOF(
+-----BEGIN CERTIFICATE-----
+... (root CA certificate of api.callmebot.com) ...
+-----END CERTIFICATE-----
+)EOF";
+const uint16_t PRESENCE_MM = 800;                // an object closer than this is "someone there"
+const uint16_t PRESENCE_CLEAR_MM = 1000;         // and it has left once it is beyond this
+
 // Server Connection Details (Placeholder)
 const char* serverAddress = "your_server_ip_or_domain.com"; // Replace with your server address
-const int serverPort = 80;                                // Replace with your server port (e.g., 80 for HTTP, 443 for HTTPS, or a custom port)
+const uint16_t linkPort = LINK_DEFAULT_PORT;              // bgserver.py link server port, see linkProtocol.h
+const uint32_t LINK_RECONNECT_MS = 2000;                  // wait between connection attempts
+const uint32_t TELEMETRY_CHECK_MS = 100;                  // server task looks for finished telemetry blocks this often
 
 // Pin Definitions for Motors (Placeholders - adjust as per your motor driver/shield)
 // Example: Assuming 2 DC motors, each needing 2 control pins (e.g., for L298N driver)
@@ -34,6 +61,35 @@ const int MOTOR2_PIN2 = 14;
 const int ULTRASONIC_TRIG_PIN = 32;
 const int ULTRASONIC_ECHO_PIN = 33;
 const int PHOTORESISTOR_PIN = 34; // Analog pin
+const int MPU_INT_PIN = 4; // GPIO wired to the MPU-6050 INT pin
+
+// Sensor pipeline timing
+// The MPU-6050 samples at 125 Hz; the sensor task wakes every IMU_BATCH_SAMPLES samples,
+// publishes a SensorFrame, and the logic task reacts to it right away.
+const uint8_t IMU_BATCH_SAMPLES = 2;                    // 2 samples = one sensor period of 16 ms
+const uint32_t SENSOR_PERIOD_MS = 16;
+const uint16_t ULTRASONIC_RATE_HZ = 40;                 // pings per second, measured in the background
+const uint16_t OBSTACLE_STOP_MM = 200;                  // logic stops the wheels below this range
+const uint16_t REFLEX_STOP_MM = 150;                    // reflex cuts the motors below this range
+const uint16_t REFLEX_SELF_TEST_TRIPS = 200;            // forced trips at boot for the latency figure
+const uint32_t MOTOR_CONTROL_PERIOD_MS = 5;             // 200 Hz motor control loop
+const uint16_t MOTOR_RAMP_PER_SECOND = 400;             // speed units per second for normal driving
+const uint32_t SERVER_PERIOD_MS = 5000;                 // server task runs every 5 seconds
+const uint32_t LOGIC_PERIOD_MS = SENSOR_PERIOD_MS;      // logic runs once per SensorFrame
+const uint32_t SENSOR_DEADLINE_MS = 8;                  // IMU hazards must reach the reflex within half a period
+
+// OLED eyes (SSD1306 on the same I2C bus as the MPU-6050)
+const int SCREEN_WIDTH = 128;
+const int SCREEN_HEIGHT = 64;
+const uint8_t OLED_ADDRESS = 0x3C;
+const uint32_t I2C_CLOCK_HZ = 400000;                   // fast mode: a full 1 KB eye frame ~25 ms instead of ~90 ms
+const uint32_t EYE_RENDER_PERIOD_MS = 20;               // 50 fps while animating
+const byte EYE_IDLE_FPS = 10;                           // frame rate once the eyes hold still
+
+// Task stack depth in bytes, see the scheduling profile in setup(). Still the generous first
+// guess; the profiler report shows how much of it each task actually uses.
+const uint32_t TASK_STACK_BYTES = 10000;
+const uint32_t PROFILER_REPORT_PERIOD_MS = 5000;        // profiler sample and serial report
 
 // -----------------------------------------------------------------------------
 // 3. Global Variables for FreeRTOS and Communication
@@ -45,12 +101,36 @@ TaskHandle_t TaskMotorControl = NULL;
 TaskHandle_t TaskSensorRead = NULL;
 TaskHandle_t TaskServerComm = NULL;
 TaskHandle_t TaskMainRobotLogic = NULL;
-
-// Queues: For sending data safely between different tasks.
-// E.g., Sensor data can be put into a queue by the sensor task
-// and read by the main robot logic task.
-QueueHandle_t sensorDataQueue; // Queue to send sensor readings
-QueueHandle_t motorCommandQueue; // Queue to send motor commands
+TaskHandle_t TaskEyeRender = NULL;
+TaskHandle_t TaskNotify = NULL;
+
+// Data paths between the tasks (see robotPipeline.h):
+// every IMU sample goes through a lock-free ring from the sensor task to the logic task,
+// sensor summaries and motor commands are latest-value mailboxes that notify their reader.
+SpscRing<ImuFrame, 64> imuFrames;          // sensor task -> logic task, every sample
+LatestValue<SensorFrame> sensorFrames;     // sensor task -> logic task, newest summary
+LatestValue<MotorCommand> motorCommands;   // logic task -> motor task, newest command
+LatestValue<uint8_t> eyeMoods;             // server task -> eye render task, newest roboEyes mood
+
+AemoMotion imu; // MPU-6050, owned by the sensor task
+UltrasonicRanger ranger; // HC-SR04, runs from its own timer and echo interrupt
+ReflexGuard reflex;      // Safety stop that bypasses the logic task
+MotorDriver motors;      // Both wheels, ramped by the motor task
+LinkClient serverLink;   // Owned by the server task
+TelemetryBatcher telemetry; // logic task -> server task, encoded sensor blocks
+NotificationService notifier; // any task -> notify task, alerts for the phone
+
+RoboEyesSSD1306 oled(Wire, OLED_ADDRESS);  // frame buffer that is sent over I2C
+RoboEyesAsyncDisplay eyeDisplay(oled);     // draws into a back buffer, a helper task does the I2C transfer
+roboEyes eyes;                             // owned by the eye render task
+
+// Telemetry: one jitter histogram per periodic loop, reported by loop()
+TaskProfiler profiler;
+LoopJitter motorLoop;
+LoopJitter sensorLoop;
+LoopJitter serverLoop;
+LoopJitter logicLoop;
+LoopJitter eyeLoop;
 
 // Semaphores: For protecting shared resources (e.g., a global variable)
 // or for signaling between tasks.
@@ -63,190 +143,365 @@ SemaphoreHandle_t wifiConnectedSemaphore; // Binary semaphore to signal Wi-Fi co
 // -----------------------------------------------------------------------------
 
 // Task 1: Motor Control Task
-// This task will handle sending commands to the motors.
-// It will typically read commands from a queue.
+// Fixed-rate control loop: picks up the newest MotorCommand and ramps the LEDC PWM duty
+// of both wheels towards it every MOTOR_CONTROL_PERIOD_MS.
 void motorControlTask(void *pvParameters) {
-  // Initialize motor pins (set them as OUTPUTs)
-  pinMode(MOTOR1_PIN1, OUTPUT);
-  pinMode(MOTOR1_PIN2, OUTPUT);
-  pinMode(MOTOR2_PIN1, OUTPUT);
-  pinMode(MOTOR2_PIN2, OUTPUT);
-
-  // Initial state: Motors off
-  digitalWrite(MOTOR1_PIN1, LOW);
-  digitalWrite(MOTOR1_PIN2, LOW);
-  digitalWrite(MOTOR2_PIN1, LOW);
-  digitalWrite(MOTOR2_PIN2, LOW);
-
+  // The motor pins were attached to LEDC in setup(), all duties start at 0
   Serial.println("Motor Control Task running on Core " + String(xPortGetCoreID()));
 
-  // Ensure Wi-Fi is connected before attempting to use motors if they depend on server commands
-  // This is an example of inter-task synchronization using a semaphore
-  xSemaphoreTake(wifiConnectedSemaphore, portMAX_DELAY); // Wait indefinitely until Wi-Fi is connected
-
+  // Motors are driven from local sensor data, so this task does not wait for Wi-Fi
+  uint32_t appliedSequence = 0;
+  TickType_t lastWake = xTaskGetTickCount();
   for (;;) { // Infinite loop for the task
-    // Placeholder for receiving motor commands from a queue
-    // In a real application, you'd read from `motorCommandQueue` here.
-    // Example: int command; if (xQueueReceive(motorCommandQueue, &command, portMAX_DELAY)) { ... execute command ... }
-
-    // --- Motor Control Logic (Placeholder) ---
-    // Example: Move forward for 2 seconds, stop for 1 second
-    Serial.println("Motors: Moving Forward...");
-    digitalWrite(MOTOR1_PIN1, HIGH);
-    digitalWrite(MOTOR1_PIN2, LOW);
-    digitalWrite(MOTOR2_PIN1, HIGH);
-    digitalWrite(MOTOR2_PIN2, LOW);
-    vTaskDelay(pdMS_TO_TICKS(2000)); // Delay for 2 seconds (non-blocking for other tasks)
-
-    Serial.println("Motors: Stopping...");
-    digitalWrite(MOTOR1_PIN1, LOW);
-    digitalWrite(MOTOR1_PIN2, LOW);
-    digitalWrite(MOTOR2_PIN1, LOW);
-    digitalWrite(MOTOR2_PIN2, LOW);
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Delay for 1 second
-
-    // --- End Motor Control Logic ---
-
-    // Yield control back to the scheduler if this task has nothing else to do
-    // This allows other tasks of the same priority to run.
-    vTaskDelay(pdMS_TO_TICKS(100)); // Small delay to prevent task from hogging CPU if queue is empty
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(MOTOR_CONTROL_PERIOD_MS));
+    motorLoop.mark();
+
+    if (reflex.isLatched()) {
+      // The reflex already stopped the driver; hold it and re-apply the newest command once cleared
+      motors.emergencyStop();
+      appliedSequence = 0;
+      continue;
+    }
+    if (motors.isStopped()) motors.release(); // reflex was cleared, ramp up again from standstill
+
+    MotorCommand command;
+    if (motorCommands.read(command) && command.sequence != appliedSequence) {
+      motors.setTarget(command.left, command.right, command.rampPerSecond);
+      appliedSequence = command.sequence;
+    }
+    motors.update(MOTOR_CONTROL_PERIOD_MS * 1000UL);
+    motorLoop.done();
   }
 }
 
 // Task 2: Sensor Reading Task
-// This task will periodically read data from various sensors and
-// send the readings to another task (e.g., Main Robot Logic) via a queue.
+// Collects every MPU-6050 sample through the FIFO, runs the motion detectors on each one and
+// pushes the result into imuFrames. Once per sensor period it also publishes a SensorFrame
+// with the ultrasonic and light readings, which wakes the logic task.
+uint8_t runImuDetectors() {
+  uint8_t events = 0;
+  if (imu.detectShake()) events |= IMU_EVENT_SHAKE;
+  if (imu.isFreefalling()) events |= IMU_EVENT_FREEFALL;
+  if (imu.isTilted()) events |= IMU_EVENT_TILT;
+  if (imu.isSpinning()) events |= IMU_EVENT_SPIN;
+  if (imu.isJerk()) events |= IMU_EVENT_JERK;
+  return events;
+}
+
 void sensorReadTask(void *pvParameters) {
   // Initialize sensor pins (set them as INPUTs or specific sensor init)
-  pinMode(ULTRASONIC_TRIG_PIN, OUTPUT);
-  pinMode(ULTRASONIC_ECHO_PIN, INPUT);
   pinMode(PHOTORESISTOR_PIN, INPUT);
+  // The ranger fires the trigger from a timer and timestamps the echo in an interrupt,
+  // so this task never waits for an echo
+  if (!ranger.begin(ULTRASONIC_TRIG_PIN, ULTRASONIC_ECHO_PIN, ULTRASONIC_RATE_HZ)) {
+    Serial.println("Sensors: Ultrasonic ranger could not be started!");
+  }
 
   Serial.println("Sensor Reading Task running on Core " + String(xPortGetCoreID()));
 
+  bool imuReady = imu.beginCalibrated();
+  bool fifoActive = imuReady && imu.beginFifo(MPU_INT_PIN, IMU_BATCH_SAMPLES);
+  if (fifoActive) {
+    imu.setNotifyTask(xTaskGetCurrentTaskHandle());
+  } else {
+    Serial.println(imuReady ? "Sensors: MPU-6050 INT pin unusable, polling instead" : "Sensors: MPU-6050 not found!");
+  }
+
+  SensorFrame frame = {};
+  frame.distanceMm = SENSOR_DISTANCE_NONE;
+  uint8_t pendingEvents = 0;
+  TickType_t lastWake = xTaskGetTickCount();
+
   for (;;) { // Infinite loop for the task
-    // --- Sensor Reading Logic (Placeholder) ---
-    // 1. Read Ultrasonic Sensor (Distance)
-    long duration, distanceCm;
-    digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
-    vTaskDelay(pdMS_TO_TICKS(2));
-    digitalWrite(ULTRASONIC_TRIG_PIN, HIGH);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
-    duration = pulseIn(ULTRASONIC_ECHO_PIN, HIGH);
-    distanceCm = duration * 0.034 / 2; // Speed of sound in cm/microsecond
-
-    // 2. Read Photoresistor (Light Level)
-    int lightLevel = analogRead(PHOTORESISTOR_PIN);
-
-    Serial.print("Sensors: Distance = ");
-    Serial.print(distanceCm);
-    Serial.print(" cm, Light = ");
-    Serial.println(lightLevel);
-
-    // --- End Sensor Reading Logic ---
-
-    // Send sensor data to the main robot logic task via the queue
-    // In a real application, you'd define a struct to hold all sensor data.
-    // Example: struct SensorData { int distance; int light; };
-    //          SensorData currentReadings = {distanceCm, lightLevel};
-    //          xQueueSend(sensorDataQueue, &currentReadings, portMAX_DELAY);
-
-    vTaskDelay(pdMS_TO_TICKS(500)); // Read sensors every 500 milliseconds
+    // --- IMU ---
+    if (fifoActive) {
+      // Woken by the data-ready interrupt every IMU_BATCH_SAMPLES samples
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2 * SENSOR_PERIOD_MS));
+      imu.serviceFifo();
+    } else {
+      vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SENSOR_PERIOD_MS));
+    }
+    sensorLoop.mark();
+    bool haveSample = fifoActive ? imu.nextSample() : (imuReady && imu.update());
+    while (haveSample) {
+      ImuFrame *slot = imuFrames.acquire();
+      uint8_t events = runImuDetectors();
+      reflex.reportImu(events & IMU_EVENT_FREEFALL, events & IMU_EVENT_TILT); // straight to the reflex task
+      if (slot) {
+        slot->timestampUs = imu.getSampleTimeUs();
+        slot->accel[0] = imu.getRawAccelX(); slot->accel[1] = imu.getRawAccelY(); slot->accel[2] = imu.getRawAccelZ();
+        slot->gyro[0] = imu.getRawGyroX(); slot->gyro[1] = imu.getRawGyroY(); slot->gyro[2] = imu.getRawGyroZ();
+        slot->roll = imu.getFusedRoll();
+        slot->pitch = imu.getFusedPitch();
+        slot->events = events;
+        imuFrames.commit();
+      }
+      pendingEvents |= events;
+      frame.roll = imu.getFusedRoll();
+      frame.pitch = imu.getFusedPitch();
+      haveSample = fifoActive && imu.nextSample();
+    }
+
+    // --- Ultrasonic and light ---
+    uint16_t distance = ranger.getDistanceMm(); // newest background measurement, never blocks
+    frame.distanceMm = (distance == ULTRASONIC_NO_ECHO) ? SENSOR_DISTANCE_NONE : distance;
+    frame.lightLevel = analogRead(PHOTORESISTOR_PIN);
+
+    // Publish the summary; this wakes the logic task
+    frame.imuEvents = pendingEvents;
+    frame.timestampUs = micros();
+    frame.sequence++;
+    sensorFrames.publish(frame);
+    pendingEvents = 0;
+    sensorLoop.done();
   }
 }
 
 // Task 3: Server Communication Task
-// This task handles sending data to and receiving commands from a remote server.
+// Keeps one framed TCP connection to bgserver.py open (see linkProtocol.h). The task sleeps in
+// select() until a command frame arrives or the next status report is due, so commands are
+// handled within milliseconds instead of on a polling interval.
 // It relies on Wi-Fi being connected.
+void onServerFrame(uint8_t type, const uint8_t *payload, uint16_t length, void *arg) {
+  switch (type) {
+    case LINK_FRAME_SPEAK:
+      Serial.print("Server: Speak -> ");
+      Serial.write(payload, length);
+      Serial.println();
+      break;
+    case LINK_FRAME_EMOTION: {
+      // Emotion names as used by bgserver.py, anything unknown shows the default face
+      uint8_t mood = DEFAULT;
+      if (length == 5 && memcmp(payload, "happy", 5) == 0) mood = HAPPY;
+      else if (length == 5 && memcmp(payload, "angry", 5) == 0) mood = ANGRY;
+      else if (length == 5 && memcmp(payload, "tired", 5) == 0) mood = TIRED;
+      eyeMoods.publish(mood);
+      break;
+    }
+    case LINK_FRAME_PATH_STEP:
+    case LINK_FRAME_UPDATE:
+      Serial.print(type == LINK_FRAME_PATH_STEP ? "Server: Path step -> " : "Server: Update -> ");
+      Serial.write(payload, length);
+      Serial.println();
+      // Parse the JSON and potentially publish it on motorCommands
+      // or pass it on to the main robot logic task.
+      break;
+    default:
+      break;
+  }
+}
+
 void serverCommunicationTask(void *pvParameters) {
   Serial.println("Server Communication Task running on Core " + String(xPortGetCoreID()));
 
   // Wait until Wi-Fi is connected before attempting server communication
   xSemaphoreTake(wifiConnectedSemaphore, portMAX_DELAY); // Wait indefinitely
 
-  // Create a WiFiClient object to connect to the server
-  WiFiClient client;
+  serverLink.setHandler(onServerFrame, NULL);
+  static char statusJson[LINK_MAX_PAYLOAD]; // profiler report, static to keep it off the task stack
+  unsigned long lastStatus = millis() - SERVER_PERIOD_MS;
 
   for (;;) { // Infinite loop for the task
-    if (WiFi.isConnected()) {
-      if (!client.connected()) {
-        Serial.print("Server: Connecting to ");
-        Serial.print(serverAddress);
-        Serial.print(":");
-        Serial.println(serverPort);
-        if (client.connect(serverAddress, serverPort)) {
-          Serial.println("Server: Connected!");
-          // Send initial data or handshake
-          client.println("Hello Server from ESP32!");
-        } else {
-          Serial.println("Server: Connection failed!");
-        }
+    if (!serverLink.connected()) {
+      if (!WiFi.isConnected()) {
+        Serial.println("Server: Wi-Fi lost, waiting for reconnection...");
+        vTaskDelay(pdMS_TO_TICKS(LINK_RECONNECT_MS));
+        continue;
       }
-
-      if (client.connected()) {
-        // --- Server Interaction Logic (Placeholder) ---
-        // 1. Send data to server (e.g., sensor readings from a queue)
-        // Example: client.println("SensorData: " + String(distanceCm));
-
-        // 2. Receive commands from server
-        while (client.available()) {
-          String line = client.readStringUntil('\n');
-          Serial.print("Server: Received -> ");
-          Serial.println(line);
-          // Parse received command and potentially put it into motorCommandQueue
-          // or another queue for the main robot logic task.
-        }
-
-        // --- End Server Interaction Logic ---
-      } else {
-        Serial.println("Server: Client disconnected, attempting to reconnect...");
+      Serial.print("Server: Connecting to ");
+      Serial.print(serverAddress);
+      Serial.print(":");
+      Serial.println(linkPort);
+      if (!serverLink.connect(serverAddress, linkPort)) {
+        Serial.println("Server: Connection failed!");
+        vTaskDelay(pdMS_TO_TICKS(LINK_RECONNECT_MS));
+        continue;
       }
-    } else {
-      Serial.println("Server: Wi-Fi lost, waiting for reconnection...");
+      Serial.println("Server: Connected!");
+      serverLink.send(LINK_FRAME_HELLO, "emo");
     }
 
-    vTaskDelay(pdMS_TO_TICKS(5000)); // Attempt communication/reconnect every 5 seconds
+    // Sleep until a frame arrives, at most until the next status report or telemetry check is due
+    unsigned long sinceStatus = millis() - lastStatus;
+    uint32_t wait = sinceStatus >= SERVER_PERIOD_MS ? 0 : SERVER_PERIOD_MS - sinceStatus;
+    if (wait > TELEMETRY_CHECK_MS) wait = TELEMETRY_CHECK_MS;
+    if (!serverLink.poll(wait)) {
+      Serial.println("Server: Link closed, attempting to reconnect...");
+      continue;
+    }
+
+    // Finished telemetry blocks; the batcher flushes them about once a second, so the radio stays idle in between
+    const TelemetryBlock *block;
+    while ((block = telemetry.peek()) != NULL && serverLink.connected()) {
+      if (!serverLink.send(LINK_FRAME_TELEMETRY, block->data, block->length)) break; // kept for the next connection
+      telemetry.release();
+    }
+
+    if (millis() - lastStatus >= SERVER_PERIOD_MS) {
+      lastStatus = millis();
+      serverLoop.mark();
+      // The newest profiler report, the server keeps it for GET /get_status
+      size_t length = profiler.toJson(statusJson, sizeof(statusJson));
+      if (length > 0) serverLink.send(LINK_FRAME_STATUS, (const uint8_t *)statusJson, length);
+      serverLoop.done();
+    }
   }
 }
 
 // Task 4: Main Robot Logic Task
 // This task acts as the "brain" of the robot. It processes sensor data,
 // makes decisions, and sends commands to other tasks (e.g., motor task).
+// It runs once per published SensorFrame, i.e. once per sensor period.
 void mainRobotLogicTask(void *pvParameters) {
   Serial.println("Main Robot Logic Task running on Core " + String(xPortGetCoreID()));
 
-  // Wait until Wi-Fi is connected if logic depends on it (e.g., for server data)
-  xSemaphoreTake(wifiConnectedSemaphore, portMAX_DELAY); // Wait indefinitely
+  // Decisions are made from local sensor data, so this task does not wait for Wi-Fi
+  MotorCommand command = {0, 0, MOTOR_RAMP_PER_SECOND, 0};
+  unsigned long lastReport = 0;
+  uint32_t batchedSequence = 0; // newest SensorFrame already added to the telemetry
+  bool present = false;         // something in ultrasonic range, for the presence alert
 
   for (;;) { // Infinite loop for the task
-    // --- Robot Decision-Making Logic (Placeholder) ---
-    // Example: Read sensor data from queue and make a decision
-    // int receivedDistance, receivedLight;
-    // if (xQueueReceive(sensorDataQueue, &receivedSensorData, 0)) { // 0 means no wait
-    //   Serial.print("Logic: Processed Distance="); Serial.print(receivedSensorData.distance);
-    //   Serial.print(", Light="); Serial.println(receivedSensorData.light);
-    //   // If distance too close, send stop command to motor task
-    //   // int command = STOP;
-    //   // xQueueSend(motorCommandQueue, &command, 0);
-    // }
-
-    // Simulate some decision based on time
-    static int counter = 0;
-    if (counter % 10 == 0) { // Every 10 seconds (approx)
-      Serial.println("Main Logic: Making a decision...");
-      // Here you'd implement AI/emotional responses, state changes, etc.
+    // Woken by sensorFrames.publish(); the timeout keeps the logic alive if the sensor task stalls
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(4 * SENSOR_PERIOD_MS));
+    logicLoop.mark();
+
+    // --- Robot Decision-Making Logic ---
+    // Every IMU sample since the last run, in order
+    uint8_t imuEvents = 0;
+    const ImuFrame *sample;
+    while ((sample = imuFrames.peek()) != NULL) {
+      imuEvents |= sample->events;
+      telemetry.addImu(*sample);
+      imuFrames.release();
     }
-    counter++;
+
+    SensorFrame sensors;
+    if (!sensorFrames.read(sensors)) continue; // nothing published yet
+    if (sensors.sequence != batchedSequence) { // a timed-out wait sees the previous frame again
+      telemetry.addSensors(sensors);
+      batchedSequence = sensors.sequence;
+    }
+    telemetry.flushIfDue();
+
+    // Stop for obstacles, falls and tilts, otherwise drive forward
+    bool obstacle = sensors.distanceMm < OBSTACLE_STOP_MM;
+    bool unsafe = imuEvents & (IMU_EVENT_FREEFALL | IMU_EVENT_TILT);
+    int16_t speed = (obstacle || unsafe) ? 0 : 180;
+
+    // Alerts only set notification bits; coalescing, rate limit and HTTPS are in the notify task
+    uint32_t alerts = 0;
+    if (imuEvents & IMU_EVENT_SHAKE) alerts |= NOTIFY_EVENT_SHAKE;
+    if (imuEvents & IMU_EVENT_FREEFALL) alerts |= NOTIFY_EVENT_FREEFALL;
+    if (!present && sensors.distanceMm < PRESENCE_MM) {
+      present = true;
+      alerts |= NOTIFY_EVENT_PRESENCE;
+    } else if (present && sensors.distanceMm > PRESENCE_CLEAR_MM) {
+      present = false;
+    }
+    notifier.post(alerts);
+
+    // The reflex may have stopped the motors already; hear about it, and re-arm it once the hazard is gone
+    bool republish = false;
+    ReflexEvent trip;
+    while (reflex.takeEvent(trip)) {
+      Serial.print("Main Logic: Reflex stop, causes = 0x");
+      Serial.print(trip.causes, HEX);
+      Serial.print(", latency = ");
+      Serial.print(trip.latencyUs);
+      Serial.println(" us");
+    }
+    if (reflex.isLatched() && sensors.distanceMm >= REFLEX_STOP_MM && !unsafe) {
+      reflex.clear();
+      republish = true; // wake the motor task so it picks up the current command again
+    }
+
+    if (republish || speed != command.left || speed != command.right) {
+      command.left = speed;
+      command.right = speed;
+      command.sequence++;
+      motorCommands.publish(command);
+      Serial.println(speed ? "Main Logic: Path clear, driving" : "Main Logic: Stopping");
+    }
+
+    if (millis() - lastReport >= 1000) { // status line once a second
+      lastReport = millis();
+      Serial.print("Main Logic: Distance = ");
+      Serial.print(sensors.distanceMm);
+      Serial.print(" mm, Light = ");
+      Serial.print(sensors.lightLevel);
+      Serial.print(", Roll = ");
+      Serial.print(sensors.roll);
+      Serial.print(", Pitch = ");
+      Serial.print(sensors.pitch);
+      Serial.print(", worst reflex latency = ");
+      Serial.print(reflex.getWorstLatencyUs());
+      Serial.println(" us");
+    }
+    // Here you'd implement AI/emotional responses, state changes, etc.
 
     // --- End Robot Decision-Making Logic ---
+    logicLoop.done();
+  }
+}
+
+// Task 5: Eye Render Task
+// Animates the eyes at a fixed pace. Drawing only touches the back buffer of eyeDisplay,
+// the I2C transfer runs in the display's own helper task.
+void eyeRenderTask(void *pvParameters) {
+  Serial.println("Eye Render Task running on Core " + String(xPortGetCoreID()));
+
+  // The task sets the pace, so the library's own frame limit is set above it
+  eyes.begin(eyeDisplay, SCREEN_WIDTH, SCREEN_HEIGHT, 2 * 1000 / EYE_RENDER_PERIOD_MS);
+  eyes.setIdleFramerate(EYE_IDLE_FPS);
+  eyes.setAutoblinker(ON, 3, 2);
+  eyes.setIdleMode(ON, 2, 2);
+  uint8_t mood = DEFAULT;
 
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Run logic every 1 second
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) { // Infinite loop for the task
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(EYE_RENDER_PERIOD_MS));
+    eyeLoop.mark();
+    uint8_t requested;
+    if (eyeMoods.read(requested) && requested != mood) { // set over the server link
+      mood = requested;
+      eyes.setMood(mood);
+    }
+    eyes.update();
+    eyeLoop.done();
   }
 }
 
+// Task 6: Notification Task
+// Sends the WhatsApp alerts posted by the other tasks, see notificationService.h. It sleeps
+// until an event arrives, so it costs nothing while nothing happens.
+void notificationTask(void *pvParameters) {
+  Serial.println("Notification Task running on Core " + String(xPortGetCoreID()));
+  notifier.run();
+}
+
 // -----------------------------------------------------------------------------
-// 5. Arduino Setup Function (Runs once on startup)
+// 5. Scheduling Profile
+//    Every task with its core, period, deadline and stack. startSchedule() derives the
+//    priorities from the deadlines (deadline monotonic: shorter deadline = higher priority)
+//    and keeps the whole band below the Wi-Fi/lwIP tasks.
+//    Core 0: networking (server link, alerts, and later TLS/LLM, audio streaming, A2DP).
+//    Core 1: IMU, motors, reflex and eye rendering, away from the radio.
+//    The reflex sits above the table at configMAX_PRIORITIES - 1, see reflexGuard.h.
+// -----------------------------------------------------------------------------
+TaskSpec schedule[] = {
+  // name           function                 core                   period                   deadline            stack             handle               loop
+  {"MotorControl",  motorControlTask,        SCHEDULE_CORE_CONTROL, MOTOR_CONTROL_PERIOD_MS, 0,                  TASK_STACK_BYTES, &TaskMotorControl,   &motorLoop, 0},
+  {"SensorRead",    sensorReadTask,          SCHEDULE_CORE_CONTROL, SENSOR_PERIOD_MS,        SENSOR_DEADLINE_MS, TASK_STACK_BYTES, &TaskSensorRead,     &sensorLoop, 0},
+  {"MainLogic",     mainRobotLogicTask,      SCHEDULE_CORE_CONTROL, LOGIC_PERIOD_MS,         0,                  TASK_STACK_BYTES, &TaskMainRobotLogic, &logicLoop, 0},
+  {"EyeRender",     eyeRenderTask,           SCHEDULE_CORE_CONTROL, EYE_RENDER_PERIOD_MS,    0,                  TASK_STACK_BYTES, &TaskEyeRender,      &eyeLoop, 0},
+  {"ServerComm",    serverCommunicationTask, SCHEDULE_CORE_NETWORK, SERVER_PERIOD_MS,        0,                  TASK_STACK_BYTES, &TaskServerComm,     &serverLoop, 0},
+  {"Notify",        notificationTask,        SCHEDULE_CORE_NETWORK, NOTIFY_REFILL_MS,        0,                  TASK_STACK_BYTES, &TaskNotify,         NULL, 0},
+};
+const uint8_t SCHEDULE_TASK_COUNT = sizeof(schedule) / sizeof(schedule[0]);
+
+// -----------------------------------------------------------------------------
+// 6. Arduino Setup Function (Runs once on startup)
 // -----------------------------------------------------------------------------
 void setup() {
   Serial.begin(115200); // Initialize serial communication for debugging
@@ -262,12 +517,8 @@ void setup() {
     // Handle error, e.g., halt system
   }
 
-  // Create Queues (adjust queue length based on expected data volume)
-  // Example: Queue for integers, length 10
-  sensorDataQueue = xQueueCreate(10, sizeof(int)); // Placeholder: If sending structs, use sizeof(MyStruct)
-  motorCommandQueue = xQueueCreate(5, sizeof(int)); // Placeholder: If sending structs, use sizeof(MyStruct)
-
-  if (sensorDataQueue == NULL || motorCommandQueue == NULL) {
+  // Create the latest-value mailboxes (the IMU ring is static and needs no setup)
+  if (!sensorFrames.begin() || !motorCommands.begin() || !eyeMoods.begin()) {
     Serial.println("Error creating one or more Queues!");
     // Handle error
   }
@@ -276,6 +527,7 @@ void setup() {
   Serial.print("Connecting to WiFi: ");
   Serial.println(ssid);
   WiFi.begin(ssid, password);
+  WiFi.setSleep(true); // modem sleep between beacons; telemetry is batched so the radio is mostly idle
 
   // Wait for Wi-Fi connection with a timeout
   unsigned long connectionStartTime = millis();
@@ -298,22 +550,76 @@ void setup() {
     Serial.println("\nFailed to connect to WiFi. Tasks relying on WiFi might not function.");
   }
 
-  // -------------------------------------------------------------------------
-  // Create FreeRTOS Tasks
-  // Syntax: xTaskCreatePinnedToCore( TaskFunction, Name, StackDepth, Parameters, Priority, TaskHandle, CoreID );
-  //
-  // CoreID:
-  //   0 (PRO_CPU): Handles Wi-Fi, Bluetooth, and standard Arduino loop.
-  //   1 (APP_CPU): Generally free for user applications, good for heavy tasks.
-  //
-  // StackDepth: Amount of memory (in bytes) allocated for the task's stack.
-  //             Adjust based on task complexity. 10000-20000 is a safe starting point for complex tasks.
-  // Priority: 0 (lowest) to configMAX_PRIORITIES-1 (highest). Higher number = higher priority.
-  // -------------------------------------------------------------------------
-
-  // Create Motor Control Task on Core 1 (APP_CPU) to offload it from Core 0
-  xTaskCreatePinnedToCore(
-      motorControlTask,   // Task function
-      "MotorControl",     // Name of task
-      10000,              // Stack size in words (approx. 40KB for 10000 words on ESP32)
-      NULL,               // Parameter to pass to the
+  // The I2C bus is shared by the MPU-6050 FIFO reads and the OLED push task, and is started
+  // here once, before any task uses it. At the 100 kHz default a full eye frame would hold
+  // the bus for most of a render period and delay every IMU FIFO read behind it.
+  Wire.begin();
+  Wire.setClock(I2C_CLOCK_HZ);
+
+  // Attach the motor pins to LEDC, all duties 0
+  if (!motors.begin(MOTOR1_PIN1, MOTOR1_PIN2, MOTOR2_PIN1, MOTOR2_PIN2)) {
+    Serial.println("Error attaching the motor pins to LEDC!");
+  }
+
+  // Start the reflex first, so it guards the motors from the moment they can move.
+  // The pins are driven by LEDC now, so the reflex stops the driver instead of writing the pins.
+  const int motorPins[] = {MOTOR1_PIN1, MOTOR1_PIN2, MOTOR2_PIN1, MOTOR2_PIN2};
+  reflex.setStopHandler(MotorDriver::stopHandler, &motors);
+  if (!reflex.begin(motorPins, 4, &ranger, REFLEX_STOP_MM)) {
+    Serial.println("Error starting the reflex task!");
+  } else {
+    // Measured worst case for the safety review, while the wheels are still idle
+    uint32_t worstUs = reflex.measureTrips(REFLEX_SELF_TEST_TRIPS);
+    Serial.printf("Reflex self-test: worst of %u forced trips %lu us%s\n", (unsigned)REFLEX_SELF_TEST_TRIPS,
+                  (unsigned long)worstUs, worstUs ? "" : " (a trip did not latch!)");
+  }
+
+  if (!notifier.begin(alertPhone, alertApiKey, alertRootCa)) {
+    Serial.println("Error: no root CA for the alert server, alerts are disabled!");
+  }
+
+  // Create the tasks from the scheduling profile
+  if (!startSchedule(schedule, SCHEDULE_TASK_COUNT, &profiler)) {
+    Serial.println("Error creating one or more tasks!");
+  }
+  printSchedule(schedule, SCHEDULE_TASK_COUNT, Serial);
+
+  // Wake the consumers whenever new data is published
+  sensorFrames.setReader(TaskMainRobotLogic);
+  // The motor task polls motorCommands every control period, so it needs no notification
+
+  // The reflex creates its own task, above the whole table
+  profiler.add("Reflex", reflex.getTaskHandle(), REFLEX_TASK_STACK);
+
+  Serial.println("All tasks created.");
+}
+
+// -----------------------------------------------------------------------------
+// 7. Arduino Loop Function
+// -----------------------------------------------------------------------------
+void loop() {
+  // All work happens in the FreeRTOS tasks; the Arduino loop task only samples the profiler
+  vTaskDelay(pdMS_TO_TICKS(PROFILER_REPORT_PERIOD_MS));
+  profiler.sample();
+  profiler.printReport(Serial);
+  Serial.printf("Notify: %lu events, %lu sent, %lu throttled, %lu failed (last status %d)\n",
+                notifier.getEventCount(), notifier.getSentCount(), notifier.getThrottledCount(),
+                notifier.getFailedCount(), notifier.getLastStatus());
+
+  // Call out new deadline misses separately, they mean the profile no longer fits
+  static uint32_t reportedMisses[SCHEDULE_TASK_COUNT] = {0};
+  for (uint8_t i = 0; i < SCHEDULE_TASK_COUNT; i++) {
+    if (!schedule[i].loop) continue;
+    uint32_t misses = schedule[i].loop->getDeadlineMisses();
+    if (misses != reportedMisses[i]) {
+      Serial.print("Schedule: ");
+      Serial.print(schedule[i].name);
+      Serial.print(" missed ");
+      Serial.print(misses - reportedMisses[i]);
+      Serial.print(" deadlines, worst response ");
+      Serial.print(schedule[i].loop->getWorstResponseUs());
+      Serial.println(" us");
+      reportedMisses[i] = misses;
+    }
+  }
+}
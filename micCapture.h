@@ -0,0 +1,165 @@
+// micCapture.h - I2S microphone capture into a ring of PCM blocks
+// An I2S MEMS microphone (INMP441 or similar: 24-bit samples, left aligned in 32-bit slots)
+// is read by DMA. A capture task drains the DMA buffers and converts each one to 16-bit
+// mono PCM, writing it straight into the next free MicBlock of a single-producer /
+// single-consumer ring (see robotPipeline.h). The consumer, typically the uploader, is
+// notified for every finished block and hands it back with release(). RAM use is fixed,
+// MIC_RING_BLOCKS blocks, however long the recording runs. If the consumer falls behind and
+// the ring is full, audio is dropped a DMA buffer at a time and counted as overruns.
+
+#ifndef MIC_CAPTURE_H
+#define MIC_CAPTURE_H
+
+#include <Arduino.h>
+#include <driver/i2s.h>
+#include "robotPipeline.h"
+
+#define MIC_SAMPLE_RATE 16000
+#define MIC_BLOCK_SAMPLES 512          // 32 ms at 16 kHz, 1 KB of PCM
+#define MIC_RING_BLOCKS 8              // ~256 ms of slack for the consumer
+#define MIC_DMA_BUFFERS 4
+#define MIC_DMA_FRAMES 256             // frames per DMA buffer
+#define MIC_SAMPLE_SHIFT 14            // 32-bit slot to 16-bit PCM, with 4x gain for speech
+#define MIC_TASK_STACK_BYTES 3072
+#define MIC_TASK_PRIORITY 5
+#define MIC_TASK_CORE 1
+
+struct MicBlock {
+    uint32_t timestampMs;              // millis() when the block was completed
+    uint16_t samples;
+    int16_t pcm[MIC_BLOCK_SAMPLES];
+};
+
+class MicCapture {
+public:
+    // begin(): Installs the I2S driver and starts the capture task. Nothing is recorded
+    // until start().
+    bool begin(int bckPin, int wsPin, int dataPin, uint32_t sampleRate = MIC_SAMPLE_RATE,
+               i2s_port_t port = I2S_NUM_0);
+
+    // start()/stop(): Recording on and off. start() discards what the DMA still holds, so a
+    // recording begins with fresh audio. After stop(), the capture task hands out the last,
+    // partial block; isRecording() turns false once it has.
+    void start();
+    void stop() { _recording = false; }
+    bool isRecording() { return _recording || _active; }
+
+    // Consumer side, one task: oldest finished block, or nullptr
+    void setReader(TaskHandle_t task) { _reader = task; }
+    const MicBlock *peek() { return _blocks.peek(); }
+    void release() { _blocks.release(); }
+
+    uint32_t getSampleRate() { return _sampleRate; }
+    unsigned long getBlocksCaptured() { return _captured; }
+    unsigned long getOverruns() { return _overruns; }      // DMA buffers dropped, the ring was full
+
+private:
+    i2s_port_t _port = I2S_NUM_0;
+    uint32_t _sampleRate = MIC_SAMPLE_RATE;
+    TaskHandle_t _task = NULL;
+    TaskHandle_t _reader = NULL;
+    volatile bool _recording = false;  // requested by start()/stop()
+    volatile bool _active = false;     // capture task state
+    volatile bool _restart = false;
+    SpscRing<MicBlock, MIC_RING_BLOCKS> _blocks;
+    MicBlock *_open = nullptr;         // block being filled
+    int32_t _dma[MIC_DMA_FRAMES];
+    unsigned long _captured = 0;
+    unsigned long _overruns = 0;
+
+    static void captureTask(void *arg) { static_cast<MicCapture *>(arg)->run(); }
+    void run();
+    void convert(const int32_t *raw, size_t frames);
+    void commitBlock();
+};
+
+// --- Implementation ---
+
+bool MicCapture::begin(int bckPin, int wsPin, int dataPin, uint32_t sampleRate, i2s_port_t port) {
+    _port = port;
+    _sampleRate = sampleRate;
+
+    i2s_config_t config = {};
+    config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX);
+    config.sample_rate = sampleRate;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
+    config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;  // L/R pin of the mic tied to GND
+    config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+    config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+    config.dma_buf_count = MIC_DMA_BUFFERS;
+    config.dma_buf_len = MIC_DMA_FRAMES;
+    config.use_apll = false;
+    if (i2s_driver_install(_port, &config, 0, NULL) != ESP_OK) return false;
+
+    i2s_pin_config_t pins = {};
+    pins.bck_io_num = bckPin;
+    pins.ws_io_num = wsPin;
+    pins.data_out_num = I2S_PIN_NO_CHANGE;
+    pins.data_in_num = dataPin;
+    if (i2s_set_pin(_port, &pins) != ESP_OK) {
+        i2s_driver_uninstall(_port);
+        return false;
+    }
+
+    return xTaskCreatePinnedToCore(captureTask, "MicCapture", MIC_TASK_STACK_BYTES, this,
+                                   MIC_TASK_PRIORITY, &_task, MIC_TASK_CORE) == pdPASS;
+}
+
+void MicCapture::start() {
+    _restart = true;
+    _recording = true;
+}
+
+void MicCapture::run() {
+    for (;;) {
+        // The DMA is always drained, so it never holds stale audio for long
+        size_t bytesRead = 0;
+        if (i2s_read(_port, _dma, sizeof(_dma), &bytesRead, portMAX_DELAY) != ESP_OK) continue;
+        if (_restart) {
+            _restart = false;
+            i2s_zero_dma_buffer(_port);
+            if (_open) _open->samples = 0; // the partial block belonged to the last recording
+            continue;
+        }
+        if (!_recording) {
+            if (_active) {
+                if (_open && _open->samples) commitBlock();
+                _active = false;
+                if (_reader) xTaskNotifyGive(_reader);
+            }
+            continue;
+        }
+        _active = true;
+        convert(_dma, bytesRead / sizeof(int32_t));
+    }
+}
+
+void MicCapture::convert(const int32_t *raw, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        if (!_open) {
+            _open = _blocks.acquire();
+            if (!_open) {
+                // Ring full: drop the rest of this DMA buffer
+                _overruns++;
+                return;
+            }
+            _open->samples = 0;
+        }
+        int32_t sample = raw[i] >> MIC_SAMPLE_SHIFT;
+        if (sample > INT16_MAX) sample = INT16_MAX;
+        else if (sample < INT16_MIN) sample = INT16_MIN;
+        _open->pcm[_open->samples++] = (int16_t)sample;
+
+        if (_open->samples == MIC_BLOCK_SAMPLES) commitBlock();
+    }
+}
+
+void MicCapture::commitBlock() {
+    _open->timestampMs = millis();
+    _open = nullptr;
+    _blocks.commit();
+    _captured++;
+    if (_reader) xTaskNotifyGive(_reader);
+}
+
+#endif
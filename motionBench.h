@@ -0,0 +1,557 @@
+// motionBench.h - Replay benchmark for the AemoMotion detectors and roboEyes rendering
+// A trace is a binary log of MPU-6050 samples, each with ground-truth labels, mixed with
+// scripted mood and position changes for the eyes. MotionBench replays it:
+//  - every IMU record goes through AemoMotion::replaySample() and the same detectors as
+//    runImuDetectors() in main.ino, timed per sample;
+//  - every BENCH_FRAME_US of trace time, roboEyes::drawEyes() renders a frame into a page
+//    buffer, timed per frame. Nothing is sent to a panel, so only the rasterizer counts;
+//  - detections are matched against the labels: latency from label onset to the first
+//    detection, misses, and detections without a label (false positives).
+// The report gives cycles per sample and per frame, the latencies, heap and stack use, and a
+// checksum of the rendered frames, so a change in the hot paths shows up as numbers.
+//
+// Trace format, little endian:
+//   header    "EMOB" [version: u8][reserved: u8][sample rate Hz: u16]
+//   IMU       [1][timestamp us: u32][sample: 14 B, as burst-read from the MPU-6050][labels: u8]
+//   mood      [2][timestamp us: u32][roboEyes mood: u8]
+//   position  [3][timestamp us: u32][roboEyes position: u8]
+//   end       [0]
+// The low nibble of the labels uses the IMU_EVENT_* bits of robotPipeline.h (BENCH_EVENT_*
+// here) and says which events are physically happening at that sample. The high nibble,
+// BENCH_UNSCORED(), marks events whose detections are not scored there either way, e.g. the
+// accel-only tilt detector during a shake or a fall, where the angle it sees is not a tilt
+// but firing is no mistake either. Records are in time order.
+//
+// Cycles come from the CPU cycle counter on the ESP32. The host build (see motionBench.ino)
+// uses the TSC on x86 and nanoseconds elsewhere, and a virtual clock, so every run of a
+// trace sees the same timestamps and renders the same frames.
+
+#ifndef MOTION_BENCH_H
+#define MOTION_BENCH_H
+
+#include <Arduino.h>
+#include "gyrosEncode.h"
+#if defined(ARDUINO)
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_cpu.h>
+#endif
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+// Last: RoboEyes defines short macros (N, E, S, W, DEFAULT, ...) that would clash with the headers above
+#include "FluxGarage_RoboEyes.h"
+
+#define BENCH_TRACE_MAGIC "EMOB"
+#define BENCH_TRACE_VERSION 1
+#define BENCH_HEADER_BYTES 8
+#define BENCH_IMU_RECORD_BYTES (1 + 4 + MPU6050_SAMPLE_BYTES + 1)
+#define BENCH_EYE_RECORD_BYTES (1 + 4 + 1)
+
+#define BENCH_SAMPLE_RATE_HZ 125       // as configured by AemoMotion::begin()
+#define BENCH_FRAME_US 20000           // one eye frame per 20 ms of trace time, like main.ino
+#define BENCH_MATCH_WINDOW_US 500000   // a detection this soon after a label still counts
+#define BENCH_SCREEN_WIDTH 128
+#define BENCH_SCREEN_HEIGHT 64
+#define BENCH_FRAME_BYTES (BENCH_SCREEN_WIDTH * BENCH_SCREEN_HEIGHT / 8)
+
+// Same bits as IMU_EVENT_* in robotPipeline.h
+#define BENCH_EVENT_SHAKE    0x01
+#define BENCH_EVENT_FREEFALL 0x02
+#define BENCH_EVENT_TILT     0x04
+#define BENCH_EVENT_SPIN     0x08
+#define BENCH_EVENT_COUNT 4            // jerk is timed but not scored, it has no ground truth
+#define BENCH_UNSCORED(events) ((uint8_t)((events) << 4))
+
+#if defined(ARDUINO)
+#define BENCH_CYCLE_UNIT "cycles"
+#elif defined(__x86_64__) || defined(__i386__)
+#define BENCH_CYCLE_UNIT "TSC ticks"
+#else
+#define BENCH_CYCLE_UNIT "ns"
+#endif
+
+enum BenchRecordType : uint8_t {
+    BENCH_RECORD_END = 0,
+    BENCH_RECORD_IMU = 1,
+    BENCH_RECORD_MOOD = 2,
+    BENCH_RECORD_POSITION = 3
+};
+
+struct BenchRecord {
+    uint8_t type;
+    uint32_t timestampUs;
+    uint8_t sample[MPU6050_SAMPLE_BYTES];  // IMU records only
+    uint8_t value;                         // labels, mood or position
+};
+
+static inline uint32_t benchCycles() {
+#if defined(ARDUINO)
+#if ESP_IDF_VERSION_MAJOR >= 5
+    return esp_cpu_get_cycle_count();
+#else
+    return ESP.getCycleCount();
+#endif
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Writes a trace into a caller buffer; records that do not fit set overflowed()
+class BenchTraceWriter {
+public:
+    void begin(uint8_t *buffer, size_t capacity, uint16_t sampleRateHz = BENCH_SAMPLE_RATE_HZ);
+    void addImu(uint32_t timestampUs, const uint8_t *sample, uint8_t labels);
+    // addImu(): From raw LSB values, encoded like the sensor sends them
+    void addImu(uint32_t timestampUs, const int16_t accel[3], const int16_t gyro[3], uint8_t labels);
+    void addMood(uint32_t timestampUs, uint8_t mood) { addEye(BENCH_RECORD_MOOD, timestampUs, mood); }
+    void addPosition(uint32_t timestampUs, uint8_t position) { addEye(BENCH_RECORD_POSITION, timestampUs, position); }
+    // finish(): Appends the end record and returns the trace length, 0 if it overflowed
+    size_t finish();
+
+    size_t size() { return _length; }
+    bool overflowed() { return _overflowed; }
+
+private:
+    uint8_t *_buffer = nullptr;
+    size_t _capacity = 0;
+    size_t _length = 0;
+    bool _overflowed = false;
+
+    uint8_t *reserve(size_t bytes);
+    void addEye(uint8_t type, uint32_t timestampUs, uint8_t value);
+};
+
+class BenchTraceReader {
+public:
+    // begin(): False if the header is missing or of another version
+    bool begin(const uint8_t *trace, size_t length);
+    // next(): The next record; false at the end record, the end of the data or a bad record
+    bool next(BenchRecord &record);
+    uint16_t getSampleRate() { return _sampleRateHz; }
+
+private:
+    const uint8_t *_trace = nullptr;
+    size_t _length = 0;
+    size_t _offset = 0;
+    uint16_t _sampleRateHz = BENCH_SAMPLE_RATE_HZ;
+};
+
+// benchSynthesizeTrace(): A scripted trace with known labels: rest, shake, freefall, tilt,
+// spin, with mood and position changes throughout. About 12 s, 30 KB. Returns its length.
+size_t benchSynthesizeTrace(uint8_t *buffer, size_t capacity);
+
+struct BenchStats {
+    uint32_t count = 0;
+    uint64_t total = 0;
+    uint32_t minimum = UINT32_MAX;
+    uint32_t maximum = 0;
+
+    void add(uint32_t value) {
+        count++;
+        total += value;
+        if (value < minimum) minimum = value;
+        if (value > maximum) maximum = value;
+    }
+    uint32_t mean() const { return count ? (uint32_t)(total / count) : 0; }
+};
+
+// Detection score of one event type
+struct BenchEventScore {
+    uint32_t onsets = 0;               // labelled events
+    uint32_t detected = 0;             // onsets followed by a detection
+    uint32_t falsePositives = 0;       // detections without a label
+    uint32_t detections = 0;           // samples on which the detector fired, unscored ones included
+    BenchStats latencyUs;              // label onset to first detection
+
+    bool active = false;               // label set on the current sample
+    bool matched = false;              // the current labelled event was detected
+    uint32_t onsetUs = 0;
+    uint32_t endUs = 0;
+};
+
+class MotionBench {
+public:
+    // run(): Replays a trace from scratch. Returns false if it is not a valid trace.
+    bool run(const uint8_t *trace, size_t length);
+    // report(): Prints the results of the last run on Serial
+    void report(const char *name);
+
+    const BenchStats &sampleCycles() { return _sampleCycles; }
+    const BenchStats &frameCycles() { return _frameCycles; }
+    const BenchEventScore &score(uint8_t event) { return _scores[event]; }
+    uint32_t getFrameChecksum() { return _frameChecksum; }
+
+private:
+    AemoMotion _imu;
+    roboEyes _eyes;
+    uint8_t _frame[BENCH_FRAME_BYTES];
+    RoboEyesPageBuffer _display{_frame, BENCH_SCREEN_WIDTH, BENCH_SCREEN_HEIGHT};
+
+    BenchStats _sampleCycles;
+    BenchStats _frameCycles;
+    BenchStats _changedFrameCycles;    // frames that were redrawn, not skipped as unchanged
+    BenchEventScore _scores[BENCH_EVENT_COUNT];
+    uint32_t _frameChecksum = 0;
+    uint32_t _traceUs = 0;
+    uint32_t _records = 0;
+
+#if defined(ARDUINO)
+    uint32_t _heapBefore = 0;
+    uint32_t _heapAfter = 0;
+    uint32_t _heapMinimum = 0;
+    uint32_t _stackFree = 0;
+#endif
+
+    uint8_t runDetectors();
+    void score(uint32_t timestampUs, uint8_t labels, uint8_t events);
+    void renderFrame();
+};
+
+// --- Implementation ---
+
+static const char *const BENCH_EVENT_NAMES[BENCH_EVENT_COUNT] = {"shake", "freefall", "tilt", "spin"};
+
+static void benchPut32(uint8_t *p, uint32_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+}
+
+static uint32_t benchGet32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void BenchTraceWriter::begin(uint8_t *buffer, size_t capacity, uint16_t sampleRateHz) {
+    _buffer = buffer;
+    _capacity = capacity;
+    _length = 0;
+    _overflowed = false;
+    uint8_t *header = reserve(BENCH_HEADER_BYTES);
+    if (!header) return;
+    memcpy(header, BENCH_TRACE_MAGIC, 4);
+    header[4] = BENCH_TRACE_VERSION;
+    header[5] = 0;
+    header[6] = sampleRateHz & 0xFF;
+    header[7] = sampleRateHz >> 8;
+}
+
+uint8_t *BenchTraceWriter::reserve(size_t bytes) {
+    // One byte always stays free for the end record
+    if (_overflowed || _length + bytes + 1 > _capacity) {
+        _overflowed = true;
+        return nullptr;
+    }
+    uint8_t *p = _buffer + _length;
+    _length += bytes;
+    return p;
+}
+
+void BenchTraceWriter::addImu(uint32_t timestampUs, const uint8_t *sample, uint8_t labels) {
+    uint8_t *p = reserve(BENCH_IMU_RECORD_BYTES);
+    if (!p) return;
+    p[0] = BENCH_RECORD_IMU;
+    benchPut32(p + 1, timestampUs);
+    memcpy(p + 5, sample, MPU6050_SAMPLE_BYTES);
+    p[5 + MPU6050_SAMPLE_BYTES] = labels;
+}
+
+void BenchTraceWriter::addImu(uint32_t timestampUs, const int16_t accel[3], const int16_t gyro[3], uint8_t labels) {
+    // Big endian accel X/Y/Z, temperature, gyro X/Y/Z
+    uint8_t sample[MPU6050_SAMPLE_BYTES];
+    const int16_t values[7] = {accel[0], accel[1], accel[2], 0, gyro[0], gyro[1], gyro[2]};
+    for (uint8_t i = 0; i < 7; i++) {
+        sample[2 * i] = (uint16_t)values[i] >> 8;
+        sample[2 * i + 1] = (uint16_t)values[i] & 0xFF;
+    }
+    addImu(timestampUs, sample, labels);
+}
+
+void BenchTraceWriter::addEye(uint8_t type, uint32_t timestampUs, uint8_t value) {
+    uint8_t *p = reserve(BENCH_EYE_RECORD_BYTES);
+    if (!p) return;
+    p[0] = type;
+    benchPut32(p + 1, timestampUs);
+    p[5] = value;
+}
+
+size_t BenchTraceWriter::finish() {
+    if (_overflowed || !_buffer) return 0;
+    _buffer[_length++] = BENCH_RECORD_END;
+    return _length;
+}
+
+bool BenchTraceReader::begin(const uint8_t *trace, size_t length) {
+    _trace = trace;
+    _length = length;
+    _offset = BENCH_HEADER_BYTES;
+    if (length < BENCH_HEADER_BYTES || memcmp(trace, BENCH_TRACE_MAGIC, 4) != 0 || trace[4] != BENCH_TRACE_VERSION) {
+        _length = 0;
+        return false;
+    }
+    _sampleRateHz = trace[6] | (trace[7] << 8);
+    return true;
+}
+
+bool BenchTraceReader::next(BenchRecord &record) {
+    if (_offset >= _length) return false;
+    const uint8_t *p = _trace + _offset;
+    record.type = p[0];
+    size_t size = record.type == BENCH_RECORD_IMU ? BENCH_IMU_RECORD_BYTES :
+                  (record.type == BENCH_RECORD_MOOD || record.type == BENCH_RECORD_POSITION) ? BENCH_EYE_RECORD_BYTES : 0;
+    if (size == 0 || _offset + size > _length) {
+        _offset = _length; // end record, unknown type or truncated
+        return false;
+    }
+    record.timestampUs = benchGet32(p + 1);
+    if (record.type == BENCH_RECORD_IMU) {
+        memcpy(record.sample, p + 5, MPU6050_SAMPLE_BYTES);
+        record.value = p[5 + MPU6050_SAMPLE_BYTES];
+    } else {
+        record.value = p[5];
+    }
+    _offset += size;
+    return true;
+}
+
+// Segments of the scripted trace
+struct BenchSegment {
+    uint16_t durationMs;
+    uint8_t labels;
+    uint8_t unscored;             // events not scored in this segment
+};
+
+static const BenchSegment BENCH_SCRIPT[] = {
+    {1500, 0, 0},                                   // at rest, Z up
+    {600, BENCH_EVENT_SHAKE, BENCH_EVENT_TILT},     // shaken along X at 8 Hz, +-2.5 g
+    {1500, 0, 0},
+    {400, BENCH_EVENT_FREEFALL, BENCH_EVENT_TILT},  // dropped, gravity no longer gives an angle
+    {1500, 0, 0},
+    {1500, BENCH_EVENT_TILT, 0},                    // rolled to 35 degrees and held
+    {1000, 0, 0},
+    {1200, BENCH_EVENT_SPIN, 0},                    // turning on the spot at 250 deg/s
+    {1500, 0, 0},
+};
+
+size_t benchSynthesizeTrace(uint8_t *buffer, size_t capacity) {
+    static const uint8_t moods[] = {DEFAULT, HAPPY, ANGRY, TIRED};
+    static const uint8_t positions[] = {DEFAULT, E, NE, N, NW, W, SW, S, SE};
+    const int32_t oneG = AemoActiveScale::accelLsbPerG;
+    const int32_t dps = AemoActiveScale::gyroLsbPerDpsX10 / 10;
+    const uint32_t periodUs = 1000000UL / BENCH_SAMPLE_RATE_HZ;
+
+    BenchTraceWriter writer;
+    writer.begin(buffer, capacity);
+    uint32_t seed = 12345;
+    uint32_t timestampUs = periodUs; // AemoMotion treats 0 as "no sample yet" in places
+    uint32_t nextEyeUs = 0;
+    uint8_t eyeStep = 0;
+
+    for (const BenchSegment &segment : BENCH_SCRIPT) {
+        uint32_t samples = (uint32_t)segment.durationMs * BENCH_SAMPLE_RATE_HZ / 1000;
+        for (uint32_t i = 0; i < samples; i++, timestampUs += periodUs) {
+            if (timestampUs >= nextEyeUs) {
+                // Change the mood every 3 s and look somewhere else every 750 ms
+                if (eyeStep % 4 == 0) writer.addMood(timestampUs, moods[(eyeStep / 4) % 4]);
+                writer.addPosition(timestampUs, positions[eyeStep % 9]);
+                eyeStep++;
+                nextEyeUs = timestampUs + 750000UL;
+            }
+
+            float t = (float)i / BENCH_SAMPLE_RATE_HZ;
+            float ax = 0, ay = 0, az = 1.0f, gz = 0, gx = 0;
+            uint8_t labels = segment.labels;
+            if (segment.labels & BENCH_EVENT_SHAKE) {
+                ax = 2.5f * sinf(2.0f * (float)PI * 8.0f * t);
+            } else if (segment.labels & BENCH_EVENT_FREEFALL) {
+                az = 0.05f;
+            } else if (segment.labels & BENCH_EVENT_TILT) {
+                // 300 ms roll to 35 degrees, then held; labelled from 20 degrees on
+                float angle = min(1.0f, t / 0.3f) * 35.0f;
+                ay = sinf(angle / AEMO_RAD_TO_DEG);
+                az = cosf(angle / AEMO_RAD_TO_DEG);
+                gx = t < 0.3f ? 35.0f / 0.3f : 0.0f;
+                labels = angle > 20.0f ? BENCH_EVENT_TILT : 0;
+            } else if (segment.labels & BENCH_EVENT_SPIN) {
+                gz = 250.0f;
+            }
+
+            // Sensor noise, deterministic: about +-5 mg and +-0.5 deg/s
+            int16_t accel[3], gyro[3];
+            float values[6] = {ax, ay, az, gx, 0, gz};
+            for (uint8_t k = 0; k < 6; k++) {
+                seed = seed * 1664525UL + 1013904223UL;
+                int32_t noise = (int32_t)(seed >> 24) - 128;
+                int32_t lsb = k < 3 ? (int32_t)(values[k] * oneG) + noise * oneG / 25600
+                                    : (int32_t)(values[k] * dps) + noise * dps / 256;
+                int16_t clamped = (int16_t)constrain(lsb, (int32_t)-32768, (int32_t)32767);
+                if (k < 3) accel[k] = clamped;
+                else gyro[k - 3] = clamped;
+            }
+            writer.addImu(timestampUs, accel, gyro, labels | BENCH_UNSCORED(segment.unscored));
+        }
+    }
+    return writer.finish();
+}
+
+bool MotionBench::run(const uint8_t *trace, size_t length) {
+    BenchTraceReader reader;
+    if (!reader.begin(trace, length)) return false;
+
+    _imu = AemoMotion();
+    _eyes = roboEyes();
+    _sampleCycles = BenchStats();
+    _frameCycles = BenchStats();
+    _changedFrameCycles = BenchStats();
+    for (BenchEventScore &score : _scores) score = BenchEventScore();
+    _frameChecksum = 2166136261UL;
+    _records = 0;
+    _traceUs = 0;
+
+#if defined(ARDUINO)
+    _heapBefore = ESP.getFreeHeap();
+#endif
+    _eyes.begin(_display, BENCH_SCREEN_WIDTH, BENCH_SCREEN_HEIGHT, 1000000UL / BENCH_FRAME_US);
+    _eyes.setAutoblinker(ON, 3, 2);
+
+    BenchRecord record;
+    uint32_t firstUs = 0;
+    uint32_t nextFrameUs = 0;
+    while (reader.next(record)) {
+        if (_records++ == 0) {
+            firstUs = record.timestampUs;
+            nextFrameUs = firstUs;
+        }
+#if !defined(ARDUINO)
+        hostClockUs = record.timestampUs; // roboEyes and AemoMotion read the virtual clock
+#endif
+        // Frames that are due before this record
+        while ((int32_t)(record.timestampUs - nextFrameUs) >= 0) {
+            renderFrame();
+            nextFrameUs += BENCH_FRAME_US;
+        }
+
+        switch (record.type) {
+        case BENCH_RECORD_IMU: {
+            uint32_t start = benchCycles();
+            _imu.replaySample(record.sample, record.timestampUs);
+            uint8_t events = runDetectors();
+            _sampleCycles.add(benchCycles() - start);
+            score(record.timestampUs, record.value, events);
+            break;
+        }
+        case BENCH_RECORD_MOOD:
+            _eyes.setMood(record.value);
+            break;
+        case BENCH_RECORD_POSITION:
+            _eyes.setPosition(record.value);
+            break;
+        }
+        _traceUs = record.timestampUs - firstUs;
+    }
+
+#if defined(ARDUINO)
+    _heapAfter = ESP.getFreeHeap();
+    _heapMinimum = ESP.getMinFreeHeap();
+    _stackFree = uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+#endif
+    return true;
+}
+
+// The detectors used by main.ino's runImuDetectors(), in the same order
+uint8_t MotionBench::runDetectors() {
+    uint8_t events = 0;
+    if (_imu.detectShake()) events |= BENCH_EVENT_SHAKE;
+    if (_imu.isFreefalling()) events |= BENCH_EVENT_FREEFALL;
+    if (_imu.isTilted()) events |= BENCH_EVENT_TILT;
+    if (_imu.isSpinning()) events |= BENCH_EVENT_SPIN;
+    _imu.isJerk();
+    return events;
+}
+
+void MotionBench::score(uint32_t timestampUs, uint8_t labels, uint8_t events) {
+    for (uint8_t i = 0; i < BENCH_EVENT_COUNT; i++) {
+        BenchEventScore &s = _scores[i];
+        bool labelled = labels & (1 << i);
+        bool unscored = labels & BENCH_UNSCORED(1 << i);
+        if (labelled && !s.active) {
+            // A label that resumes within the match window continues the same event
+            if (!s.onsets || timestampUs - s.endUs > BENCH_MATCH_WINDOW_US) {
+                s.onsets++;
+                s.onsetUs = timestampUs;
+                s.matched = false;
+            }
+            s.active = true;
+        } else if (!labelled && s.active) {
+            s.active = false;
+            s.endUs = timestampUs;
+        }
+
+        if (!(events & (1 << i))) continue;
+        s.detections++;
+        if (unscored) continue;
+        bool expected = s.active || (s.onsets && timestampUs - s.endUs <= BENCH_MATCH_WINDOW_US);
+        if (!expected) {
+            s.falsePositives++;
+        } else if (!s.matched) {
+            s.matched = true;
+            s.detected++;
+            s.latencyUs.add(timestampUs - s.onsetUs);
+        }
+    }
+}
+
+void MotionBench::renderFrame() {
+    // A fixed frame step, whatever the replay speed; on the host the clock is virtual anyway
+    _eyes.lastFrameTime = millis() - BENCH_FRAME_US / 1000;
+    unsigned long drawn = _eyes.framesDrawn;
+    uint32_t start = benchCycles();
+    _eyes.drawEyes();
+    uint32_t cycles = benchCycles() - start;
+    _frameCycles.add(cycles);
+    if (_eyes.framesDrawn == drawn) return;
+
+    _changedFrameCycles.add(cycles);
+    // FNV-1a over every new frame: the same trace must always render the same pixels
+    for (size_t i = 0; i < sizeof(_frame); i++) _frameChecksum = (_frameChecksum ^ _frame[i]) * 16777619UL;
+}
+
+void MotionBench::report(const char *name) {
+    Serial.printf("Bench: %s, %lu records, %lu.%03lu s of trace\n", name, (unsigned long)_records,
+                  (unsigned long)(_traceUs / 1000000UL), (unsigned long)(_traceUs / 1000UL % 1000));
+    Serial.printf("Bench: AemoMotion (fixed point %d, orientation filter %d): %lu samples, %s per sample min %lu / mean %lu / max %lu\n",
+                  AEMO_FIXED_POINT, AEMO_ORIENTATION_FILTER, (unsigned long)_sampleCycles.count, BENCH_CYCLE_UNIT,
+                  (unsigned long)_sampleCycles.minimum, (unsigned long)_sampleCycles.mean(), (unsigned long)_sampleCycles.maximum);
+    Serial.printf("Bench: roboEyes: %lu frames, %s per frame min %lu / mean %lu / max %lu; %lu redrawn, mean %lu\n",
+                  (unsigned long)_frameCycles.count, BENCH_CYCLE_UNIT, (unsigned long)_frameCycles.minimum,
+                  (unsigned long)_frameCycles.mean(), (unsigned long)_frameCycles.maximum,
+                  (unsigned long)_changedFrameCycles.count, (unsigned long)_changedFrameCycles.mean());
+    for (uint8_t i = 0; i < BENCH_EVENT_COUNT; i++) {
+        const BenchEventScore &s = _scores[i];
+        if (!s.onsets && !s.detections) continue;
+        Serial.printf("Bench:   %-8s %lu/%lu detected, latency ms min %lu / mean %lu / max %lu, %lu false positives\n",
+                      BENCH_EVENT_NAMES[i], (unsigned long)s.detected, (unsigned long)s.onsets,
+                      (unsigned long)(s.latencyUs.count ? s.latencyUs.minimum / 1000 : 0),
+                      (unsigned long)(s.latencyUs.mean() / 1000), (unsigned long)(s.latencyUs.maximum / 1000),
+                      (unsigned long)s.falsePositives);
+    }
+    Serial.printf("Bench: frame checksum %08lX, AemoMotion %u B, roboEyes %u B\n", (unsigned long)_frameChecksum,
+                  (unsigned)sizeof(AemoMotion), (unsigned)sizeof(roboEyes));
+#if defined(ARDUINO)
+    Serial.printf("Bench: heap free %lu B before, %lu B after, %lu B lowest since boot; stack %lu B never used\n",
+                  (unsigned long)_heapBefore, (unsigned long)_heapAfter, (unsigned long)_heapMinimum,
+                  (unsigned long)_stackFree);
+#else
+    Serial.printf("Bench: heap and stack are only measured on the device\n");
+#endif
+}
+
+#endif
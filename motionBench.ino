@@ -0,0 +1,152 @@
+// motionBench.ino - Replay benchmark for the AemoMotion detectors and roboEyes rendering
+// Replays a motion trace (format in motionBench.h) through the detectors and the eye
+// renderer and prints cycles per sample and per frame, detection latencies against the
+// trace labels, and heap and stack use. Run it before and after a change to a hot path.
+//
+// On the ESP32 the trace is /bench.emob on LittleFS if there is one, else the built-in
+// synthetic trace. The bench runs again on every 'b' from the serial monitor. To record a
+// trace from the real sensor, send 'r': samples are logged until the buffer is full or 'r'
+// comes again, then saved as /bench.emob. While recording, 's', 'f', 't' and 'p' toggle
+// the shake, freefall, tilt and spin labels, so mark each event while you perform it.
+//
+// The same sketch builds on a PC against the stubs in hostShim/, with a virtual clock:
+//   g++ -std=gnu++11 -O2 -IhostShim -I. -x c++ motionBench.ino -o motionBench
+//   ./motionBench                       replay the synthetic trace
+//   ./motionBench trace.emob ...        replay trace files, e.g. copied off the device
+//   ./motionBench --write trace.emob    save the synthetic trace
+// Host numbers are TSC ticks (ns on other CPUs); compare them with each other, not with
+// device cycles.
+
+#include "motionBench.h"
+
+#define BENCH_TRACE_BYTES 32768 // about 12 s of IMU records
+#define BENCH_TRACE_FILE "/bench.emob"
+
+static uint8_t trace[BENCH_TRACE_BYTES];
+static MotionBench bench;
+
+#if defined(ARDUINO)
+#include <LittleFS.h>
+
+static size_t traceLength = 0;
+static const char *traceName = "synthetic";
+static bool recording = false;
+static uint8_t recordLabels = 0;
+static BenchTraceWriter recorder;
+AemoMotion imu;
+
+void runBench() {
+    if (bench.run(trace, traceLength)) bench.report(traceName);
+    else Serial.println("Bench: not a valid trace");
+}
+
+size_t loadTrace() {
+    if (!LittleFS.exists(BENCH_TRACE_FILE)) return 0;
+    File file = LittleFS.open(BENCH_TRACE_FILE, "r");
+    if (!file) return 0;
+    size_t length = file.read(trace, sizeof(trace));
+    file.close();
+    return length;
+}
+
+void saveTrace() {
+    size_t length = recorder.finish();
+    if (length == 0) length = recorder.size(); // full: keep what fits, the reader stops at the end of the data
+    File file = LittleFS.open(BENCH_TRACE_FILE, "w");
+    if (!file || file.write(trace, length) != length) {
+        Serial.println("Bench: could not save " BENCH_TRACE_FILE);
+    } else {
+        Serial.printf("Bench: saved %u bytes to " BENCH_TRACE_FILE "\n", (unsigned)length);
+    }
+    if (file) file.close();
+    traceLength = length;
+    traceName = BENCH_TRACE_FILE;
+}
+
+void startRecording() {
+    if (!imu.beginCalibrated()) {
+        Serial.println("Bench: MPU-6050 not found");
+        return;
+    }
+    recorder.begin(trace, sizeof(trace));
+    recordLabels = 0;
+    recording = true;
+    Serial.println("Bench: recording, 's'/'f'/'t'/'p' toggle labels, 'r' stops");
+}
+
+void recordSample() {
+    if (!imu.update()) return;
+    // Back to the burst-read layout the replay expects
+    int16_t accel[3] = {imu.getRawAccelX(), imu.getRawAccelY(), imu.getRawAccelZ()};
+    int16_t gyro[3] = {imu.getRawGyroX(), imu.getRawGyroY(), imu.getRawGyroZ()};
+    recorder.addImu(imu.getSampleTimeUs(), accel, gyro, recordLabels);
+    if (recorder.overflowed()) {
+        recording = false;
+        saveTrace();
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(500);
+    traceLength = LittleFS.begin(true) ? loadTrace() : 0;
+    if (traceLength) {
+        traceName = BENCH_TRACE_FILE;
+    } else {
+        traceLength = benchSynthesizeTrace(trace, sizeof(trace));
+    }
+    runBench();
+}
+
+void loop() {
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == 'b' && !recording) runBench();
+        else if (c == 'r' && !recording) startRecording();
+        else if (c == 'r') { recording = false; saveTrace(); }
+        else if (recording && c == 's') recordLabels ^= BENCH_EVENT_SHAKE;
+        else if (recording && c == 'f') recordLabels ^= BENCH_EVENT_FREEFALL;
+        else if (recording && c == 't') recordLabels ^= BENCH_EVENT_TILT;
+        else if (recording && c == 'p') recordLabels ^= BENCH_EVENT_SPIN;
+    }
+    if (recording) recordSample();
+    else delay(10);
+}
+
+#else
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--write") == 0) {
+        size_t length = benchSynthesizeTrace(trace, sizeof(trace));
+        FILE *file = fopen(argv[2], "wb");
+        if (!file || fwrite(trace, 1, length, file) != length) {
+            fprintf(stderr, "cannot write %s\n", argv[2]);
+            return 1;
+        }
+        fclose(file);
+        return 0;
+    }
+
+    if (argc < 2) {
+        size_t length = benchSynthesizeTrace(trace, sizeof(trace));
+        if (!bench.run(trace, length)) return 1;
+        bench.report("synthetic");
+        return 0;
+    }
+
+    int failures = 0;
+    for (int i = 1; i < argc; i++) {
+        FILE *file = fopen(argv[i], "rb");
+        size_t length = file ? fread(trace, 1, sizeof(trace), file) : 0;
+        if (file) fclose(file);
+        if (!bench.run(trace, length)) {
+            fprintf(stderr, "%s: not a trace\n", argv[i]);
+            failures++;
+            continue;
+        }
+        bench.report(argv[i]);
+    }
+    return failures ? 1 : 0;
+}
+
+#endif
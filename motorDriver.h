@@ -0,0 +1,137 @@
+// motorDriver.h - LEDC PWM driver for two DC motors on an L298N
+// Each wheel has two driver inputs. The input for the current direction gets a PWM duty and
+// the other one is held low, so speed is proportional instead of full power or nothing.
+// Speed changes are ramped by update(), called from a fixed-rate control loop, which keeps
+// the inrush current of starts, stops and reversals from browning out the ESP32.
+
+#ifndef MOTOR_DRIVER_H
+#define MOTOR_DRIVER_H
+
+#include <Arduino.h>
+
+#define MOTOR_PWM_FREQ_HZ 20000    // above the audible range
+#define MOTOR_PWM_RESOLUTION 8     // duty 0..255, matches the speed range
+#define MOTOR_SPEED_MAX 255
+#define MOTOR_DEFAULT_RAMP 510     // speed units per second: full forward to full reverse in 1 s
+
+// Core 3.x attaches LEDC by pin, 2.x needs an explicit channel per pin
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+#define MOTOR_LEDC_PIN_API 1
+#else
+#define MOTOR_LEDC_PIN_API 0
+#endif
+
+class MotorDriver {
+public:
+    // begin(): Attaches the four driver inputs to LEDC. firstChannel..firstChannel+3 are used
+    // on cores that need channels. All outputs start at duty 0.
+    bool begin(int leftIn1, int leftIn2, int rightIn1, int rightIn2, uint8_t firstChannel = 0);
+
+    // setTarget(): Speeds to ramp to, -255 (full reverse) .. 255 (full forward).
+    // rampPerSecond: how fast the current speed may change, 0 jumps to the target at once.
+    void setTarget(int16_t left, int16_t right, uint16_t rampPerSecond = MOTOR_DEFAULT_RAMP);
+
+    // update(): One control step of dtUs microseconds. Moves the current speeds towards
+    // the targets and writes the duties.
+    void update(uint32_t dtUs);
+
+    // emergencyStop(): Duty 0 on all inputs right away, no ramp. Safe to call from a task
+    // that preempts the control loop; setTarget() and update() are ignored until release().
+    void emergencyStop();
+    void release() { _stopped = false; }
+    bool isStopped() { return _stopped; }
+
+    // For ReflexGuard::setStopHandler()
+    static void stopHandler(void *driver) { ((MotorDriver *)driver)->emergencyStop(); }
+
+    int16_t getLeftSpeed() { return _current[0]; }
+    int16_t getRightSpeed() { return _current[1]; }
+
+private:
+    int _pins[4] = {-1, -1, -1, -1};  // left in1, left in2, right in1, right in2
+    uint8_t _channels[4] = {0, 0, 0, 0};
+    int16_t _target[2] = {0, 0};        // left, right
+    int16_t _current[2] = {0, 0};
+    uint16_t _rampPerSecond = MOTOR_DEFAULT_RAMP;
+    uint32_t _rampRemainderUs[2] = {0, 0}; // ramp time not yet turned into a whole speed step
+    volatile bool _stopped = false;
+
+    void writeDuty(uint8_t output, uint32_t duty);
+    void writeWheel(uint8_t wheel, int16_t speed);
+};
+
+// --- Implementation ---
+
+bool MotorDriver::begin(int leftIn1, int leftIn2, int rightIn1, int rightIn2, uint8_t firstChannel) {
+    _pins[0] = leftIn1; _pins[1] = leftIn2; _pins[2] = rightIn1; _pins[3] = rightIn2;
+    for (uint8_t i = 0; i < 4; i++) {
+        _channels[i] = firstChannel + i;
+#if MOTOR_LEDC_PIN_API
+        if (!ledcAttach(_pins[i], MOTOR_PWM_FREQ_HZ, MOTOR_PWM_RESOLUTION)) return false;
+#else
+        if (ledcSetup(_channels[i], MOTOR_PWM_FREQ_HZ, MOTOR_PWM_RESOLUTION) == 0) return false;
+        ledcAttachPin(_pins[i], _channels[i]);
+#endif
+        writeDuty(i, 0);
+    }
+    return true;
+}
+
+void MotorDriver::setTarget(int16_t left, int16_t right, uint16_t rampPerSecond) {
+    if (_stopped) return; // after release() the wheels start from standstill, not from a stale target
+    _target[0] = constrain(left, (int16_t)-MOTOR_SPEED_MAX, (int16_t)MOTOR_SPEED_MAX);
+    _target[1] = constrain(right, (int16_t)-MOTOR_SPEED_MAX, (int16_t)MOTOR_SPEED_MAX);
+    _rampPerSecond = rampPerSecond;
+    // emergencyStop() may have preempted us between the check above and the stores
+    if (_stopped) _target[0] = _target[1] = 0;
+}
+
+void MotorDriver::update(uint32_t dtUs) {
+    if (_stopped) return;
+    for (uint8_t wheel = 0; wheel < 2; wheel++) {
+        int16_t diff = _target[wheel] - _current[wheel];
+        if (diff == 0) {
+            _rampRemainderUs[wheel] = 0;
+        } else if (_rampPerSecond == 0) {
+            _current[wheel] = _target[wheel];
+        } else {
+            // Whole speed steps earned in dtUs, the rest is carried to the next step so slow
+            // ramps at 200 Hz still come out right
+            uint32_t budget = _rampRemainderUs[wheel] + dtUs * _rampPerSecond;
+            int32_t steps = budget / 1000000UL;
+            _rampRemainderUs[wheel] = budget % 1000000UL;
+            if (steps >= abs(diff)) {
+                _current[wheel] = _target[wheel];
+            } else {
+                _current[wheel] += (diff > 0) ? steps : -steps;
+            }
+        }
+        writeWheel(wheel, _current[wheel]);
+    }
+    // emergencyStop() may have preempted us between the check above and the writes
+    if (_stopped) emergencyStop();
+}
+
+void MotorDriver::emergencyStop() {
+    _stopped = true;
+    for (uint8_t i = 0; i < 4; i++) writeDuty(i, 0);
+    _current[0] = _current[1] = 0;
+    _target[0] = _target[1] = 0;
+}
+
+void MotorDriver::writeWheel(uint8_t wheel, int16_t speed) {
+    uint8_t in1 = wheel * 2;
+    // Only one input carries the PWM, the other stays low (forward: in1, reverse: in2)
+    writeDuty(in1, speed > 0 ? speed : 0);
+    writeDuty(in1 + 1, speed < 0 ? -speed : 0);
+}
+
+void MotorDriver::writeDuty(uint8_t output, uint32_t duty) {
+#if MOTOR_LEDC_PIN_API
+    ledcWrite(_pins[output], duty);
+#else
+    ledcWrite(_channels[output], duty);
+#endif
+}
+
+#endif
@@ -0,0 +1,181 @@
+// notificationService.h - Event-driven WhatsApp alerts through the CallMeBot API
+// Control tasks report events with post(), which only sets bits on the service task's
+// notification value: it never allocates, blocks or touches the network, and events
+// that are already pending simply merge. The service task owns the network side:
+//  - coalescing: a message goes out once no new event has come in for NOTIFY_SETTLE_MS,
+//    at the latest NOTIFY_MAX_DELAY_MS after the first one, so a shake that lasts two
+//    seconds is one message, not one per IMU sample;
+//  - rate limit: a token bucket of NOTIFY_BURST messages, refilled once per
+//    NOTIFY_REFILL_MS. Events that arrive while it is empty wait and go out together;
+//  - one connection: a kept-alive TLS session, retried once on a fresh connection if the
+//    server dropped the idle one (see keepAliveHttp.h). The request is built with snprintf
+//    in a fixed buffer.
+// The URL carries the CallMeBot API key, so the server certificate is checked against a
+// root CA; only beginInsecure() skips that.
+
+#ifndef NOTIFICATION_SERVICE_H
+#define NOTIFICATION_SERVICE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "keepAliveHttp.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define NOTIFY_HOST "api.callmebot.com"
+#define NOTIFY_PORT 443
+#define NOTIFY_SETTLE_MS 2000          // quiet time that ends a burst of events
+#define NOTIFY_MAX_DELAY_MS 10000      // a continuous event is reported after this long anyway
+#define NOTIFY_BURST 3                 // messages that may go out back to back
+#define NOTIFY_REFILL_MS 60000         // one more message per minute after that
+#define NOTIFY_TIMEOUT_MS 10000
+#define NOTIFY_PATH_BYTES 320
+
+// Event bits for post()
+#define NOTIFY_EVENT_SHAKE    0x01
+#define NOTIFY_EVENT_FREEFALL 0x02
+#define NOTIFY_EVENT_PRESENCE 0x04     // something came into ultrasonic range
+#define NOTIFY_EVENT_COUNT 3
+
+class NotificationService {
+public:
+    // begin(): Phone number and API key as registered with CallMeBot, and the root CA of
+    // NOTIFY_HOST. Returns false if rootCa is nullptr; nothing is sent then.
+    bool begin(const char *phone, const char *apiKey, const char *rootCa);
+
+    // beginInsecure(): Like begin(), but the server certificate is not checked, so the API
+    // key goes out to whoever answers. For bench setups only.
+    void beginInsecure(const char *phone, const char *apiKey);
+
+    // run(): The service task's body, never returns. Call it from a task on the network core.
+    void run();
+
+    // post(): Reports events from any task. Returns false if the service is not running yet.
+    bool post(uint32_t events) {
+        TaskHandle_t task = _task;
+        return events && task && xTaskNotify(task, events, eSetBits) == pdPASS;
+    }
+
+    unsigned long getEventCount() { return _events; }           // wakeups with new events
+    unsigned long getSentCount() { return _sent; }
+    unsigned long getFailedCount() { return _failed; }
+    unsigned long getThrottledCount() { return _throttled; }    // messages that waited for a token
+    unsigned long getReconnectCount() { return _connection.getReconnectCount(); }
+    int getLastStatus() { return _lastStatus; }
+
+private:
+    KeepAliveHttp _connection;
+    const char *_phone = "";
+    const char *_apiKey = "";
+    volatile TaskHandle_t _task = NULL;
+    uint32_t _credit = NOTIFY_BURST * NOTIFY_REFILL_MS;   // token bucket, in ms of refill
+    uint32_t _creditAt = 0;                               // millis() of the last refill
+
+    unsigned long _events = 0;
+    unsigned long _sent = 0;
+    unsigned long _failed = 0;
+    unsigned long _throttled = 0;
+    int _lastStatus = 0;
+
+    void refill(uint32_t now);
+    bool send(uint32_t events, unsigned long count);
+    static int get(HTTPClient &http, void *) { return http.GET(); }
+    static size_t formatMessage(uint32_t events, unsigned long count, char *text, size_t size);
+};
+
+// --- Implementation ---
+
+static const char *const NOTIFY_EVENT_NAMES[NOTIFY_EVENT_COUNT] = {"shake", "freefall", "presence"};
+
+bool NotificationService::begin(const char *phone, const char *apiKey, const char *rootCa) {
+    _phone = phone;
+    _apiKey = apiKey;
+    _creditAt = millis();
+    return _connection.begin(NOTIFY_HOST, NOTIFY_PORT, rootCa, NOTIFY_TIMEOUT_MS);
+}
+
+void NotificationService::beginInsecure(const char *phone, const char *apiKey) {
+    _phone = phone;
+    _apiKey = apiKey;
+    _creditAt = millis();
+    _connection.beginInsecure(NOTIFY_HOST, NOTIFY_PORT, NOTIFY_TIMEOUT_MS);
+}
+
+void NotificationService::refill(uint32_t now) {
+    _credit = min<uint32_t>(NOTIFY_BURST * NOTIFY_REFILL_MS, _credit + (now - _creditAt));
+    _creditAt = now;
+}
+
+void NotificationService::run() {
+    _task = xTaskGetCurrentTaskHandle();
+    uint32_t pending = 0;
+    unsigned long pendingCount = 0;
+    uint32_t firstMs = 0;
+    uint32_t lastMs = 0;
+    bool waitedForToken = false;
+
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (pending) {
+            uint32_t now = millis();
+            refill(now);
+            uint32_t settled = now - lastMs >= NOTIFY_SETTLE_MS ? 0 : NOTIFY_SETTLE_MS - (now - lastMs);
+            uint32_t overdue = now - firstMs >= NOTIFY_MAX_DELAY_MS ? 0 : NOTIFY_MAX_DELAY_MS - (now - firstMs);
+            uint32_t due = min(settled, overdue);
+            uint32_t token = _credit >= NOTIFY_REFILL_MS ? 0 : NOTIFY_REFILL_MS - _credit;
+            if (due == 0 && token > 0) waitedForToken = true;
+            uint32_t waitMs = max(due, token);
+            if (waitMs == 0) {
+                _credit -= NOTIFY_REFILL_MS;
+                if (waitedForToken) _throttled++;
+                if (send(pending, pendingCount)) _sent++;
+                else _failed++;
+                pending = 0;
+                pendingCount = 0;
+                waitedForToken = false;
+                continue;
+            }
+            wait = pdMS_TO_TICKS(waitMs);
+        }
+
+        // Every bit posted since the last wakeup arrives at once, a burst is one wakeup
+        uint32_t events = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &events, wait) == pdTRUE && events) {
+            lastMs = millis();
+            if (!pending) firstMs = lastMs;
+            pending |= events;
+            pendingCount++;
+            _events++;
+        }
+    }
+}
+
+// "EMO alert: shake, freefall (4 events)", URL encoded for the query string
+size_t NotificationService::formatMessage(uint32_t events, unsigned long count, char *text, size_t size) {
+    size_t length = snprintf(text, size, "EMO+alert%%3A");
+    bool first = true;
+    for (uint8_t i = 0; i < NOTIFY_EVENT_COUNT && length < size; i++) {
+        if (!(events & (1UL << i))) continue;
+        length += snprintf(text + length, size - length, "%s%s", first ? "+" : "%2C+", NOTIFY_EVENT_NAMES[i]);
+        first = false;
+    }
+    if (count > 1 && length < size) length += snprintf(text + length, size - length, "+%%28%lu+events%%29", count);
+    return min(length, size - 1);
+}
+
+bool NotificationService::send(uint32_t events, unsigned long count) {
+    if (WiFi.status() != WL_CONNECTED) return false;
+    char text[96];
+    formatMessage(events, count, text, sizeof(text));
+
+    char path[NOTIFY_PATH_BYTES];
+    int length = snprintf(path, sizeof(path), "/whatsapp.php?phone=%s&text=%s&apikey=%s", _phone, text, _apiKey);
+    if (length <= 0 || (size_t)length >= sizeof(path)) return false;
+
+    int code = _connection.request(path, get, nullptr);
+    _connection.end();
+    _lastStatus = code;
+    return code == HTTP_CODE_OK;
+}
+
+#endif
@@ -0,0 +1,126 @@
+// openRouterClient.h - Keep-alive HTTPS client for the OpenRouter chat completions API
+// The TLS session stays open between requests, and a connection the server dropped while
+// idle is retried once on a fresh one (see keepAliveHttp.h). warmUp() opens the connection
+// early, e.g. while the user is still speaking, so the handshake is off the critical path.
+// For requests with "stream": true, readStream() decodes the reply token by token as it
+// arrives (see chatStream.h) instead of buffering the whole completion. post(ChatContext&)
+// streams the request body straight from the conversation arena (see chatContext.h).
+//
+// Arduino-ESP32's WiFiClientSecure does not expose mbedTLS session tickets, so a resumed
+// handshake after a real disconnect is not possible here; keeping the socket alive is.
+
+#ifndef OPENROUTER_CLIENT_H
+#define OPENROUTER_CLIENT_H
+
+#include <Arduino.h>
+#include "keepAliveHttp.h"
+#include "chatStream.h"
+#include "chatContext.h"
+
+#define OPENROUTER_DEFAULT_HOST "openrouter.ai"
+#define OPENROUTER_DEFAULT_ENDPOINT "/api/v1/chat/completions"
+#define OPENROUTER_PORT 443
+#define OPENROUTER_TIMEOUT_MS 30000     // LLM replies can take a while to start
+
+class OpenRouterClient {
+public:
+    // begin(): API key and the root CA of host. Returns false if rootCa is nullptr; every
+    // request fails then.
+    bool begin(const char *apiKey, const char *rootCa,
+               const char *host = OPENROUTER_DEFAULT_HOST, const char *endpoint = OPENROUTER_DEFAULT_ENDPOINT);
+
+    // Optional headers for the OpenRouter rankings
+    void setAppInfo(const char *referer, const char *title) { _referer = referer; _title = title; }
+
+    // warmUp(): Opens the TLS connection now, if it is not open already
+    bool warmUp() { return _connection.warmUp(); }
+
+    // post(): Sends one chat completion request. Returns the HTTP code (negative for
+    // HTTPClient errors). Read the response through http(), then call end().
+    int post(const uint8_t *body, size_t length);
+    int post(const String &body) { return post((const uint8_t *)body.c_str(), body.length()); }
+    int post(ChatContext &context);
+
+    // readStream(): After a post() that returned 200 for a streaming request, feeds the reply
+    // to handler as it arrives and returns once the server ends it. Returns the bytes read,
+    // or a negative HTTPClient error. Call end() afterwards as usual.
+    int readStream(ChatTokenHandler handler, void *arg = nullptr);
+    ChatStreamParser &stream() { return _stream; }     // state of the last streamed reply
+
+    // end(): Finishes the request. The connection stays open for the next one unless the
+    // server asked to close it.
+    void end() { _connection.end(); }
+
+    HTTPClient &http() { return _connection.http(); }
+    bool connected() { return _connection.connected(); }
+
+    unsigned long getRequestCount() { return _connection.getRequestCount(); }
+    unsigned long getReusedCount() { return _connection.getReusedCount(); }
+    unsigned long getReconnectCount() { return _connection.getReconnectCount(); }
+    uint32_t getLastHandshakeMs() { return _connection.getLastHandshakeMs(); }
+    bool lastRequestReused() { return _connection.lastRequestReused(); }
+
+private:
+    KeepAliveHttp _connection;
+    ChatStreamParser _stream;
+    const char *_endpoint = OPENROUTER_DEFAULT_ENDPOINT;
+    const char *_referer = nullptr;
+    const char *_title = nullptr;
+    char _authorization[160];           // "Bearer <key>", built once
+
+    // What send() needs to build one request; the body is a buffer or a stream
+    struct Request {
+        OpenRouterClient *client;
+        const uint8_t *body;
+        size_t length;
+        ChatBodyStream *stream;
+    };
+
+    int request(const uint8_t *body, size_t length, ChatBodyStream *stream);
+    static int send(HTTPClient &http, void *arg);
+};
+
+// --- Implementation ---
+
+bool OpenRouterClient::begin(const char *apiKey, const char *rootCa, const char *host, const char *endpoint) {
+    _endpoint = endpoint;
+    snprintf(_authorization, sizeof(_authorization), "Bearer %s", apiKey);
+    return _connection.begin(host, OPENROUTER_PORT, rootCa, OPENROUTER_TIMEOUT_MS);
+}
+
+int OpenRouterClient::post(const uint8_t *body, size_t length) {
+    return request(body, length, nullptr);
+}
+
+int OpenRouterClient::post(ChatContext &context) {
+    ChatBodyStream body(context);
+    return request(nullptr, 0, &body);
+}
+
+int OpenRouterClient::request(const uint8_t *body, size_t length, ChatBodyStream *stream) {
+    Request request = {this, body, length, stream};
+    return _connection.request(_endpoint, send, &request);
+}
+
+// Runs again on a fresh connection after a stale one; the stream body rewinds for that
+int OpenRouterClient::send(HTTPClient &http, void *arg) {
+    Request &request = *(Request *)arg;
+    OpenRouterClient &client = *request.client;
+    http.addHeader("Content-Type", "application/json");
+    http.addHeader("Authorization", client._authorization);
+    if (client._referer) http.addHeader("HTTP-Referer", client._referer);
+    if (client._title) http.addHeader("X-Title", client._title);
+    if (request.stream) return http.sendRequest("POST", request.stream, request.stream->rewind());
+    return http.POST((uint8_t *)request.body, request.length);
+}
+
+int OpenRouterClient::readStream(ChatTokenHandler handler, void *arg) {
+    _stream.reset();
+    _stream.setHandler(handler, arg);
+    // writeToStream() undoes the chunked encoding and copies through a small buffer
+    int result = _connection.http().writeToStream(&_stream);
+    _stream.finish();
+    return result;
+}
+
+#endif
@@ -0,0 +1,202 @@
+// reflexGuard.h - Reflex-level motor cut-off for obstacles, falls and tilts
+// A task at the highest priority sleeps on a task notification. The ultrasonic echo interrupt
+// and the IMU sample path wake it directly, without going through the logic task, and the
+// motor pins are driven low right there. The stop stays latched until the logic task clears
+// it; the logic task learns about the trip afterwards through takeEvent().
+//
+// Latency is measured from the moment the hazard became known (falling echo edge, or the
+// IMU detector firing) to the motor pins being low, and the worst case is kept. It does not
+// include the sensor's own delay, e.g. up to one FIFO batch for IMU samples.
+// measureTrips() forces trips on the device to put a number on it for the safety review;
+// main.ino runs it once at boot and prints the worst case.
+
+#ifndef REFLEX_GUARD_H
+#define REFLEX_GUARD_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "ultrasonicRanger.h"
+
+#define REFLEX_TASK_STACK 2048
+#define REFLEX_TASK_CORE 1
+#define REFLEX_EVENT_QUEUE_LENGTH 4
+#define REFLEX_MAX_MOTOR_PINS 4
+#define REFLEX_TRIP_TIMEOUT_US 10000   // measureTrips() gives up on a trip that has not latched by then
+
+// Reasons for a trip, combined as bits
+#define REFLEX_CAUSE_OBSTACLE 0x01
+#define REFLEX_CAUSE_FREEFALL 0x02
+#define REFLEX_CAUSE_TILT     0x04
+
+// What the logic task gets to see after a trip
+struct ReflexEvent {
+    uint8_t causes;        // REFLEX_CAUSE_* that were active
+    uint16_t distanceMm;   // range at the time, ULTRASONIC_NO_ECHO if none
+    uint32_t latencyUs;    // hazard known -> motor pins low
+    int64_t timestampUs;   // esp_timer time the motors were cut
+};
+
+class ReflexGuard {
+public:
+    // begin(): Starts the reflex task and hooks it up to the ranger, if given.
+    // motorPins: the driver inputs to pull low on a trip.
+    bool begin(const int *motorPins, uint8_t pinCount, UltrasonicRanger *ranger, uint16_t stopDistanceMm);
+
+    // reportImu(): Called by the IMU sampling path when a sample shows a freefall or tilt.
+    // Cheap when nothing is detected, so it can be called for every sample.
+    void reportImu(bool freefall, bool tilted);
+
+    // setStopHandler(): Replaces pulling the motor pins low, e.g. with a PWM driver's
+    // emergency stop. Runs in the reflex task and must not block.
+    void setStopHandler(void (*handler)(void *), void *arg) { _stopHandler = handler; _stopArg = arg; }
+
+    // isLatched(): True after a trip until clear(). The motor task must not drive the wheels
+    // while this is set.
+    bool isLatched() { return _latched; }
+
+    // clear(): Re-arms the reflex. Called by the logic task once the hazard is gone.
+    void clear() { _latched = false; }
+
+    // takeEvent(): Next unreported trip, without waiting.
+    bool takeEvent(ReflexEvent &event) { return xQueueReceive(_events, &event, 0) == pdTRUE; }
+
+    // measureTrips(): Forces trips through reportImu() from the calling task and returns the
+    // worst hazard-to-stop latency among them in us, 0 if a trip did not latch in time. Each
+    // trip really cuts the motors, so run it before they are in use, e.g. in setup(). The
+    // trips leave the latch cleared, the counters untouched and nothing queued for takeEvent().
+    uint32_t measureTrips(uint16_t trips);
+
+    TaskHandle_t getTaskHandle() { return _task; }
+    uint32_t getWorstLatencyUs() { return _worstLatencyUs; }
+    uint32_t getLastLatencyUs() { return _lastLatencyUs; }
+    unsigned long getTripCount() { return _tripCount; }
+
+private:
+    int _motorPins[REFLEX_MAX_MOTOR_PINS];
+    uint8_t _pinCount = 0;
+    UltrasonicRanger *_ranger = nullptr;
+    uint16_t _stopDistanceMm = 0;
+    void (*_stopHandler)(void *) = nullptr;
+    void *_stopArg = nullptr;
+
+    TaskHandle_t _task = nullptr;
+    QueueHandle_t _events = nullptr;
+    volatile bool _latched = false;
+    volatile uint8_t _imuCauses = 0;     // set by reportImu(), cleared by the reflex task
+    volatile int64_t _imuReportUs = 0;
+    uint32_t _worstLatencyUs = 0;
+    uint32_t _lastLatencyUs = 0;
+    unsigned long _tripCount = 0;
+
+    static void taskEntry(void *arg);
+    void run();
+    void cutMotors();
+};
+
+// --- Implementation ---
+
+bool ReflexGuard::begin(const int *motorPins, uint8_t pinCount, UltrasonicRanger *ranger, uint16_t stopDistanceMm) {
+    if (pinCount > REFLEX_MAX_MOTOR_PINS) return false;
+    for (uint8_t i = 0; i < pinCount; i++) _motorPins[i] = motorPins[i];
+    _pinCount = pinCount;
+    _ranger = ranger;
+    _stopDistanceMm = stopDistanceMm;
+
+    _events = xQueueCreate(REFLEX_EVENT_QUEUE_LENGTH, sizeof(ReflexEvent));
+    if (_events == NULL) return false;
+    // Above every other task, so a wake-up preempts whatever runs on this core
+    if (xTaskCreatePinnedToCore(taskEntry, "Reflex", REFLEX_TASK_STACK, this,
+                                configMAX_PRIORITIES - 1, &_task, REFLEX_TASK_CORE) != pdPASS) {
+        return false;
+    }
+    if (_ranger) _ranger->setNotifyTask(_task);
+    return true;
+}
+
+void ReflexGuard::reportImu(bool freefall, bool tilted) {
+    uint8_t causes = (freefall ? REFLEX_CAUSE_FREEFALL : 0) | (tilted ? REFLEX_CAUSE_TILT : 0);
+    if (!causes || _task == nullptr) return;
+    _imuReportUs = esp_timer_get_time();
+    _imuCauses = causes;
+    xTaskNotifyGive(_task);
+}
+
+void ReflexGuard::taskEntry(void *arg) {
+    ((ReflexGuard *)arg)->run();
+}
+
+void ReflexGuard::run() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Work out what woke us and since when the hazard is known
+        uint8_t causes = _imuCauses;
+        int64_t knownSinceUs = _imuReportUs;
+        _imuCauses = 0;
+        uint16_t distance = ULTRASONIC_NO_ECHO;
+        int64_t echoUs = 0;
+        if (_ranger) _ranger->getLatest(distance, echoUs); // one pair, not two separate reads
+        if (distance != ULTRASONIC_NO_ECHO && distance < _stopDistanceMm) {
+            if (!causes) knownSinceUs = echoUs;
+            causes |= REFLEX_CAUSE_OBSTACLE;
+        }
+        if (!causes || _latched) continue;
+
+        cutMotors();
+        int64_t stoppedUs = esp_timer_get_time();
+        _latched = true;
+
+        _lastLatencyUs = (uint32_t)(stoppedUs - knownSinceUs);
+        if (_lastLatencyUs > _worstLatencyUs) _worstLatencyUs = _lastLatencyUs;
+        _tripCount++;
+
+        // Report afterwards; if the logic task is behind, the oldest unread trip is kept
+        ReflexEvent event = {causes, distance, _lastLatencyUs, stoppedUs};
+        xQueueSend(_events, &event, 0);
+    }
+}
+
+uint32_t ReflexGuard::measureTrips(uint16_t trips) {
+    if (_task == nullptr) return 0;
+    uint32_t savedWorst = _worstLatencyUs;
+    uint32_t savedLast = _lastLatencyUs;
+    unsigned long savedTrips = _tripCount;
+
+    uint32_t worst = 0;
+    for (uint16_t i = 0; i < trips; i++) {
+        clear();
+        reportImu(false, true);
+        // On the reflex core the notify has already switched to it; from the other core, spin
+        int64_t startUs = esp_timer_get_time();
+        while (!_latched && esp_timer_get_time() - startUs < REFLEX_TRIP_TIMEOUT_US) {
+        }
+        if (!_latched) {
+            worst = 0;
+            break;
+        }
+        if (_lastLatencyUs > worst) worst = _lastLatencyUs;
+        vTaskDelay(1); // wake the reflex from a different point of the tick each time
+    }
+
+    clear();
+    ReflexEvent event;
+    while (takeEvent(event)) {
+    }
+    _worstLatencyUs = savedWorst;
+    _lastLatencyUs = savedLast;
+    _tripCount = savedTrips;
+    return worst;
+}
+
+void ReflexGuard::cutMotors() {
+    if (_stopHandler) {
+        _stopHandler(_stopArg);
+        return;
+    }
+    for (uint8_t i = 0; i < _pinCount; i++) digitalWrite(_motorPins[i], LOW);
+}
+
+#endif
@@ -0,0 +1,253 @@
+// responseCache.h - Small persistent cache for LLM replies and parsed intents
+// Short everyday utterances ("how are you", "good night") repeat a lot, and each one costs
+// an OpenRouter round trip of several seconds. The cache keys a reply by the FNV-1a hash of
+// the normalized prompt: lower case, and runs of spaces and punctuation reduced to one
+// space, so "How are you?" and "how are you" hit the same entry. The hash and the
+// normalized length must both match, which makes a false hit practically impossible.
+//
+// Entries live in RAM and are saved as one blob in NVS flash (Preferences, like the IMU
+// calibration), so they survive a reboot. Each entry has its own TTL, counted in uptime;
+// time while the robot is switched off does not count. When the cache is full, an expired
+// entry is replaced first, otherwise the least recently used one. Not thread safe: use it
+// from one task.
+
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <Arduino.h>
+#if defined(ESP32)
+#include <esp_timer.h>
+#include <Preferences.h>
+#endif
+
+#define RESPONSE_CACHE_ENTRIES 24
+#define RESPONSE_CACHE_REPLY_BYTES 160     // longer replies are not cached
+#define RESPONSE_CACHE_DEFAULT_TTL_S (24UL * 3600UL)
+#define RESPONSE_CACHE_NVS_NAMESPACE "llmcache"
+#define RESPONSE_CACHE_NVS_KEY "entries"
+#define RESPONSE_CACHE_VERSION 1
+
+struct ResponseCacheEntry {
+    uint32_t hash;                 // FNV-1a of the normalized prompt
+    uint16_t promptLength;         // normalized length, 0 marks a free slot
+    uint16_t replyLength;
+    uint32_t expiresS;             // uptime seconds; in NVS: seconds left
+    uint32_t lastUsedS;
+    char reply[RESPONSE_CACHE_REPLY_BYTES];
+};
+
+class ResponseCache {
+public:
+    // begin(): Loads the saved entries. False if there were none (first boot) or the
+    // layout changed.
+    bool begin();
+
+    // get(): The cached reply for prompt (null terminated), or nullptr on a miss.
+    // Valid until the next put() or clear().
+    const char *get(const char *prompt);
+
+    // put(): Stores a reply. False if it is too long to cache.
+    bool put(const char *prompt, const char *reply, uint32_t ttlS = RESPONSE_CACHE_DEFAULT_TTL_S);
+    bool put(const char *prompt, const char *reply, size_t replyLength, uint32_t ttlS);
+
+    // save(): Writes the cache to flash if it changed; call when a flash write is affordable
+    bool save();
+    void clear();
+
+    unsigned long getHits() { return _hits; }
+    unsigned long getMisses() { return _misses; }
+    unsigned long getExpired() { return _expired; }      // misses because the entry was too old
+    unsigned long getEvictions() { return _evictions; }  // live entries replaced to make room
+    uint8_t getHitRatePercent() { return (_hits + _misses) ? (uint8_t)(100UL * _hits / (_hits + _misses)) : 0; }
+    uint8_t getEntryCount();
+
+    // hashPrompt(): FNV-1a over the normalized prompt; length receives the normalized length
+    static uint32_t hashPrompt(const char *prompt, uint16_t &length);
+
+private:
+    ResponseCacheEntry _entries[RESPONSE_CACHE_ENTRIES];
+    bool _dirty = false;
+    unsigned long _hits = 0;
+    unsigned long _misses = 0;
+    unsigned long _expired = 0;
+    unsigned long _evictions = 0;
+
+#if defined(ESP32)
+    static uint32_t nowS() { return (uint32_t)(esp_timer_get_time() / 1000000LL); }
+#else
+    static uint32_t nowS() { return millis() / 1000UL; } // wraps with millis(), after ~49 days
+#endif
+    static bool isLive(const ResponseCacheEntry &entry, uint32_t now) {
+        return entry.promptLength && (int32_t)(entry.expiresS - now) > 0;
+    }
+};
+
+// --- Implementation ---
+
+#define RESPONSE_CACHE_FNV_OFFSET 2166136261UL
+#define RESPONSE_CACHE_FNV_PRIME 16777619UL
+
+struct ResponseCacheStored {
+    uint16_t tag;                  // version and layout, a stale blob is ignored
+    ResponseCacheEntry entries[RESPONSE_CACHE_ENTRIES];
+};
+
+static uint16_t responseCacheTag() {
+    return (RESPONSE_CACHE_VERSION << 12) ^ (RESPONSE_CACHE_ENTRIES << 8) ^ RESPONSE_CACHE_REPLY_BYTES;
+}
+
+uint32_t ResponseCache::hashPrompt(const char *prompt, uint16_t &length) {
+    uint32_t hash = RESPONSE_CACHE_FNV_OFFSET;
+    length = 0;
+    bool pendingSpace = false;
+    for (const char *p = prompt; *p; p++) {
+        char c = *p;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        bool word = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || (uint8_t)c >= 0x80 || c == '\'';
+        if (!word) {
+            pendingSpace = length > 0; // no leading separator
+            continue;
+        }
+        if (pendingSpace) {
+            hash = (hash ^ ' ') * RESPONSE_CACHE_FNV_PRIME;
+            length++;
+            pendingSpace = false;
+        }
+        hash = (hash ^ (uint8_t)c) * RESPONSE_CACHE_FNV_PRIME;
+        length++;
+    }
+    return hash;
+}
+
+bool ResponseCache::begin() {
+    memset(_entries, 0, sizeof(_entries));
+    _dirty = false;
+#if defined(ESP32)
+    // Too big for the task stack, and only needed once
+    ResponseCacheStored *stored = (ResponseCacheStored *)malloc(sizeof(ResponseCacheStored));
+    if (!stored) return false;
+    Preferences prefs;
+    bool ok = prefs.begin(RESPONSE_CACHE_NVS_NAMESPACE, true);
+    if (ok) {
+        ok = prefs.getBytes(RESPONSE_CACHE_NVS_KEY, stored, sizeof(*stored)) == sizeof(*stored);
+        prefs.end();
+    }
+    ok = ok && stored->tag == responseCacheTag();
+    if (ok) {
+        uint32_t now = nowS();
+        for (uint8_t i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+            _entries[i] = stored->entries[i];
+            _entries[i].expiresS += now; // saved as seconds left
+            _entries[i].lastUsedS = now;
+            _entries[i].reply[RESPONSE_CACHE_REPLY_BYTES - 1] = '\0';
+        }
+    }
+    free(stored);
+    return ok;
+#else
+    return false; // No persistent storage on this platform
+#endif
+}
+
+const char *ResponseCache::get(const char *prompt) {
+    uint16_t length;
+    uint32_t hash = hashPrompt(prompt, length);
+    uint32_t now = nowS();
+    for (uint8_t i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+        ResponseCacheEntry &entry = _entries[i];
+        if (!entry.promptLength || entry.hash != hash || entry.promptLength != length) continue;
+        if (!isLive(entry, now)) {
+            entry.promptLength = 0;
+            _dirty = true;
+            _expired++;
+            break;
+        }
+        entry.lastUsedS = now;
+        _hits++;
+        return entry.reply;
+    }
+    _misses++;
+    return nullptr;
+}
+
+bool ResponseCache::put(const char *prompt, const char *reply, uint32_t ttlS) {
+    return put(prompt, reply, strlen(reply), ttlS);
+}
+
+bool ResponseCache::put(const char *prompt, const char *reply, size_t replyLength, uint32_t ttlS) {
+    if (replyLength >= RESPONSE_CACHE_REPLY_BYTES || ttlS == 0) return false;
+    uint16_t length;
+    uint32_t hash = hashPrompt(prompt, length);
+    if (length == 0) return false;
+    uint32_t now = nowS();
+
+    // Same prompt, else a free or expired slot, else the least recently used one
+    ResponseCacheEntry *slot = nullptr;
+    ResponseCacheEntry *oldest = &_entries[0];
+    for (uint8_t i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+        ResponseCacheEntry &entry = _entries[i];
+        if (entry.promptLength && entry.hash == hash && entry.promptLength == length) {
+            slot = &entry;
+            break;
+        }
+        if (!slot && !isLive(entry, now)) slot = &entry;
+        if ((int32_t)(entry.lastUsedS - oldest->lastUsedS) < 0) oldest = &entry;
+    }
+    if (!slot) {
+        slot = oldest;
+        _evictions++;
+    }
+
+    slot->hash = hash;
+    slot->promptLength = length;
+    slot->replyLength = replyLength;
+    slot->expiresS = now + ttlS;
+    slot->lastUsedS = now;
+    memcpy(slot->reply, reply, replyLength);
+    slot->reply[replyLength] = '\0';
+    _dirty = true;
+    return true;
+}
+
+bool ResponseCache::save() {
+    if (!_dirty) return true;
+#if defined(ESP32)
+    ResponseCacheStored *stored = (ResponseCacheStored *)malloc(sizeof(ResponseCacheStored));
+    if (!stored) return false;
+    memset(stored, 0, sizeof(*stored));
+    stored->tag = responseCacheTag();
+    uint32_t now = nowS();
+    for (uint8_t i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+        if (!isLive(_entries[i], now)) continue; // stays a zeroed, free slot
+        stored->entries[i] = _entries[i];
+        stored->entries[i].expiresS = _entries[i].expiresS - now;
+    }
+    Preferences prefs;
+    bool ok = prefs.begin(RESPONSE_CACHE_NVS_NAMESPACE, false);
+    if (ok) {
+        ok = prefs.putBytes(RESPONSE_CACHE_NVS_KEY, stored, sizeof(*stored)) == sizeof(*stored);
+        prefs.end();
+    }
+    free(stored);
+    if (ok) _dirty = false;
+    return ok;
+#else
+    return false;
+#endif
+}
+
+void ResponseCache::clear() {
+    memset(_entries, 0, sizeof(_entries));
+    _dirty = true;
+}
+
+uint8_t ResponseCache::getEntryCount() {
+    uint32_t now = nowS();
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+        if (isLive(_entries[i], now)) count++;
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,142 @@
+// robotPipeline.h - Typed data paths between the FreeRTOS tasks in main.ino
+// Two kinds of traffic flow between the tasks:
+//  - Streams, where every element matters (IMU frames): a lock-free single-producer /
+//    single-consumer ring. The producer writes straight into the slot it will publish and the
+//    consumer reads straight out of it, so nothing is copied through a queue.
+//  - Control data, where only the newest value matters (sensor summary, motor command): a
+//    one-element FreeRTOS queue written with xQueueOverwrite(), so a slow reader never sees
+//    stale values and a fast writer never blocks.
+// Readers are woken with task notifications rather than polling.
+
+#ifndef ROBOT_PIPELINE_H
+#define ROBOT_PIPELINE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// Distance value when the ultrasonic sensor saw no echo
+#define SENSOR_DISTANCE_NONE 0xFFFF
+
+// Bits in ImuFrame::events / SensorFrame::imuEvents
+#define IMU_EVENT_SHAKE    0x01
+#define IMU_EVENT_FREEFALL 0x02
+#define IMU_EVENT_TILT     0x04
+#define IMU_EVENT_SPIN     0x08
+#define IMU_EVENT_JERK     0x10
+
+// One MPU-6050 sample with the detector results for it
+struct ImuFrame {
+  uint32_t timestampUs; // micros() of the sample
+  int16_t accel[3];     // raw LSB, bias corrected
+  int16_t gyro[3];      // raw LSB, bias corrected
+  float roll;           // fused orientation in degrees
+  float pitch;
+  uint8_t events;       // IMU_EVENT_* detected on this sample
+};
+
+// Latest view of all slow sensors plus a summary of the IMU
+struct SensorFrame {
+  uint32_t timestampUs;  // micros() when the frame was published
+  uint16_t distanceMm;   // ultrasonic range, SENSOR_DISTANCE_NONE if there was no echo
+  uint16_t lightLevel;   // raw ADC reading of the photoresistor
+  float roll;            // fused orientation of the newest IMU sample, degrees
+  float pitch;
+  uint8_t imuEvents;     // IMU_EVENT_* seen since the previous SensorFrame
+  uint32_t sequence;     // increments with every published frame
+};
+
+// Wheel speeds from -255 (full reverse) to 255 (full forward)
+struct MotorCommand {
+  int16_t left;
+  int16_t right;
+  uint16_t rampPerSecond; // max speed change per second, 0 = jump to the new speeds
+  uint32_t sequence;     // increments with every command, lets the motor task spot new ones
+};
+
+
+// --- Lock-free SPSC ring ---
+// N must be a power of two. One task may call the producer side, another the consumer side.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+  // Producer: slot to fill in place, or nullptr if the ring is full. Publish it with commit().
+  T *acquire() {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= N) return nullptr;
+    return &_slots[head & (N - 1)];
+  }
+  void commit() {
+    _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Consumer: oldest element, or nullptr if the ring is empty. Hand it back with release().
+  const T *peek() {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return nullptr;
+    return &_slots[tail & (N - 1)];
+  }
+  void release() {
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Copying convenience wrappers. push() counts dropped elements when the ring is full.
+  bool push(const T &value) {
+    T *slot = acquire();
+    if (!slot) { _dropped++; return false; }
+    *slot = value;
+    commit();
+    return true;
+  }
+  bool pop(T &value) {
+    const T *slot = peek();
+    if (!slot) return false;
+    value = *slot;
+    release();
+    return true;
+  }
+
+  size_t size() { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+  unsigned long dropped() { return _dropped; }
+
+private:
+  T _slots[N];
+  std::atomic<size_t> _head{0}; // written by the producer only
+  std::atomic<size_t> _tail{0}; // written by the consumer only
+  unsigned long _dropped = 0;
+};
+
+
+// --- Latest-value mailbox ---
+// Any number of writers and readers. publish() replaces the stored value and, if a reader task
+// is set, notifies it; read() copies the newest value without removing it.
+template <typename T>
+class LatestValue {
+public:
+  bool begin() {
+    _queue = xQueueCreate(1, sizeof(T));
+    return _queue != NULL;
+  }
+
+  void setReader(TaskHandle_t task) { _reader = task; }
+
+  void publish(const T &value) {
+    xQueueOverwrite(_queue, &value);
+    if (_reader) xTaskNotifyGive(_reader);
+  }
+
+  // Returns false if nothing was published within wait ticks
+  bool read(T &value, TickType_t wait = 0) {
+    return xQueuePeek(_queue, &value, wait) == pdTRUE;
+  }
+
+private:
+  QueueHandle_t _queue = NULL;
+  TaskHandle_t _reader = NULL;
+};
+
+#endif
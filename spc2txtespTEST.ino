@@ -1,10 +1,19 @@
 // ESP32 Speech-to-Text Client
-// Connects to Wi-Fi, makes an HTTP POST request to a Flask server
-// with audio data, and processes the transcription response.
+// Connects to Wi-Fi, listens on an I2S microphone and streams each utterance to a Flask
+// server while the user is still speaking, then processes the transcription response.
+// The microphone is read by DMA into a small ring of PCM blocks (micCapture.h). A voice
+// activity detector (voiceActivity.h) opens an upload only when speech starts and trims
+// the silence around it. Each block is IMA-ADPCM encoded (imaAdpcm.h, 4:1) and sent as
+// one HTTP chunk (chunkedUpload.h), so RAM
+// use does not depend on how long the user speaks and the server can start transcribing
+// early.
 
 #include <WiFi.h> // For ESP32 Wi-Fi connectivity
-#include <HTTPClient.h> // For making HTTP requests
 #include <ArduinoJson.h> // For parsing JSON responses (install via Arduino IDE Library Manager)
+#include "micCapture.h" // I2S DMA capture into a ring of PCM blocks
+#include "chunkedUpload.h" // HTTP POST with a chunked body
+#include "voiceActivity.h" // Speech detection, pre-roll and silence trimming
+#include "imaAdpcm.h" // 4:1 audio compression for the upload
 
 // -------------- Wi-Fi Configuration --------------
 const char* ssid = "YOUR_WIFI_SSID";         // Replace with your Wi-Fi SSID
@@ -17,25 +26,27 @@ const char* serverAddress = "192.168.1.100"; // Example: Replace with your PC's
 const int serverPort = 5000;
 const char* serverPath = "/upload_audio";
 
-// Placeholder for your audio data.
-// In a real application, you would read audio samples from your microphone (e.g., ADC or I2S),
-// process them (e.g., resample, add WAV header), and put the byte data here.
-// For demonstration, this is a small dummy byte array.
-// YOU WILL NEED TO REPLACE THIS WITH ACTUAL AUDIO FILE BYTES (e.g., a short WAV file).
-// Example: If you have a 'sample.wav' file, you could convert it to a byte array
-// using Python or an online tool.
-const unsigned char audioData[] = {
-  // Dummy audio data - REPLACE THIS WITH YOUR ACTUAL AUDIO FILE BYTES
-  // This array should contain the raw bytes of your audio file (e.g., a WAV file).
-  // For a real scenario, you'd likely stream this from an SD card or generate it on the fly.
-  0x52, 0x49, 0x46, 0x46, 0x24, 0x00, 0x00, 0x00, 0x57, 0x41, 0x56, 0x45, 0x66, 0x6d, 0x74, 0x20,
-  0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x40, 0x1f, 0x00, 0x00, 0x80, 0x3e, 0x00, 0x00,
-  0x02, 0x00, 0x10, 0x00, 0x64, 0x61, 0x74, 0x61, 0x00, 0x00, 0x00, 0x00,
-  // Add more audio bytes here. This is a very small, invalid WAV header as an example.
-  // A real WAV file will be much larger.
-};
-const size_t audioDataSize = sizeof(audioData);
-const char* audioFileName = "recording.wav"; // Name of the file as seen by the server
+// -------------- Microphone Configuration --------------
+// I2S MEMS microphone such as the INMP441, L/R pin tied to GND (left channel)
+const int micBckPin = 26;   // SCK
+const int micWsPin = 25;    // WS
+const int micDataPin = 33;  // SD
+
+// The format is stated in the headers, speech2txtSVR.py decodes accordingly.
+// Set compressAudio to false for raw 16-bit little endian PCM (4x the airtime).
+const bool compressAudio = true;
+const char* pcmContentType = "audio/L16; rate=16000; channels=1";
+const char* adpcmContentType = "application/octet-stream";
+const char* adpcmHeaders = "X-Audio-Encoding: " IMA_ADPCM_ENCODING "\r\n"
+                           "X-Audio-Sample-Rate: 16000\r\n";
+
+MicCapture mic;
+VoiceGate voice;
+ChunkedUpload upload;
+ImaAdpcmEncoder encoder;
+uint8_t encodedBlock[IMA_ADPCM_BLOCK_BYTES(VOICE_BLOCK_SAMPLES)];
+char responseBody[512]; // server JSON reply
+bool utteranceEnded = false;
 
 // Function to connect to Wi-Fi
 void connectToWiFi() {
@@ -56,60 +67,63 @@ void connectToWiFi() {
   Serial.println(WiFi.localIP());
 }
 
-void setup() {
-  Serial.begin(115200); // Initialize serial communication
-  delay(1000); // Small delay for serial to initialize
-  connectToWiFi(); // Connect to Wi-Fi at startup
+// Speech started: open the upload; the gate then sends its pre-roll
+bool onSpeechStart(void *arg) {
+  Serial.println("\nSpeech detected, streaming to Flask server...");
+  encoder.reset();
+  bool opened = compressAudio ? upload.begin(serverAddress, serverPort, serverPath, adpcmContentType, adpcmHeaders)
+                              : upload.begin(serverAddress, serverPort, serverPath, pcmContentType);
+  if (!opened) {
+    Serial.println("Something went wrong, let me diagnose. Could not connect to the server.");
+    return false; // skip this utterance
+  }
+  return true;
 }
 
-void loop() {
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("Wi-Fi disconnected. Reconnecting...");
-    connectToWiFi(); // Reconnect if Wi-Fi drops
+// A failed write closes the upload, finish() then reports it
+void onSpeechAudio(const int16_t *pcm, size_t samples, void *arg) {
+  if (compressAudio) {
+    size_t length = encoder.encodeBlock(pcm, samples, encodedBlock);
+    upload.write(encodedBlock, length);
+  } else {
+    upload.write((const uint8_t *)pcm, samples * sizeof(int16_t));
   }
+}
 
-  // Delay before sending the next request (adjust as needed)
-  // For continuous microphone input, you'd trigger this based on audio buffer fullness
-  delay(5000);
-
-  Serial.println("\nAttempting to send audio to Flask server...");
-
-  HTTPClient http;
-  http.begin(serverAddress, serverPort, serverPath); // Specify your Flask server's IP and port
-
-  // Set headers for multipart/form-data
-  String boundary = "---011000010111000001101001"; // A random unique boundary string
-  http.addHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
-
-  // Construct the body of the POST request
-  String requestBody = "";
-  requestBody += "--" + boundary + "\r\n";
-  requestBody += "Content-Disposition: form-data; name=\"audio\"; filename=\"" + String(audioFileName) + "\"\r\n";
-  requestBody += "Content-Type: application/octet-stream\r\n"; // Or appropriate audio MIME type
-  requestBody += "\r\n";
-  // The actual audio data bytes will be inserted here.
+void onSpeechEnd(void *arg) {
+  utteranceEnded = true;
+}
 
-  String footer = "\r\n--" + boundary + "--\r\n";
+void setup() {
+  Serial.begin(115200); // Initialize serial communication
+  delay(1000); // Small delay for serial to initialize
+  connectToWiFi(); // Connect to Wi-Fi at startup
 
-  // Calculate total content length
-  int totalContentLength = requestBody.length() + audioDataSize + footer.length();
+  if (!mic.begin(micBckPin, micWsPin, micDataPin, MIC_SAMPLE_RATE)) {
+    Serial.println("I2S microphone setup failed.");
+  }
+  mic.setReader(xTaskGetCurrentTaskHandle()); // loop() is woken for every captured block
 
-  http.sendRequest("POST", (const uint8_t*)requestBody.c_str(), requestBody.length(),
-                   (const uint8_t*)audioData, audioDataSize,
-                   (const uint8_t*)footer.c_str(), footer.length());
+  voice.begin(MIC_SAMPLE_RATE);
+  voice.setHandlers(onSpeechStart, onSpeechAudio, onSpeechEnd, nullptr);
+  mic.start();
+  Serial.println("Listening...");
+}
 
-  int httpResponseCode = http.GET(); // Use GET to initiate the request after preparing body
+// Finishes the upload and prints the transcription
+void handleTranscription() {
+  Serial.printf("Sent %lu bytes of audio, %lu capture overruns\n", upload.getBytesSent(), mic.getOverruns());
+  int httpResponseCode = upload.finish(responseBody, sizeof(responseBody));
 
   // Check for HTTP response code
   if (httpResponseCode > 0) {
     Serial.printf("HTTP Response code: %d\n", httpResponseCode);
-    String payload = http.getString();
     Serial.println("Server Response:");
-    Serial.println(payload);
+    Serial.println(responseBody);
 
     // Parse JSON response
     StaticJsonDocument<256> doc; // Adjust size as per your expected JSON response
-    DeserializationError error = deserializeJson(doc, payload);
+    DeserializationError error = deserializeJson(doc, responseBody);
 
     if (error) {
       Serial.print(F("deserializeJson() failed: "));
@@ -131,8 +145,32 @@ void loop() {
   } else {
     Serial.printf("Error code: %d\n", httpResponseCode);
     Serial.println("Something went wrong, let me diagnose. Server timeout or connection error.");
-    Serial.println(http.errorToString(httpResponseCode)); // Print error description
+    upload.abort();
+  }
+}
+
+void loop() {
+  if (WiFi.status() != WL_CONNECTED) {
+    Serial.println("Wi-Fi disconnected. Reconnecting...");
+    connectToWiFi(); // Reconnect if Wi-Fi drops
+  }
+
+  // Every block goes through the voice gate; it only uploads while someone speaks
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)); // woken for every block
+  while (const MicBlock *block = mic.peek()) {
+    voice.process(block->pcm, block->samples);
+    mic.release();
   }
 
-  http.end(); // Free resources
+  if (utteranceEnded) {
+    utteranceEnded = false;
+    mic.stop(); // nobody listens while the reply is awaited
+    handleTranscription();
+    Serial.printf("Utterances: %lu, silence trimmed: %lu ms\n", voice.getUtterances(),
+                  voice.getTrimmedSamples() / (MIC_SAMPLE_RATE / 1000));
+    while (mic.isRecording()) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+    while (mic.peek()) mic.release(); // audio from before the reply
+    mic.start();
+    Serial.println("Listening...");
+  }
 }
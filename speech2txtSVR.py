@@ -1,4 +1,9 @@
 import os
+import sys
+import math
+import struct
+from array import array
+from concurrent.futures import ThreadPoolExecutor
 from flask import Flask, request, jsonify
 import speech_recognition as sr
 from pydub import AudioSegment
@@ -66,11 +71,210 @@ def transcribe_audio(audio_file_path):
             os.remove(temp_wav_path)
 
 
+# --- Streamed uploads ---
+# spc2txtespTEST.ino streams raw 16-bit little endian mono PCM ("audio/L16; rate=16000")
+# with chunked transfer encoding while it is still recording. The body is read as it
+# arrives and cut at speech pauses. Each finished segment goes to the recognizer in the
+# background, so most of the transcription is done by the time the last chunk arrives.
+STREAM_READ_BYTES = 4096
+SEGMENT_FRAME_MS = 20
+SEGMENT_PAUSE_MS = 400     # this much quiet after speech ends a segment
+SEGMENT_MIN_MS = 1500      # shorter segments wait for more speech, so words are not split
+SEGMENT_MAX_MS = 10000     # cut here even without a pause
+SEGMENT_MIN_RMS = 300      # quiet threshold floor, 16-bit scale
+
+transcribe_pool = ThreadPoolExecutor(max_workers=2)
+
+# --- IMA-ADPCM ---
+# "X-Audio-Encoding: ima-adpcm" uploads come in the block format of imaAdpcm.h:
+# [samples u16][predictor i16][step index u8][reserved u8], then one 4-bit code per sample,
+# low nibble first. Every block carries the decoder state, so each one decodes on its own.
+IMA_ADPCM_STEPS = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767]
+IMA_ADPCM_INDEX_STEP = [-1, -1, -1, -1, 2, 4, 6, 8]
+IMA_ADPCM_HEADER = struct.Struct('<HhBB')
+
+class ImaAdpcmDecoder:
+    """
+    Incremental decoder: feed() takes any slice of the upload and returns the PCM
+    (16-bit little endian) of the blocks completed so far.
+    """
+    def __init__(self):
+        self.pending = bytearray()
+
+    def feed(self, data):
+        self.pending += data
+        pcm = array('h')
+        while len(self.pending) >= IMA_ADPCM_HEADER.size:
+            samples, predictor, index, _ = IMA_ADPCM_HEADER.unpack_from(self.pending)
+            block_bytes = IMA_ADPCM_HEADER.size + (samples + 1) // 2
+            if len(self.pending) < block_bytes:
+                break
+            codes = self.pending[IMA_ADPCM_HEADER.size:block_bytes]
+            del self.pending[:block_bytes]
+            index = min(index, 88)
+            for i in range(samples):
+                code = (codes[i >> 1] >> ((i & 1) * 4)) & 0x0F
+                step = IMA_ADPCM_STEPS[index]
+                delta = step >> 3
+                if code & 4:
+                    delta += step
+                if code & 2:
+                    delta += step >> 1
+                if code & 1:
+                    delta += step >> 2
+                predictor = predictor - delta if code & 8 else predictor + delta
+                predictor = max(-32768, min(32767, predictor))
+                index = max(0, min(88, index + IMA_ADPCM_INDEX_STEP[code & 7]))
+                pcm.append(predictor)
+        if sys.byteorder == 'big':
+            pcm.byteswap()
+        return pcm.tobytes()
+
+def frame_rms(frame):
+    """
+    Root mean square level of a frame of 16-bit little endian samples.
+    """
+    samples = array('h')
+    samples.frombytes(frame)
+    if sys.byteorder == 'big':
+        samples.byteswap()
+    if not samples:
+        return 0.0
+    return math.sqrt(sum(s * s for s in samples) / len(samples))
+
+class PauseSegmenter:
+    """
+    Cuts a PCM stream into segments at pauses. The quiet threshold follows the noise
+    floor, which drops at once to a quieter frame and rises slowly.
+    """
+    def __init__(self, sample_rate):
+        self.frame_bytes = sample_rate * SEGMENT_FRAME_MS // 1000 * 2
+        self.bytes_per_ms = sample_rate * 2 / 1000.0
+        self.pending = bytearray()  # less than one frame
+        self.segment = bytearray()
+        self.quiet_ms = 0
+        self.voiced = False
+        self.noise_floor = None
+
+    def feed(self, data):
+        """
+        Adds received bytes and returns the segments that are now complete.
+        """
+        self.pending += data
+        segments = []
+        while len(self.pending) >= self.frame_bytes:
+            frame = bytes(self.pending[:self.frame_bytes])
+            del self.pending[:self.frame_bytes]
+            rms = frame_rms(frame)
+            if self.noise_floor is None or rms < self.noise_floor:
+                self.noise_floor = rms
+            quiet = rms < max(SEGMENT_MIN_RMS, 3 * self.noise_floor)
+            # Quiet frames pull the floor up quickly, speech only very slowly (~40 s)
+            self.noise_floor += (rms - self.noise_floor) * (0.05 if quiet else 0.0005)
+
+            self.segment += frame
+            if quiet:
+                self.quiet_ms += SEGMENT_FRAME_MS
+            else:
+                self.quiet_ms = 0
+                self.voiced = True
+            length_ms = len(self.segment) / self.bytes_per_ms
+            if (self.voiced and self.quiet_ms >= SEGMENT_PAUSE_MS and length_ms >= SEGMENT_MIN_MS) or \
+               length_ms >= SEGMENT_MAX_MS:
+                segment = self.take()
+                if segment:
+                    segments.append(segment)
+        return segments
+
+    def finish(self):
+        """
+        The last segment once the upload is complete, or None.
+        """
+        self.segment += self.pending[:len(self.pending) // 2 * 2]
+        self.pending = bytearray()
+        return self.take()
+
+    def take(self):
+        # Segments without any speech are dropped instead of sent to the recognizer
+        segment = bytes(self.segment) if self.voiced else None
+        self.segment = bytearray()
+        self.quiet_ms = 0
+        self.voiced = False
+        return segment
+
+def transcribe_pcm(pcm, sample_rate):
+    """
+    Transcribes raw 16-bit mono PCM. Same results as transcribe_audio().
+    """
+    recognizer = sr.Recognizer()
+    try:
+        text = recognizer.recognize_google(sr.AudioData(pcm, sample_rate, 2))
+        print(f"Segment transcribed: {text}")
+        return text, True
+    except sr.UnknownValueError:
+        return "Could not understand audio", False
+    except sr.RequestError as e:
+        print(f"Could not request results from Google Speech Recognition service; {e}")
+        return f"Recognition service error: {e}", False
+    except Exception as e:
+        print(f"An unexpected error occurred: {e}")
+        return f"An unexpected error occurred: {e}", False
+
+def upload_audio_stream():
+    """
+    Transcribes a streamed audio body segment by segment while it is still arriving.
+    The format is in the headers: X-Audio-Encoding (pcm_s16le or ima-adpcm) and
+    X-Audio-Sample-Rate, or an "audio/L16; rate=..." content type.
+    """
+    encoding = request.headers.get('X-Audio-Encoding', 'pcm_s16le').lower()
+    if encoding == 'ima-adpcm':
+        decode = ImaAdpcmDecoder().feed
+    elif encoding == 'pcm_s16le':
+        decode = bytes
+    else:
+        return jsonify({"success": False, "error": f"Unsupported audio encoding '{encoding}'"}), 415
+    try:
+        sample_rate = int(request.headers.get('X-Audio-Sample-Rate') or request.mimetype_params.get('rate', 16000))
+    except ValueError:
+        return jsonify({"success": False, "error": "Invalid sample rate"}), 400
+    segmenter = PauseSegmenter(sample_rate)
+    pending = []
+    received = 0
+    while True:
+        chunk = request.stream.read(STREAM_READ_BYTES)
+        if not chunk:
+            break
+        received += len(chunk)
+        for segment in segmenter.feed(decode(chunk)):
+            pending.append(transcribe_pool.submit(transcribe_pcm, segment, sample_rate))
+    segment = segmenter.finish()
+    if segment:
+        pending.append(transcribe_pool.submit(transcribe_pcm, segment, sample_rate))
+    print(f"Streamed audio ({encoding}): {received} bytes, {len(pending)} speech segments")
+
+    results = [future.result() for future in pending]
+    texts = [text for text, success in results if success]
+    if texts:
+        return jsonify({"success": True, "text": " ".join(texts)})
+    error = results[0][0] if results else "Could not understand audio"
+    return jsonify({"success": False, "error": error})
+
+
 @app.route('/upload_audio', methods=['POST'])
 def upload_audio():
     """
     Handles audio file uploads, transcribes them, and returns the text.
+    A raw PCM ("audio/L16") or ADPCM (X-Audio-Encoding) body is transcribed while it
+    streams in.
     """
+    if request.mimetype == 'audio/l16' or 'X-Audio-Encoding' in request.headers:
+        return upload_audio_stream()
+
     # Check if the POST request has the file part
     if 'audio' not in request.files:
         return jsonify({"success": False, "error": "No audio file part in the request"}), 400
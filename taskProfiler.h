@@ -0,0 +1,265 @@
+// taskProfiler.h - Stack, CPU and loop jitter telemetry for the FreeRTOS tasks in main.ino
+// Every task is registered with the stack size it was created with. sample() records the
+// stack high-water mark of each task and, if the FreeRTOS run-time counters are enabled, the
+// CPU share of each task and the load of each core.
+// Periodic loops also own a LoopJitter. mark() at the top of each iteration keeps a histogram
+// of how far the wake-up interval strayed from the nominal period. done() at the end of the
+// work adds the busy time, which gives a CPU figure even without the run-time counters, and
+// counts a deadline miss if the iteration finished later than its deadline after its release.
+// Reports go to any Print (e.g. Serial) or into a JSON buffer for the server.
+
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define PROFILER_MAX_TASKS 12
+#define PROFILER_MAX_SYSTEM_TASKS 32   // snapshot size for uxTaskGetSystemState()
+#define PROFILER_JITTER_BUCKETS 8
+#define PROFILER_CORES 2
+
+// Run-time counters need configGENERATE_RUN_TIME_STATS (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS),
+// which the stock Arduino-ESP32 build leaves off. The loop busy time works either way.
+#if defined(configGENERATE_RUN_TIME_STATS) && configGENERATE_RUN_TIME_STATS && \
+    defined(configUSE_TRACE_FACILITY) && configUSE_TRACE_FACILITY
+#define PROFILER_RUN_TIME_STATS 1
+#else
+#define PROFILER_RUN_TIME_STATS 0
+#endif
+
+// Upper bounds of the jitter buckets in us; the last bucket holds everything above
+static const uint32_t PROFILER_JITTER_LIMITS_US[PROFILER_JITTER_BUCKETS - 1] = {50, 100, 250, 500, 1000, 2500, 5000};
+
+class LoopJitter {
+public:
+    // begin(): Nominal period of the loop. Event driven loops use their expected rate.
+    // deadlineUs: time from release to the end of the work, 0 means the period.
+    void begin(uint32_t periodUs, uint32_t deadlineUs = 0) {
+        _periodUs = periodUs;
+        _deadlineUs = deadlineUs ? deadlineUs : periodUs;
+        reset();
+    }
+
+    // mark(): Call once per iteration, right after the loop wakes up
+    void mark() {
+        int64_t now = esp_timer_get_time();
+        if (_lastMarkUs != 0) {
+            uint32_t interval = (uint32_t)(now - _lastMarkUs);
+            uint32_t jitter = interval > _periodUs ? interval - _periodUs : _periodUs - interval;
+            uint8_t bucket = 0;
+            while (bucket < PROFILER_JITTER_BUCKETS - 1 && jitter > PROFILER_JITTER_LIMITS_US[bucket]) bucket++;
+            _buckets[bucket]++;
+            if (jitter > _worstUs) _worstUs = jitter;
+            _iterations++;
+        }
+        // A late wake-up counts against the deadline from when it was due
+        _releaseUs = (_lastMarkUs != 0 && now > _lastMarkUs + _periodUs) ? _lastMarkUs + _periodUs : now;
+        _lastMarkUs = now;
+    }
+
+    // done(): Optional, call when the iteration's work is finished
+    void done() {
+        if (_lastMarkUs == 0) return;
+        int64_t now = esp_timer_get_time();
+        _busyUs += (uint32_t)(now - _lastMarkUs);
+        uint32_t response = (uint32_t)(now - _releaseUs);
+        if (response > _worstResponseUs) _worstResponseUs = response;
+        if (response > _deadlineUs) _deadlineMisses++;
+    }
+
+    void reset() {
+        for (uint8_t i = 0; i < PROFILER_JITTER_BUCKETS; i++) _buckets[i] = 0;
+        _worstUs = 0;
+        _iterations = 0;
+        _busyUs = 0;
+        _worstResponseUs = 0;
+        _deadlineMisses = 0;
+    }
+
+    uint32_t getPeriodUs() { return _periodUs; }
+    uint32_t getDeadlineUs() { return _deadlineUs; }
+    uint32_t getWorstResponseUs() { return _worstResponseUs; }
+    uint32_t getDeadlineMisses() { return _deadlineMisses; }
+    uint32_t getWorstUs() { return _worstUs; }
+    uint32_t getIterations() { return _iterations; }
+    uint32_t getBucket(uint8_t i) { return _buckets[i]; }
+
+    // takeBusyUs(): Busy time since the previous call
+    uint32_t takeBusyUs() { uint32_t busy = _busyUs; _busyUs -= busy; return busy; }
+
+private:
+    uint32_t _periodUs = 0;
+    uint32_t _deadlineUs = 0;
+    int64_t _lastMarkUs = 0;
+    int64_t _releaseUs = 0;
+    volatile uint32_t _buckets[PROFILER_JITTER_BUCKETS] = {0};
+    volatile uint32_t _worstUs = 0;
+    volatile uint32_t _iterations = 0;
+    volatile uint32_t _busyUs = 0;
+    volatile uint32_t _worstResponseUs = 0;
+    volatile uint32_t _deadlineMisses = 0;
+};
+
+class TaskProfiler {
+public:
+    // add(): Registers a task. stackBytes is the depth it was created with (bytes on the ESP32).
+    bool add(const char *name, TaskHandle_t handle, uint32_t stackBytes, LoopJitter *loop = nullptr);
+
+    // sample(): Refreshes stack and CPU figures. CPU shares cover the time since the previous call.
+    void sample();
+
+    // printReport(): One line per task plus the core loads
+    void printReport(Print &out);
+
+    // toJson(): Report as a JSON object; returns its length, 0 if it did not fit
+    size_t toJson(char *buffer, size_t size);
+
+    // Load of a core in percent over the last sample period, -1 without run-time counters
+    int getCoreLoadPercent(uint8_t core) { return core < PROFILER_CORES ? _coreLoad[core] : -1; }
+
+private:
+    struct Entry {
+        const char *name;
+        TaskHandle_t handle;
+        uint32_t stackBytes;
+        LoopJitter *loop;
+        uint32_t stackFreeBytes;   // smallest free stack ever seen
+        int16_t cpuPermille;       // of one core, -1 if unknown
+#if PROFILER_RUN_TIME_STATS
+        uint32_t lastRunTime;
+#endif
+    };
+
+    Entry _tasks[PROFILER_MAX_TASKS];
+    uint8_t _count = 0;
+    int _coreLoad[PROFILER_CORES] = {-1, -1};
+    int64_t _lastSampleUs = 0;
+#if PROFILER_RUN_TIME_STATS
+    TaskStatus_t _status[PROFILER_MAX_SYSTEM_TASKS];
+    uint32_t _lastTotalRunTime = 0;
+    uint32_t _lastIdleRunTime[PROFILER_CORES] = {0, 0};
+#endif
+};
+
+// --- Implementation ---
+
+bool TaskProfiler::add(const char *name, TaskHandle_t handle, uint32_t stackBytes, LoopJitter *loop) {
+    if (_count >= PROFILER_MAX_TASKS || handle == NULL) return false;
+    Entry &entry = _tasks[_count++];
+    entry.name = name;
+    entry.handle = handle;
+    entry.stackBytes = stackBytes;
+    entry.loop = loop;
+    entry.stackFreeBytes = stackBytes;
+    entry.cpuPermille = -1;
+#if PROFILER_RUN_TIME_STATS
+    entry.lastRunTime = 0;
+#endif
+    return true;
+}
+
+void TaskProfiler::sample() {
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsedUs = _lastSampleUs ? (uint32_t)(now - _lastSampleUs) : 0;
+    _lastSampleUs = now;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        Entry &entry = _tasks[i];
+        entry.stackFreeBytes = uxTaskGetStackHighWaterMark(entry.handle);
+        // Busy time of the loop as a fallback; replaced by the run-time counter below if there is one
+        if (entry.loop) {
+            uint32_t busy = entry.loop->takeBusyUs();
+            entry.cpuPermille = elapsedUs ? (int16_t)min((uint64_t)1000, (uint64_t)busy * 1000 / elapsedUs) : -1;
+        }
+    }
+
+#if PROFILER_RUN_TIME_STATS
+    uint32_t totalRunTime = 0;
+    UBaseType_t n = uxTaskGetSystemState(_status, PROFILER_MAX_SYSTEM_TASKS, &totalRunTime);
+    if (n == 0) return; // more tasks than the snapshot holds
+    uint32_t totalDelta = totalRunTime - _lastTotalRunTime;
+    bool first = _lastTotalRunTime == 0;
+    _lastTotalRunTime = totalRunTime;
+
+    for (UBaseType_t s = 0; s < n; s++) {
+        const TaskStatus_t &status = _status[s];
+        // The idle tasks are called IDLE0 and IDLE1, their share is what the core had left
+        if (strncmp(status.pcTaskName, "IDLE", 4) == 0) {
+            uint8_t core = status.pcTaskName[4] == '1' ? 1 : 0;
+            uint32_t idleDelta = status.ulRunTimeCounter - _lastIdleRunTime[core];
+            _lastIdleRunTime[core] = status.ulRunTimeCounter;
+            if (!first && totalDelta) _coreLoad[core] = 100 - (int)min((uint64_t)100, (uint64_t)idleDelta * 100 / totalDelta);
+            continue;
+        }
+        for (uint8_t i = 0; i < _count; i++) {
+            Entry &entry = _tasks[i];
+            if (entry.handle != status.xHandle) continue;
+            uint32_t delta = status.ulRunTimeCounter - entry.lastRunTime;
+            entry.lastRunTime = status.ulRunTimeCounter;
+            if (!first && totalDelta) entry.cpuPermille = (int16_t)min((uint64_t)1000, (uint64_t)delta * 1000 / totalDelta);
+        }
+    }
+#endif
+}
+
+void TaskProfiler::printReport(Print &out) {
+    char line[192];
+    for (uint8_t i = 0; i < _count; i++) {
+        Entry &entry = _tasks[i];
+        int n = snprintf(line, sizeof(line), "Profiler: %-12s stack %5lu/%5lu B used", entry.name,
+                         (unsigned long)(entry.stackBytes - entry.stackFreeBytes), (unsigned long)entry.stackBytes);
+        if (entry.cpuPermille >= 0) {
+            n += snprintf(line + n, sizeof(line) - n, ", cpu %d.%d%%", entry.cpuPermille / 10, entry.cpuPermille % 10);
+        }
+        if (entry.loop && n < (int)sizeof(line)) {
+            LoopJitter &loop = *entry.loop;
+            n += snprintf(line + n, sizeof(line) - n, ", period %lu us, worst jitter %lu us, misses %lu, hist",
+                          (unsigned long)loop.getPeriodUs(), (unsigned long)loop.getWorstUs(),
+                          (unsigned long)loop.getDeadlineMisses());
+            for (uint8_t b = 0; b < PROFILER_JITTER_BUCKETS && n < (int)sizeof(line); b++) {
+                n += snprintf(line + n, sizeof(line) - n, " %lu", (unsigned long)loop.getBucket(b));
+            }
+        }
+        out.println(line);
+    }
+    snprintf(line, sizeof(line), "Profiler: core load %d%% / %d%%, free heap %lu B, min %lu B",
+             _coreLoad[0], _coreLoad[1], (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap());
+    out.println(line);
+}
+
+size_t TaskProfiler::toJson(char *buffer, size_t size) {
+    size_t n = snprintf(buffer, size, "{\"uptime_ms\":%lu,\"free_heap\":%lu,\"min_free_heap\":%lu,"
+                                      "\"core_load\":[%d,%d],\"jitter_limits_us\":[",
+                        (unsigned long)millis(), (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+                        _coreLoad[0], _coreLoad[1]);
+    for (uint8_t b = 0; b < PROFILER_JITTER_BUCKETS - 1 && n < size; b++) {
+        n += snprintf(buffer + n, size - n, b ? ",%lu" : "%lu", (unsigned long)PROFILER_JITTER_LIMITS_US[b]);
+    }
+    if (n < size) n += snprintf(buffer + n, size - n, "],\"tasks\":[");
+    for (uint8_t i = 0; i < _count && n < size; i++) {
+        Entry &entry = _tasks[i];
+        n += snprintf(buffer + n, size - n, "%s{\"name\":\"%s\",\"stack\":%lu,\"stack_free\":%lu,\"cpu_permille\":%d",
+                      i ? "," : "", entry.name, (unsigned long)entry.stackBytes,
+                      (unsigned long)entry.stackFreeBytes, entry.cpuPermille);
+        if (entry.loop && n < size) {
+            LoopJitter &loop = *entry.loop;
+            n += snprintf(buffer + n, size - n, ",\"period_us\":%lu,\"deadline_us\":%lu,\"iterations\":%lu,"
+                                                "\"jitter_worst_us\":%lu,\"response_worst_us\":%lu,\"deadline_misses\":%lu,\"jitter_hist\":[",
+                          (unsigned long)loop.getPeriodUs(), (unsigned long)loop.getDeadlineUs(),
+                          (unsigned long)loop.getIterations(), (unsigned long)loop.getWorstUs(),
+                          (unsigned long)loop.getWorstResponseUs(), (unsigned long)loop.getDeadlineMisses());
+            for (uint8_t b = 0; b < PROFILER_JITTER_BUCKETS && n < size; b++) {
+                n += snprintf(buffer + n, size - n, b ? ",%lu" : "%lu", (unsigned long)loop.getBucket(b));
+            }
+            if (n < size) n += snprintf(buffer + n, size - n, "]");
+        }
+        if (n < size) n += snprintf(buffer + n, size - n, "}");
+    }
+    if (n < size) n += snprintf(buffer + n, size - n, "]}");
+    return n < size ? n : 0;
+}
+
+#endif
@@ -0,0 +1,104 @@
+// taskSchedule.h - Declarative core and priority assignment for the FreeRTOS tasks
+// main.ino lists its tasks in one table: function, core, period, deadline and stack.
+// startSchedule() gives them deadline-monotonic priorities (shorter deadline, higher
+// priority; equal deadlines share a level) and creates them pinned to their cores.
+// The priority band sits below the ESP-IDF Wi-Fi and lwIP tasks (priority 18 and up on
+// core 0), so networking tasks in the table cannot starve the radio. If a LoopJitter is
+// attached, it is set up with the task's period and deadline and counts deadline misses.
+
+#ifndef TASK_SCHEDULE_H
+#define TASK_SCHEDULE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "taskProfiler.h"
+
+#define SCHEDULE_MAX_TASKS 12
+#define SCHEDULE_TOP_PRIORITY 8        // given to the shortest deadline
+#define SCHEDULE_BOTTOM_PRIORITY 2     // floor, leaves 1 to the Arduino loop task
+
+// Cores by role: networking next to the Wi-Fi stack, real-time work on the other core
+#define SCHEDULE_CORE_NETWORK 0
+#define SCHEDULE_CORE_CONTROL 1
+
+struct TaskSpec {
+    const char *name;
+    TaskFunction_t function;
+    uint8_t core;
+    uint32_t periodMs;        // nominal period; for event driven tasks the expected rate
+    uint32_t deadlineMs;      // release to end of work, 0 means the period
+    uint32_t stackBytes;
+    TaskHandle_t *handle;     // optional, receives the created task
+    LoopJitter *loop;         // optional, jitter and deadline tracking for the task's loop
+    UBaseType_t priority;     // filled in by startSchedule()
+};
+
+// startSchedule(): Assigns the priorities and creates every task in the table. Tasks are
+// registered with the profiler, if given. Returns false if a task could not be created;
+// the ones before it keep running.
+bool startSchedule(TaskSpec *specs, uint8_t count, TaskProfiler *profiler = nullptr);
+
+// printSchedule(): The table with the assigned priorities
+void printSchedule(const TaskSpec *specs, uint8_t count, Print &out);
+
+// --- Implementation ---
+
+static uint32_t scheduleDeadlineMs(const TaskSpec &spec) {
+    return spec.deadlineMs ? spec.deadlineMs : spec.periodMs;
+}
+
+bool startSchedule(TaskSpec *specs, uint8_t count, TaskProfiler *profiler) {
+    if (count > SCHEDULE_MAX_TASKS) return false;
+
+    // Deadline order, insertion sort over indices so the table itself keeps its layout
+    uint8_t order[SCHEDULE_MAX_TASKS];
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t j = i;
+        while (j > 0 && scheduleDeadlineMs(specs[order[j - 1]]) > scheduleDeadlineMs(specs[i])) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    UBaseType_t priority = SCHEDULE_TOP_PRIORITY;
+    for (uint8_t k = 0; k < count; k++) {
+        if (k > 0 && scheduleDeadlineMs(specs[order[k]]) > scheduleDeadlineMs(specs[order[k - 1]]) &&
+            priority > SCHEDULE_BOTTOM_PRIORITY) {
+            priority--;
+        }
+        specs[order[k]].priority = priority;
+    }
+
+    // Loops are set up before any task runs, so the first iterations are already measured right
+    for (uint8_t i = 0; i < count; i++) {
+        if (specs[i].loop) specs[i].loop->begin(specs[i].periodMs * 1000UL, scheduleDeadlineMs(specs[i]) * 1000UL);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        TaskSpec &spec = specs[i];
+        // The handle is written before the task can run, so the task may already use it
+        TaskHandle_t task = NULL;
+        TaskHandle_t *handle = spec.handle ? spec.handle : &task;
+        if (xTaskCreatePinnedToCore(spec.function, spec.name, spec.stackBytes, NULL,
+                                    spec.priority, handle, spec.core) != pdPASS) {
+            return false;
+        }
+        if (profiler) profiler->add(spec.name, *handle, spec.stackBytes, spec.loop);
+    }
+    return true;
+}
+
+void printSchedule(const TaskSpec *specs, uint8_t count, Print &out) {
+    char line[128];
+    for (uint8_t i = 0; i < count; i++) {
+        const TaskSpec &spec = specs[i];
+        snprintf(line, sizeof(line), "Schedule: %-12s core %u, priority %2u, period %5lu ms, deadline %5lu ms, stack %5lu B",
+                 spec.name, (unsigned)spec.core, (unsigned)spec.priority, (unsigned long)spec.periodMs,
+                 (unsigned long)scheduleDeadlineMs(spec), (unsigned long)spec.stackBytes);
+        out.println(line);
+    }
+}
+
+#endif
@@ -0,0 +1,148 @@
+// telemetryBatch.h - Batched, delta encoded sensor telemetry for the server link
+// IMU samples and sensor frames are packed into blocks of at most TELEMETRY_BLOCK_BYTES.
+// A block is handed to the sender when it is full or TELEMETRY_FLUSH_MS after its first
+// record, so the radio sends a few hundred bytes about once a second instead of one
+// message per sample, and can sleep in between.
+//
+// Block layout (all multi-byte header fields little endian):
+//   [version: u8][record count: u16][start time: u32, micros() of the first record]
+//   records...
+// Record:
+//   [tag: u8]             bit 0: TELEMETRY_RECORD_*, bits 1..7: IMU_EVENT_* (IMU records only)
+//   [time delta: varint]  us since the previous record, zigzag encoded
+//   IMU:    6 x varint    accel x/y/z, gyro x/y/z, each the zigzag delta to the previous IMU record
+//   Range:  2 x varint    distance mm, light level, zigzag deltas to the previous range record
+// Varints are LEB128: 7 bits per byte, low bits first, top bit set on all but the last byte.
+// Deltas start from zero in every block, so each block decodes on its own.
+// decode_telemetry_batch() in bgserver.py reads this format.
+
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <Arduino.h>
+#include "robotPipeline.h"
+
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_BLOCK_BYTES 512        // fits one link frame and a single TCP segment
+#define TELEMETRY_QUEUE_BLOCKS 4         // finished blocks waiting for the sender
+#define TELEMETRY_FLUSH_MS 1000
+#define TELEMETRY_HEADER_BYTES 7
+#define TELEMETRY_MAX_RECORD_BYTES (1 + 5 + 6 * 3) // tag, time delta, six 16-bit deltas
+
+#define TELEMETRY_RECORD_IMU 0
+#define TELEMETRY_RECORD_RANGE 1
+
+struct TelemetryBlock {
+    uint16_t length;                   // bytes used in data
+    uint16_t records;
+    uint8_t data[TELEMETRY_BLOCK_BYTES];
+};
+
+class TelemetryBatcher {
+public:
+    // Producer side, one task only
+    void addImu(const ImuFrame &frame);
+    void addSensors(const SensorFrame &frame);
+    // flushIfDue(): Hands over a partial block once it is TELEMETRY_FLUSH_MS old
+    void flushIfDue();
+    void flush();
+
+    // Consumer side, one other task: oldest finished block, or nullptr
+    const TelemetryBlock *peek() { return _blocks.peek(); }
+    void release() { _blocks.release(); }
+
+    // Raw size of the samples that were encoded in total, for the compression ratio
+    unsigned long getRawBytes() { return _rawBytes; }
+    unsigned long getEncodedBytes() { return _encodedBytes; }
+    unsigned long getDroppedRecords() { return _droppedRecords; } // all blocks were waiting for the sender
+
+private:
+    SpscRing<TelemetryBlock, TELEMETRY_QUEUE_BLOCKS> _blocks;
+    TelemetryBlock *_open = nullptr;   // block being filled, not yet committed
+    unsigned long _openedMs = 0;
+    uint32_t _lastTimeUs = 0;
+    int16_t _lastImu[6] = {0};
+    uint16_t _lastDistance = 0;
+    uint16_t _lastLight = 0;
+    unsigned long _rawBytes = 0;
+    unsigned long _encodedBytes = 0;
+    unsigned long _droppedRecords = 0;
+
+    bool beginRecord(uint8_t tag, uint32_t timestampUs);
+    void putVarint(uint32_t value);
+    void putSigned(int32_t value) { putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31)); } // zigzag
+};
+
+// --- Implementation ---
+
+void TelemetryBatcher::addImu(const ImuFrame &frame) {
+    if (!beginRecord(TELEMETRY_RECORD_IMU | (frame.events << 1), frame.timestampUs)) return;
+    for (uint8_t i = 0; i < 3; i++) {
+        putSigned((int32_t)frame.accel[i] - _lastImu[i]);
+        _lastImu[i] = frame.accel[i];
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        putSigned((int32_t)frame.gyro[i] - _lastImu[3 + i]);
+        _lastImu[3 + i] = frame.gyro[i];
+    }
+    _rawBytes += 4 + 12 + 1; // timestamp, six int16, events
+}
+
+void TelemetryBatcher::addSensors(const SensorFrame &frame) {
+    if (!beginRecord(TELEMETRY_RECORD_RANGE, frame.timestampUs)) return;
+    putSigned((int32_t)frame.distanceMm - _lastDistance);
+    putSigned((int32_t)frame.lightLevel - _lastLight);
+    _lastDistance = frame.distanceMm;
+    _lastLight = frame.lightLevel;
+    _rawBytes += 4 + 2 + 2; // timestamp, distance, light
+}
+
+void TelemetryBatcher::flushIfDue() {
+    if (_open && millis() - _openedMs >= TELEMETRY_FLUSH_MS) flush();
+}
+
+void TelemetryBatcher::flush() {
+    if (!_open) return;
+    _open->data[1] = _open->records & 0xFF;
+    _open->data[2] = _open->records >> 8;
+    _encodedBytes += _open->length;
+    _open = nullptr;
+    _blocks.commit();
+}
+
+// Makes room for one more record, opening a new block if needed, and writes tag and time
+bool TelemetryBatcher::beginRecord(uint8_t tag, uint32_t timestampUs) {
+    if (_open && _open->length + TELEMETRY_MAX_RECORD_BYTES > TELEMETRY_BLOCK_BYTES) flush();
+    if (!_open) {
+        _open = _blocks.acquire();
+        if (!_open) {
+            _droppedRecords++;
+            return false;
+        }
+        _openedMs = millis();
+        _open->records = 0;
+        _open->data[0] = TELEMETRY_VERSION;
+        for (uint8_t i = 0; i < 4; i++) _open->data[3 + i] = (timestampUs >> (8 * i)) & 0xFF;
+        _open->length = TELEMETRY_HEADER_BYTES;
+        // Fresh delta state, every block stands on its own
+        _lastTimeUs = timestampUs;
+        for (uint8_t i = 0; i < 6; i++) _lastImu[i] = 0;
+        _lastDistance = 0;
+        _lastLight = 0;
+    }
+    _open->data[_open->length++] = tag;
+    putSigned((int32_t)(timestampUs - _lastTimeUs));
+    _lastTimeUs = timestampUs;
+    _open->records++;
+    return true;
+}
+
+void TelemetryBatcher::putVarint(uint32_t value) {
+    while (value >= 0x80) {
+        _open->data[_open->length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    _open->data[_open->length++] = (uint8_t)value;
+}
+
+#endif
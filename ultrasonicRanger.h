@@ -0,0 +1,196 @@
+// ultrasonicRanger.h - Non-blocking HC-SR04 ranging for the ESP32
+// A periodic esp_timer fires the 10 us trigger pulse, and a GPIO interrupt on the echo pin
+// timestamps both echo edges with esp_timer_get_time(). No task ever waits for an echo:
+// the newest distance is published from the interrupt and can be read at any time, and an
+// optional task is notified on every new measurement.
+
+#ifndef ULTRASONIC_RANGER_H
+#define ULTRASONIC_RANGER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Distance reported when no echo came back within range
+#define ULTRASONIC_NO_ECHO 0xFFFF
+
+// 30 Hz or more is the target; at 40 Hz each ping may take up to 25 ms, enough for ~4 m
+#define ULTRASONIC_DEFAULT_RATE_HZ 40
+#define ULTRASONIC_TRIGGER_US 10         // trigger pulse width required by the HC-SR04
+#define ULTRASONIC_MAX_RANGE_MM 4000     // echoes longer than this count as no echo
+#define ULTRASONIC_US_PER_MM_X1000 5831  // round trip at 343 m/s: 2 / 0.343 us per mm, times 1000
+
+class UltrasonicRanger {
+public:
+    // begin(): Starts ranging at rateHz. The ping period must cover the echo of the
+    // maximum range, so rates above 1e6 / (ULTRASONIC_MAX_RANGE_MM * 5.831 us) are capped.
+    // Returns false if the echo pin has no interrupt or the timer could not be created.
+    bool begin(int trigPin, int echoPin, uint16_t rateHz = ULTRASONIC_DEFAULT_RATE_HZ);
+    void end();
+
+    // setNotifyTask(): Task woken with a task notification after every measurement,
+    // including the ones that timed out. The notification is sent from interrupt context.
+    void setNotifyTask(TaskHandle_t task) { _notifyTask = task; }
+
+    // getDistanceMm(): Newest distance in mm, ULTRASONIC_NO_ECHO if the last ping saw nothing.
+    uint16_t getDistanceMm() { return (uint16_t)(_latest & 0xFFFF); }
+
+    // read(): Newest distance and whether it is new since the previous read() call.
+    // Distance and sequence are published as one 32-bit word, so they are always consistent.
+    bool read(uint16_t &distanceMm);
+
+    // getTimestampUs(): esp_timer time of the falling echo edge (or the timeout) of the newest value.
+    int64_t getTimestampUs() { return _latestTimeUs; }
+
+    // getLatest(): Newest distance and its timestamp as one consistent pair. The two getters
+    // above are separate reads, an echo in between would pair a new distance with an old time.
+    void getLatest(uint16_t &distanceMm, int64_t &timestampUs);
+
+    unsigned long getMeasurementCount() { return _latest >> 16; } // wraps at 65536
+    unsigned long getTimeoutCount() { return _timeoutCount; }
+
+    // Called from the timer and the echo interrupt. Not for application use.
+    void handleTrigger();
+    void handleEcho();
+
+private:
+    int _trigPin = -1;
+    int _echoPin = -1;
+    uint32_t _periodUs = 0;
+    uint32_t _maxEchoUs = 0;
+    esp_timer_handle_t _timer = nullptr;
+    TaskHandle_t _notifyTask = nullptr;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED; // the timer task and the echo ISR share the state below
+
+    volatile bool _waitingForEcho = false; // trigger sent, falling edge not seen yet
+    volatile int64_t _echoStartUs = 0;     // time of the rising edge, 0 before it arrived
+    volatile uint32_t _latest = ULTRASONIC_NO_ECHO; // sequence << 16 | distance in mm
+    volatile int64_t _latestTimeUs = 0;
+    volatile unsigned long _timeoutCount = 0;
+    uint16_t _lastReadSequence = 0;
+
+    void storeLatest(uint16_t distanceMm, int64_t timeUs);
+};
+
+// --- Implementation ---
+
+static void IRAM_ATTR ultrasonicEchoISR(void *arg) {
+    ((UltrasonicRanger *)arg)->handleEcho();
+}
+
+static void ultrasonicTriggerCallback(void *arg) {
+    ((UltrasonicRanger *)arg)->handleTrigger();
+}
+
+bool UltrasonicRanger::begin(int trigPin, int echoPin, uint16_t rateHz) {
+    if (digitalPinToInterrupt(echoPin) < 0 || rateHz == 0) return false;
+    _trigPin = trigPin;
+    _echoPin = echoPin;
+    _maxEchoUs = (uint32_t)ULTRASONIC_MAX_RANGE_MM * ULTRASONIC_US_PER_MM_X1000 / 1000;
+    _periodUs = 1000000UL / rateHz;
+    if (_periodUs < _maxEchoUs + 1000) _periodUs = _maxEchoUs + 1000; // leave the echo time to settle
+
+    pinMode(_trigPin, OUTPUT);
+    digitalWrite(_trigPin, LOW);
+    pinMode(_echoPin, INPUT);
+    attachInterruptArg(digitalPinToInterrupt(_echoPin), ultrasonicEchoISR, this, CHANGE);
+
+    esp_timer_create_args_t args = {};
+    args.callback = ultrasonicTriggerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "ultrasonic";
+    if (esp_timer_create(&args, &_timer) != ESP_OK) {
+        detachInterrupt(digitalPinToInterrupt(_echoPin));
+        return false;
+    }
+    return esp_timer_start_periodic(_timer, _periodUs) == ESP_OK;
+}
+
+void UltrasonicRanger::end() {
+    if (_timer) {
+        esp_timer_stop(_timer);
+        esp_timer_delete(_timer);
+        _timer = nullptr;
+    }
+    if (_echoPin >= 0) detachInterrupt(digitalPinToInterrupt(_echoPin));
+}
+
+bool UltrasonicRanger::read(uint16_t &distanceMm) {
+    uint32_t latest = _latest;
+    distanceMm = (uint16_t)(latest & 0xFFFF);
+    uint16_t sequence = (uint16_t)(latest >> 16);
+    bool fresh = sequence != _lastReadSequence;
+    _lastReadSequence = sequence;
+    return fresh;
+}
+
+void UltrasonicRanger::getLatest(uint16_t &distanceMm, int64_t &timestampUs) {
+    portENTER_CRITICAL(&_mux);
+    distanceMm = (uint16_t)(_latest & 0xFFFF);
+    timestampUs = _latestTimeUs;
+    portEXIT_CRITICAL(&_mux);
+}
+
+// Runs in the esp_timer task once per period. A ping still waiting for its echo at this point
+// got none within range, so it is reported as ULTRASONIC_NO_ECHO before the next one starts.
+void UltrasonicRanger::handleTrigger() {
+    bool timedOut = false;
+    portENTER_CRITICAL(&_mux);
+    if (_waitingForEcho) {
+        _waitingForEcho = false;
+        _timeoutCount++;
+        storeLatest(ULTRASONIC_NO_ECHO, esp_timer_get_time());
+        timedOut = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+    if (timedOut && _notifyTask) xTaskNotifyGive(_notifyTask);
+
+    if (digitalRead(_echoPin) == HIGH) return; // echo line stuck from an earlier ping, skip this one
+    portENTER_CRITICAL(&_mux);
+    _echoStartUs = 0;
+    _waitingForEcho = true;
+    portEXIT_CRITICAL(&_mux);
+    digitalWrite(_trigPin, HIGH);
+    delayMicroseconds(ULTRASONIC_TRIGGER_US);
+    digitalWrite(_trigPin, LOW);
+}
+
+void IRAM_ATTR UltrasonicRanger::handleEcho() {
+    int64_t now = esp_timer_get_time();
+    bool high = digitalRead(_echoPin) == HIGH;
+    bool measured = false;
+    portENTER_CRITICAL_ISR(&_mux);
+    if (_waitingForEcho) {
+        if (high) {
+            _echoStartUs = now;
+        } else if (_echoStartUs != 0) { // ignore a falling edge without a rising one
+            uint32_t widthUs = (uint32_t)(now - _echoStartUs);
+            _waitingForEcho = false;
+            if (widthUs > _maxEchoUs) {
+                _timeoutCount++;
+                storeLatest(ULTRASONIC_NO_ECHO, now);
+            } else {
+                storeLatest((uint16_t)(widthUs * 1000UL / ULTRASONIC_US_PER_MM_X1000), now);
+            }
+            measured = true;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&_mux);
+
+    if (measured && _notifyTask) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(_notifyTask, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+// Caller holds _mux
+void IRAM_ATTR UltrasonicRanger::storeLatest(uint16_t distanceMm, int64_t timeUs) {
+    uint16_t sequence = (uint16_t)(_latest >> 16) + 1;
+    _latestTimeUs = timeUs;
+    _latest = ((uint32_t)sequence << 16) | distanceMm;
+}
+
+#endif
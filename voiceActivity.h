@@ -0,0 +1,264 @@
+// voiceActivity.h - Voice activity detection and speech gating for the microphone blocks
+// VoiceActivityDetector classifies each block of 16-bit PCM as speech or not from two
+// integer features:
+//  - energy: mean square of the DC-free samples
+//  - zero-crossing rate: sign changes per sample, scaled to 0..255
+// A block is speech when its energy is VAD_ENERGY_FACTOR times the noise floor. During an
+// utterance, a weaker block with a high zero-crossing rate (fricatives like "s", "f") also
+// counts. The noise floor follows the quiet blocks. An utterance starts after
+// VAD_ONSET_BLOCKS speech blocks, so a click is ignored. It ends after VAD_HANGOVER_MS
+// without speech.
+//
+// VoiceGate turns that into an upload: it calls onStart when speech begins, hands audio to
+// onAudio and calls onEnd when the utterance is over. Blocks are held back in a small ring:
+//  - before the onset, the last VOICE_HOLD_BLOCKS blocks are kept as pre-roll, so the first
+//    syllable is not cut off;
+//  - during the hangover, the quiet blocks wait there and are only sent if speech resumes.
+//    Trailing silence is trimmed this way.
+// Nothing is sent while nobody speaks.
+
+#ifndef VOICE_ACTIVITY_H
+#define VOICE_ACTIVITY_H
+
+#include <Arduino.h>
+
+#define VAD_ENERGY_FACTOR 4            // speech: 6 dB over the noise floor
+#define VAD_WEAK_ENERGY_FACTOR 2       // fricatives, only inside an utterance
+#define VAD_ZCR_FRICATIVE 64           // zero-crossing rate (of 255) of a fricative
+#define VAD_MIN_ENERGY 400             // mean square floor, ~-38 dBFS; keeps a silent room quiet
+#define VAD_ONSET_BLOCKS 2
+#define VAD_HANGOVER_MS 400
+
+#define VOICE_BLOCK_SAMPLES 512        // largest block process() accepts
+#define VOICE_HOLD_BLOCKS 8            // pre-roll and trailing silence held back
+#define VOICE_MAX_UTTERANCE_MS 15000   // an utterance is cut here
+
+enum VadEvent {
+    VAD_SILENCE,    // no utterance
+    VAD_ONSET,      // this block starts an utterance
+    VAD_SPEECH,     // speech inside an utterance
+    VAD_HANGOVER,   // quiet, but the utterance may continue
+    VAD_END         // the hangover ran out with this block
+};
+
+class VoiceActivityDetector {
+public:
+    void begin(uint32_t sampleRate) { _sampleRate = sampleRate; reset(); }
+    void reset();
+
+    // process(): Classifies one block; blocks should all have about the same length
+    VadEvent process(const int16_t *pcm, size_t samples);
+    // forceEnd(): Ends the utterance now, e.g. at a length limit
+    void forceEnd() { _inUtterance = false; _speechRun = 0; }
+
+    bool inUtterance() { return _inUtterance; }
+    uint32_t getEnergy() { return _energy; }          // of the last block
+    uint8_t getZeroCrossingRate() { return _zcr; }
+    uint32_t getNoiseFloor() { return _noiseFloor; }
+
+    // measure(): The two features of a block
+    static void measure(const int16_t *pcm, size_t samples, uint32_t &energy, uint8_t &zcr);
+
+private:
+    uint32_t _sampleRate = 16000;
+    uint32_t _noiseFloor = 0;          // 0 until the first block
+    uint32_t _energy = 0;
+    uint8_t _zcr = 0;
+    bool _inUtterance = false;
+    uint8_t _speechRun = 0;            // consecutive speech blocks before the onset
+    uint32_t _quietMs = 0;             // since the last speech block in an utterance
+};
+
+typedef bool (*VoiceStartHandler)(void *arg);   // return false to skip this utterance
+typedef void (*VoiceAudioHandler)(const int16_t *pcm, size_t samples, void *arg);
+typedef void (*VoiceEndHandler)(void *arg);
+
+class VoiceGate {
+public:
+    void begin(uint32_t sampleRate) { _sampleRate = sampleRate; _vad.begin(sampleRate); _holdCount = 0; _sending = false; }
+    void setHandlers(VoiceStartHandler onStart, VoiceAudioHandler onAudio, VoiceEndHandler onEnd, void *arg);
+
+    // process(): Feeds one block of at most VOICE_BLOCK_SAMPLES samples
+    void process(const int16_t *pcm, size_t samples);
+
+    VoiceActivityDetector &detector() { return _vad; }
+    unsigned long getUtterances() { return _utterances; }
+    unsigned long getSentSamples() { return _sentSamples; }
+    unsigned long getTrimmedSamples() { return _trimmedSamples; }   // silence never sent
+
+private:
+    VoiceActivityDetector _vad;
+    uint32_t _sampleRate = 16000;
+    VoiceStartHandler _onStart = nullptr;
+    VoiceAudioHandler _onAudio = nullptr;
+    VoiceEndHandler _onEnd = nullptr;
+    void *_arg = nullptr;
+
+    int16_t _hold[VOICE_HOLD_BLOCKS][VOICE_BLOCK_SAMPLES];
+    uint16_t _holdSamples[VOICE_HOLD_BLOCKS];
+    uint8_t _holdFirst = 0;
+    uint8_t _holdCount = 0;
+    bool _active = false;              // inside an utterance
+    bool _sending = false;             // onStart accepted it
+    uint32_t _utteranceSamples = 0;
+
+    unsigned long _utterances = 0;
+    unsigned long _sentSamples = 0;
+    unsigned long _trimmedSamples = 0;
+
+    void hold(const int16_t *pcm, size_t samples);
+    void sendHeld();
+    void dropHeld();
+    void send(const int16_t *pcm, size_t samples);
+    void end();
+};
+
+// --- Implementation ---
+
+void VoiceActivityDetector::reset() {
+    _noiseFloor = 0;
+    _inUtterance = false;
+    _speechRun = 0;
+    _quietMs = 0;
+}
+
+void VoiceActivityDetector::measure(const int16_t *pcm, size_t samples, uint32_t &energy, uint8_t &zcr) {
+    if (samples == 0) {
+        energy = 0;
+        zcr = 0;
+        return;
+    }
+    // The mic has a DC offset, remove it first or it dominates both features
+    int32_t sum = 0;
+    for (size_t i = 0; i < samples; i++) sum += pcm[i];
+    int32_t mean = sum / (int32_t)samples;
+
+    uint64_t squares = 0;
+    uint32_t crossings = 0;
+    int32_t previous = pcm[0] - mean;
+    for (size_t i = 0; i < samples; i++) {
+        int32_t x = pcm[i] - mean;
+        squares += (uint64_t)((int64_t)x * x);
+        crossings += (x ^ previous) < 0;
+        previous = x;
+    }
+    energy = (uint32_t)(squares / samples);
+    zcr = (uint8_t)min<uint32_t>(255, crossings * 255 / samples);
+}
+
+VadEvent VoiceActivityDetector::process(const int16_t *pcm, size_t samples) {
+    measure(pcm, samples, _energy, _zcr);
+    if (_noiseFloor == 0) _noiseFloor = max<uint32_t>(_energy, 1);
+
+    uint32_t floor = max<uint32_t>(_noiseFloor, VAD_MIN_ENERGY / VAD_ENERGY_FACTOR);
+    bool strong = _energy > floor * VAD_ENERGY_FACTOR;
+    bool weak = _energy > floor * VAD_WEAK_ENERGY_FACTOR && _zcr >= VAD_ZCR_FRICATIVE;
+    uint32_t blockMs = samples * 1000UL / _sampleRate;
+
+    if (!strong && !(_inUtterance && weak)) {
+        // Quiet: the floor falls fast and rises slowly, so speech cannot lift it much
+        if (_energy < _noiseFloor) _noiseFloor -= (_noiseFloor - _energy) / 4;
+        else _noiseFloor += (_energy - _noiseFloor) / 32;
+    }
+
+    if (!_inUtterance) {
+        _speechRun = strong ? _speechRun + 1 : 0;
+        if (_speechRun < VAD_ONSET_BLOCKS) return VAD_SILENCE;
+        _inUtterance = true;
+        _speechRun = 0;
+        _quietMs = 0;
+        return VAD_ONSET;
+    }
+    if (strong || weak) {
+        _quietMs = 0;
+        return VAD_SPEECH;
+    }
+    _quietMs += blockMs;
+    if (_quietMs < VAD_HANGOVER_MS) return VAD_HANGOVER;
+    _inUtterance = false;
+    return VAD_END;
+}
+
+void VoiceGate::setHandlers(VoiceStartHandler onStart, VoiceAudioHandler onAudio, VoiceEndHandler onEnd, void *arg) {
+    _onStart = onStart;
+    _onAudio = onAudio;
+    _onEnd = onEnd;
+    _arg = arg;
+}
+
+void VoiceGate::process(const int16_t *pcm, size_t samples) {
+    if (samples > VOICE_BLOCK_SAMPLES) samples = VOICE_BLOCK_SAMPLES;
+    switch (_vad.process(pcm, samples)) {
+    case VAD_SILENCE:
+        hold(pcm, samples); // pre-roll
+        break;
+    case VAD_ONSET:
+        _active = true;
+        _utteranceSamples = 0;
+        _utterances++;
+        _sending = !_onStart || _onStart(_arg);
+        sendHeld(); // pre-roll first; the onset blocks themselves are in it
+        send(pcm, samples);
+        break;
+    case VAD_SPEECH:
+        sendHeld(); // the pause was part of the speech after all
+        send(pcm, samples);
+        break;
+    case VAD_HANGOVER:
+        hold(pcm, samples);
+        break;
+    case VAD_END:
+        dropHeld(); // trailing silence
+        _trimmedSamples += samples;
+        end();
+        return;
+    }
+    if (_active && _utteranceSamples >= (uint32_t)VOICE_MAX_UTTERANCE_MS * (_sampleRate / 1000)) {
+        _vad.forceEnd();
+        sendHeld();
+        end();
+    }
+}
+
+// Appends to the hold ring; when it is full, the oldest block is sent (inside an utterance)
+// or dropped (pre-roll)
+void VoiceGate::hold(const int16_t *pcm, size_t samples) {
+    if (_holdCount == VOICE_HOLD_BLOCKS) {
+        if (_active) send(_hold[_holdFirst], _holdSamples[_holdFirst]);
+        else _trimmedSamples += _holdSamples[_holdFirst];
+        _holdFirst = (_holdFirst + 1) % VOICE_HOLD_BLOCKS;
+        _holdCount--;
+    }
+    uint8_t slot = (_holdFirst + _holdCount) % VOICE_HOLD_BLOCKS;
+    memcpy(_hold[slot], pcm, samples * sizeof(int16_t));
+    _holdSamples[slot] = samples;
+    _holdCount++;
+}
+
+void VoiceGate::sendHeld() {
+    while (_holdCount) {
+        send(_hold[_holdFirst], _holdSamples[_holdFirst]);
+        _holdFirst = (_holdFirst + 1) % VOICE_HOLD_BLOCKS;
+        _holdCount--;
+    }
+}
+
+void VoiceGate::dropHeld() {
+    for (uint8_t i = 0; i < _holdCount; i++) _trimmedSamples += _holdSamples[(_holdFirst + i) % VOICE_HOLD_BLOCKS];
+    _holdCount = 0;
+}
+
+void VoiceGate::send(const int16_t *pcm, size_t samples) {
+    _utteranceSamples += samples;
+    if (!_sending) return;
+    _sentSamples += samples;
+    if (_onAudio) _onAudio(pcm, samples, _arg);
+}
+
+void VoiceGate::end() {
+    if (_sending && _onEnd) _onEnd(_arg);
+    _active = false;
+    _sending = false;
+}
+
+#endif
@@ -1,33 +1,58 @@
+// wifi.h - Stand-alone motion alert sketch: MPU-6050 events to WhatsApp via CallMeBot
+// Messages are only sent for real events (shake, freefall), coalesced and rate limited by
+// NotificationService in its own task; loop() keeps sampling the IMU and never waits on
+// the network. main.ino uses the same service for the robot itself.
 #include <WiFi.h>
-#include <HTTPClient.h>
+#include "gyrosEncode.h"
+#include "notificationService.h"
 
 const char* ssid = "yourSSID";
 const char* password = "yourPassword";
-String phoneNumber = "yourPhoneNumber";
-String apiKey = "yourApiKey";
+const char* phoneNumber = "yourPhoneNumber";
+const char* apiKey = "yourApiKey";
+// Root CA of api.callmebot.com. The alert URL carries the API key, so the server must be
+// verified. You MUST replace this with the actual root CA certificate of the server.
+const char* rootCa = R"EOF(
+-----BEGIN CERTIFICATE-----
+... (root CA certificate of api.callmebot.com) ...
+-----END CERTIFICATE-----
+)EOF";
 
-void setup() {
-Serial.begin(115200);
-WiFi.begin(ssid, password);
-while (WiFi.status() != WL_CONNECTED) {
-delay(1000);
-Serial.println("Connecting to WiFi...");
+AemoMotion imu;
+NotificationService notifier;
+
+void notificationTask(void *arg) {
+  notifier.run();
 }
-Serial.println("Connected!");
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(1000);
+    Serial.println("Connecting to WiFi...");
+  }
+  Serial.println("Connected!");
+
+  if (!imu.beginCalibrated()) Serial.println("MPU-6050 not found!");
+  if (!notifier.begin(phoneNumber, apiKey, rootCa)) Serial.println("No root CA, alerts are disabled!");
+  // TLS needs a large stack; next to the Wi-Fi stack on core 0
+  xTaskCreatePinnedToCore(notificationTask, "Notify", 10000, NULL, 2, NULL, 0);
 }
 
 void loop() {
-if (WiFi.status() == WL_CONNECTED) {
-HTTPClient http;
-String url = "https://api.callmebot.com/whatsapp.php?phone=" + phoneNumber + "&text=Motion+Detected!&apikey=" + apiKey;
-http.begin(url);
-int httpCode = http.GET();
-if (httpCode == 200) {
-Serial.println("Message sent!");
-} else {
-Serial.println("Error: " + String(httpCode));
-}
-http.end();
-}
-delay(60000); // Check every minute
+  if (imu.update()) {
+    uint32_t events = 0;
+    if (imu.detectShake()) events |= NOTIFY_EVENT_SHAKE;
+    if (imu.isFreefalling()) events |= NOTIFY_EVENT_FREEFALL;
+    notifier.post(events);
+  }
+
+  static unsigned long lastReport = 0;
+  if (millis() - lastReport >= 60000) {
+    lastReport = millis();
+    Serial.printf("Alerts: %lu sent, %lu throttled, %lu failed\n",
+                  notifier.getSentCount(), notifier.getThrottledCount(), notifier.getFailedCount());
+  }
+  delay(8); // ~125 Hz, the IMU sample rate
 }